@@ -16,6 +16,24 @@ EXPORT void init_LagrangeHalfCPolynomial(LagrangeHalfCPolynomial *obj,
 //(equivalent of the C++ destructor)
 EXPORT void destroy_LagrangeHalfCPolynomial(LagrangeHalfCPolynomial *obj);
 
+/**
+ * initializes obj on the N doubles of coefs, which it does not own: obj must
+ * not be destroyed, and coefs must outlive it (the coefficients are in the
+ * layout of the fft processor, see LagrangeHalfCPolynomial_layout)
+ */
+EXPORT void init_LagrangeHalfCPolynomial_view(LagrangeHalfCPolynomial *obj,
+                                              const int32_t N, double *coefs);
+
+/** the N doubles that hold the coefficients of p */
+EXPORT const double *
+LagrangeHalfCPolynomial_coefs(const LagrangeHalfCPolynomial *p);
+
+/**
+ * name of the memory layout of the coefficients: the FFT-domain data can only
+ * be exchanged between builds with the same layout
+ */
+EXPORT const char *LagrangeHalfCPolynomial_layout();
+
 /**
  * FFT functions
  */
@@ -26,6 +44,31 @@ EXPORT void TorusPolynomial_ifft(LagrangeHalfCPolynomial *result,
 EXPORT void TorusPolynomial_fft(TorusPolynomial *result,
                                 const LagrangeHalfCPolynomial *p);
 
+/**
+ * results[j] = ifft(p[j]) for j < count, the count transforms being
+ * interleaved when the fft processor has a batched kernel
+ */
+EXPORT void IntPolynomial_ifft_batch(LagrangeHalfCPolynomial *results,
+                                     const IntPolynomial *p,
+                                     const int32_t count);
+/**
+ * results[j] = fft(p[j]) for j < count
+ * (p is used as scratch memory: its content is lost)
+ */
+EXPORT void TorusPolynomial_fft_batch(TorusPolynomial *results,
+                                      LagrangeHalfCPolynomial *p,
+                                      const int32_t count);
+
+/**
+ * results[j] = ifft of the j-th gadget digit of p, for j < l: the digit
+ * ((p + offset) >> (32-(j+1).Bgbit) mod Bg) - Bg/2, in [-Bg/2, Bg/2[
+ * (fused decomposition and transform: p is left untouched)
+ */
+EXPORT void TorusPolynomial_decompH_ifft(LagrangeHalfCPolynomial *results,
+                                         const TorusPolynomial *p,
+                                         const int32_t l, const int32_t Bgbit,
+                                         const uint32_t offset);
+
 // MISC OPERATIONS
 /** sets to zero */
 EXPORT void LagrangeHalfCPolynomialClear(LagrangeHalfCPolynomial *result);
@@ -76,4 +119,20 @@ EXPORT void LagrangeHalfCPolynomialSubMul(LagrangeHalfCPolynomial *accum,
                                           const LagrangeHalfCPolynomial *a,
                                           const LagrangeHalfCPolynomial *b);
 
+/**
+ * single precision copy of p: the N doubles of LagrangeHalfCPolynomial_coefs,
+ * rounded to floats (not available with the exact ntt processor)
+ */
+EXPORT void LagrangeHalfCPolynomial_toFloat32(float *result,
+                                              const LagrangeHalfCPolynomial *p);
+
+/**
+ * termwise multiplication and addTo in Lagrange space, where b is a single
+ * precision copy (see LagrangeHalfCPolynomial_toFloat32), widened to double
+ * in the kernel
+ */
+EXPORT void LagrangeHalfCPolynomialAddMulFloat32(LagrangeHalfCPolynomial *accum,
+                                                 const LagrangeHalfCPolynomial *a,
+                                                 const float *b);
+
 #endif // LAGRANGEHALFC_ARITHMETIC_H
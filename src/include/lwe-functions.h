@@ -30,6 +30,12 @@ EXPORT void lweSparseKeyGen(LweKey *result, int32_t hw);
  */
 EXPORT void lweSymEncrypt(LweSample *result, Torus32 message, double alpha,
                           const LweKey *key);
+/**
+ * Same as lweSymEncrypt, with the mask tfhe_seededUniformTorus32(seed, row)
+ */
+EXPORT void lweSymEncryptSeeded(LweSample *result, Torus32 message,
+                                double alpha, const LweKey *key,
+                                const TfheMaskSeed *seed, uint64_t row);
 /*
  * This function encrypts a message by using key and a given noise value
  */
@@ -37,6 +43,16 @@ EXPORT void lweSymEncryptWithExternalNoise(LweSample *result, Torus32 message,
                                            double noise, double alpha,
                                            const LweKey *key);
 
+/*
+ * Same as lweSymEncryptWithExternalNoise, with the mask
+ * tfhe_seededUniformTorus32(seed, row): the sample can be stored as its b only
+ */
+EXPORT void lweSymEncryptSeededWithExternalNoise(LweSample *result,
+                                                 Torus32 message, double noise,
+                                                 double alpha, const LweKey *key,
+                                                 const TfheMaskSeed *seed,
+                                                 uint64_t row);
+
 /**
  * This function computes the phase of sample by using key : phi = b - a.s
  */
@@ -90,6 +106,14 @@ EXPORT void lweCreateKeySwitchKey_old(LweKeySwitchKey *result,
                                       const LweKey *out_key);
 EXPORT void lweCreateKeySwitchKey(LweKeySwitchKey *result, const LweKey *in_key,
                                   const LweKey *out_key);
+/**
+ * same as lweCreateKeySwitchKey, but the masks are expanded from a new
+ * random result->seed (the element of index p=(i.t+j).base+h is seeded by
+ * row p), so that the key can be exported in compressed form
+ */
+EXPORT void lweCreateSeededKeySwitchKey(LweKeySwitchKey *result,
+                                        const LweKey *in_key,
+                                        const LweKey *out_key);
 
 /**
  * applies keySwitching
@@ -99,4 +123,13 @@ EXPORT void lweKeySwitch(LweSample *result, const LweKeySwitchKey *ks,
 
 EXPORT void lweSparseKeySwitch(LweSample *result, const LweKeySwitchKey *ks,
                                const LweSample *sample);
+
+/**
+ * lweSparseKeySwitch of the nbSamples samples into results, in one pass over
+ * the key when it is flattened (see lweFlattenKeySwitchKey)
+ */
+EXPORT void lweSparseKeySwitchBatch(LweSample *results,
+                                    const LweKeySwitchKey *ks,
+                                    const LweSample *samples,
+                                    const int32_t nbSamples);
 #endif // Lwe_FUNCTIONS_H
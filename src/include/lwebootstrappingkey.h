@@ -14,6 +14,7 @@ struct LweBootstrappingKey{
     const LweParams* extract_params; ///< params after extraction: key: s' 
     TGswSample* bk; ///< the bootstrapping key (s->s")
     LweKeySwitchKey* ks; ///< the keyswitch key (s'->s)
+    TfheMaskSeed seed; ///< if not null, the masks of bk are expanded from it (see tfhe_createSeededLweBootstrappingKey)
 
 
 #ifdef __cplusplus
@@ -40,6 +41,9 @@ struct LweBootstrappingKeyFFT {
     const LweParams* extract_params; ///< params after extraction: key: s' 
     const TGswSampleFFT* bkFFT; ///< the bootstrapping key (s->s")
     const LweKeySwitchKey* ks; ///< the keyswitch key (s'->s)
+    const LweRotatedKeyFFT* rotated; ///< optional cache of pre-rotated elements of bkFFT (sparse bootstrapping), or 0
+    int32_t recompose_accum; ///< if not 0, the sparse blind rotations add the accumulator in the FFT domain (see tfhe_setAccumRecompositionFFT)
+    int32_t mapped; ///< if not 0, bkFFT is a view on a mapped file (see new_tfheGateBootstrappingCloudKeySet_mapFile)
 
 
 #ifdef __cplusplus
@@ -59,6 +63,95 @@ struct LweBootstrappingKeyFFT {
 };
 
 
+/**
+ * Cache of pre-rotated elements of a bootstrapping key, for the sparse
+ * bootstrapping: the products (X^a-1)*BK_i are computed lazily in the FFT
+ * domain, for the pairs (element i, rotation a) that the blind rotations
+ * meet at least twice, and kept within a memory budget. The hoisted external
+ * product then only does one product-sum for a cached pair.
+ * Each product costs one TGswSampleFFT (96KB for the default sparse
+ * parameters), and the rotations of random inputs are uniform over 2N
+ * values: the cache pays off when the same inputs (or the same masks) are
+ * bootstrapped again, not on fresh ciphertexts. When the budget is full, a
+ * product that is not in use and has not been hit recently is evicted
+ * (CLOCK policy). The cache is shared by all the threads of the key.
+ */
+struct LweRotatedKeyFFT {
+    const TGswParams* bk_params; ///< params of the Gsw elems in bkFFT
+    const TGswSampleFFT* bkFFT; ///< the key whose elements are rotated
+    const int32_t n; ///< number of elements of bkFFT
+    const int32_t capacity; ///< number of cached products
+    TGswSampleFFT* slots; ///< the capacity cached products
+    struct LweRotatedKeyCache* cache; ///< index, hotness and pins of the slots (internal)
+
+
+#ifdef __cplusplus
+   LweRotatedKeyFFT(const TGswParams* bk_params,
+    const TGswSampleFFT* bkFFT,
+    const int32_t n,
+    const int32_t capacity,
+    TGswSampleFFT* slots,
+    struct LweRotatedKeyCache* cache);
+    ~LweRotatedKeyFFT();
+    LweRotatedKeyFFT(const LweRotatedKeyFFT&) = delete;
+    void operator=(const LweRotatedKeyFFT&) = delete;
+
+#endif
+
+
+};
+
+
+/**
+ * Scratch space of the bootstrapping, to be used by one thread at a time.
+ * It is allocated once from the parameters, and owns all the buffers of the
+ * (sparse) bootstrapping pipeline, so that a gate does no heap allocation.
+ * The blind rotations take it as a parameter instead of keeping hidden
+ * statics, so that several threads can bootstrap with the same key, each
+ * with its own workspace (see tfhe_threadBootstrappingWorkspace).
+ */
+struct LweBootstrappingWorkspace {
+    const int32_t N; ///< degree of the accumulator polynomials
+    const int32_t k; ///< number of mask polynomials of the accumulator
+    const int32_t l; ///< decomposition length of the bootstrapping key
+    const int32_t Bgbit; ///< log2 of the decomposition base of the bootstrapping key
+    TLweSample* temp; ///< second accumulator of the blind rotation
+    LagrangeHalfCPolynomial* xaim1; ///< X^a-1 in the FFT domain
+    const LagrangeHalfCPolynomial* xaim1_table; ///< optional table of all the X^a-1 (shared, not owned), or 0
+    LagrangeHalfCPolynomial* decaFFT; ///< decomposed accumulator, in the fft domain ((k+1)l polynomials)
+    LagrangeHalfCPolynomial* gadget; ///< the l constants 1/Bg^(j+1) of the decomposition (fft)
+    TLweSampleFFT* tmpa; ///< sum of the external products (fft)
+    TLweSampleFFT* tmpb; ///< external product of one key element (fft)
+    TorusPolynomial* testvect; ///< test vector of the bootstrapping
+    TorusPolynomial* testvectbis; ///< rotated test vector
+    TLweSample* acc; ///< accumulator of the blind rotation
+    const int32_t nmax; ///< coefficients of the input buffers (bara, gate_temp, batch_bara): max(n, kN)
+    int32_t* bara; ///< modulus-switched mask of the input (nmax coefficients)
+    const LweRotatedKeyFFT* rotated; ///< pre-rotated key cache of the current bootstrapping, or 0
+    int32_t recompose_accum; ///< recompose_accum of the key of the current bootstrapping
+    struct TFheBootstrapTeam* team; ///< team sharing the blind rotations of the thread (see tfhe_useBootstrapTeam), or 0
+    LweSample* u; ///< bootstrapped sample before the keyswitch
+    LweSample* gate_temp[4]; ///< temporaries of the gates (nmax coefficients)
+    int32_t batch_capacity; ///< number of samples of the batch buffers (see tfhe_reserveBatchWorkspace)
+    TLweSample* batch_temp; ///< second accumulators of the batch blind rotation
+    TLweSample* batch_acc; ///< accumulators of the batch bootstrapping
+    int32_t* batch_bara; ///< modulus-switched masks of the batch (nmax coefficients per sample)
+    LweSample* batch_u; ///< bootstrapped samples of the batch before the keyswitch
+
+
+#ifdef __cplusplus
+   // n: the dimension of the input samples, if it exceeds kN
+   LweBootstrappingWorkspace(const TGswParams* bk_params, int32_t n = 0);
+    ~LweBootstrappingWorkspace();
+    LweBootstrappingWorkspace(const LweBootstrappingWorkspace&) = delete;
+    void operator=(const LweBootstrappingWorkspace&) = delete;
+
+#endif
+
+
+};
+
+
 //allocate memory space for a LweBootstrappingKey
 EXPORT LweBootstrappingKey* alloc_LweBootstrappingKey();
 EXPORT LweBootstrappingKey* alloc_LweBootstrappingKey_array(int32_t nbelts);
@@ -115,4 +208,147 @@ EXPORT LweBootstrappingKeyFFT* new_LweBootstrappingKeyFFT_array(int32_t nbelts,
 EXPORT void delete_LweBootstrappingKeyFFT(LweBootstrappingKeyFFT* obj);
 EXPORT void delete_LweBootstrappingKeyFFT_array(int32_t nbelts, LweBootstrappingKeyFFT* obj);
 
+//allocate memory space for a LweRotatedKeyFFT
+EXPORT LweRotatedKeyFFT* alloc_LweRotatedKeyFFT();
+
+//free memory space for a LweRotatedKeyFFT
+EXPORT void free_LweRotatedKeyFFT(LweRotatedKeyFFT* ptr);
+
+//initialize the LweRotatedKeyFFT structure: an empty cache of as many
+//products as fit in max_bytes
+//(equivalent of the C++ constructor)
+EXPORT void init_LweRotatedKeyFFT(LweRotatedKeyFFT* obj, const LweBootstrappingKeyFFT* bk, const int64_t max_bytes);
+
+//destroys the LweRotatedKeyFFT structure
+//(equivalent of the C++ destructor)
+EXPORT void destroy_LweRotatedKeyFFT(LweRotatedKeyFFT* obj);
+
+//allocates and initialize the LweRotatedKeyFFT structure
+//(equivalent of the C++ new)
+EXPORT LweRotatedKeyFFT* new_LweRotatedKeyFFT(const LweBootstrappingKeyFFT* bk, const int64_t max_bytes);
+
+//destroys and frees the LweRotatedKeyFFT structure
+//(equivalent of the C++ delete)
+EXPORT void delete_LweRotatedKeyFFT(LweRotatedKeyFFT* obj);
+
+/**
+ * the sparse bootstrappings with bk use (and fill) the cache rotated
+ * (which must have been built from bk), or none if rotated is 0.
+ * rotated must be deleted after bk stops using it.
+ */
+EXPORT void tfhe_setRotatedKeyFFT(LweBootstrappingKeyFFT* bk, const LweRotatedKeyFFT* rotated);
+
+/**
+ * (X^a-1)*bkFFT[i] if it is cached, or 0. A cached product stays valid until
+ * it is released (tfhe_releaseRotatedKeyFFT). A miss counts towards the
+ * admission of the pair: at the second miss, the product is computed and
+ * returned, unless no slot can be evicted or another thread is admitting.
+ */
+EXPORT const TGswSampleFFT* tfhe_acquireRotatedKeyFFT(const LweRotatedKeyFFT* rotated, const int32_t i, const int32_t a);
+
+/** releases a product returned by tfhe_acquireRotatedKeyFFT */
+EXPORT void tfhe_releaseRotatedKeyFFT(const LweRotatedKeyFFT* rotated, const TGswSampleFFT* product);
+
+/** number of hits and misses of tfhe_acquireRotatedKeyFFT since the creation of rotated */
+EXPORT void tfhe_rotatedKeyFFTStats(const LweRotatedKeyFFT* rotated, int64_t* nb_hits, int64_t* nb_misses);
+
+/**
+ * if enable is not 0, the sparse blind rotations with bk add the accumulator
+ * back in the FFT domain, recomposed from its decomposition (see
+ * tGswFFTExternMulToTLweHoistingAddTo). This spares a copy and an addition
+ * of the accumulator per block, but each block then also adds the rounding
+ * of the decomposition (up to 1/2Bg^l per coefficient) to the accumulator.
+ * By default (0), the addition is exact, in the coefficient domain.
+ */
+EXPORT void tfhe_setAccumRecompositionFFT(LweBootstrappingKeyFFT* bk, int32_t enable);
+
+/** flattens the keyswitch key of bk (see lweFlattenKeySwitchKey) */
+EXPORT void tfhe_flattenKeySwitchKeyFFT(LweBootstrappingKeyFFT* bk);
+
+/**
+ * stores the FFT bootstrapping key in single precision (see
+ * tLweFFTToFloat32): it takes half the memory and half the bandwidth of the
+ * blind rotation, the products being widened to double in the kernel.
+ * Not available with the ntt processor nor for a mapped key; the key can
+ * then no longer be pre-rotated (tfhe_setRotatedKeyFFT) nor exported in
+ * mapped form.
+ *
+ * Noise: the rounding is relative to the Lagrange values of the key, whose
+ * uniform masks make them about sqrt(N) times larger than a torus
+ * coefficient. Each product of a digit polynomial by a key polynomial adds
+ * a variance of at most about N.Bg^2.2^-48 to the phase (2^-24 for N=1024,
+ * Bg=2^7), and a bootstrapping does n.(k+1).l of them. This dominates the
+ * output noise. The expected output stdev (bound) is:
+ * - default gate parameters (n=630, l=3): 0.0032 -> 0.0154, failure rate
+ *   per gate <= 2^-26.8 (measured: 0.0126, 2^-38);
+ * - sparse gate parameters (n=687, l=3): 0.0034 -> 0.0160, failure rate
+ *   per gate about 2^-24.8 (measured: 0.0160, the hoisted rotation
+ *   reaching the bound).
+ * A failure rate of 2^-25 per gate is unusable for large circuits: 10^6
+ * gates then fail with probability 3%. With the sparse parameters, keep
+ * the double precision key for anything but small circuits.
+ */
+EXPORT void tfhe_bootstrappingKeyFFTToFloat32(LweBootstrappingKeyFFT* bk);
+
+//allocate memory space for a LweBootstrappingWorkspace
+EXPORT LweBootstrappingWorkspace* alloc_LweBootstrappingWorkspace();
+EXPORT LweBootstrappingWorkspace* alloc_LweBootstrappingWorkspace_array(int32_t nbelts);
+
+//free memory space for a LweBootstrappingWorkspace
+EXPORT void free_LweBootstrappingWorkspace(LweBootstrappingWorkspace* ptr);
+EXPORT void free_LweBootstrappingWorkspace_array(int32_t nbelts, LweBootstrappingWorkspace* ptr);
+
+//initialize the LweBootstrappingWorkspace structure
+//(equivalent of the C++ constructor)
+EXPORT void init_LweBootstrappingWorkspace(LweBootstrappingWorkspace* obj, const TGswParams* bk_params);
+EXPORT void init_LweBootstrappingWorkspace_array(int32_t nbelts, LweBootstrappingWorkspace* obj, const TGswParams* bk_params);
+
+//destroys the LweBootstrappingWorkspace structure
+//(equivalent of the C++ destructor)
+EXPORT void destroy_LweBootstrappingWorkspace(LweBootstrappingWorkspace* obj);
+EXPORT void destroy_LweBootstrappingWorkspace_array(int32_t nbelts, LweBootstrappingWorkspace* obj);
+
+//allocates and initialize the LweBootstrappingWorkspace structure
+//(equivalent of the C++ new)
+EXPORT LweBootstrappingWorkspace* new_LweBootstrappingWorkspace(const TGswParams* bk_params);
+EXPORT LweBootstrappingWorkspace* new_LweBootstrappingWorkspace_array(int32_t nbelts, const TGswParams* bk_params);
+
+//destroys and frees the LweBootstrappingWorkspace structure
+//(equivalent of the C++ delete)
+EXPORT void delete_LweBootstrappingWorkspace(LweBootstrappingWorkspace* obj);
+EXPORT void delete_LweBootstrappingWorkspace_array(int32_t nbelts, LweBootstrappingWorkspace* obj);
+
+/**
+ * grows the batch buffers of ws to at least nbSamples samples (never
+ * shrinks them): the batch bootstrappings then do no heap allocation for
+ * batches up to the largest one met by the workspace. accum_params must
+ * have the dimensions of ws. Growing the buffers invalidates them: they
+ * must not be in use by the caller.
+ */
+EXPORT void tfhe_reserveBatchWorkspace(LweBootstrappingWorkspace* ws, const int32_t nbSamples, const TLweParams* accum_params);
+
+/**
+ * workspace of the calling thread, for keys with the parameters bk_params
+ * and input samples of dimension n (0 if the caller does not use the input
+ * buffers). The thread keeps one workspace per dimensions (N, k, l, Bgbit)
+ * and input capacity, created on the first call that needs it: it stays
+ * valid, and is returned again for these dimensions and any n <= nmax,
+ * until the thread exits.
+ */
+EXPORT LweBootstrappingWorkspace* tfhe_threadBootstrappingWorkspace(const TGswParams* bk_params, const int32_t n);
+
+/**
+ * table of the 2N polynomials X^a-1 (a=0..2N-1) in the FFT domain.
+ * It costs 2N*N doubles (16MB for N=1024), is built on the first call for
+ * this N, and is shared read-only by all the threads until the program exits.
+ */
+EXPORT const LagrangeHalfCPolynomial* tfhe_xaiMinusOneTable(const int32_t N);
+
+/**
+ * if use is 1, the thread workspaces read X^a-1 from tfhe_xaiMinusOneTable
+ * instead of recomputing it for each key element (trades memory for the
+ * gathers of LagrangeHalfCPolynomialSetXaiMinusOne). Default is 0.
+ */
+EXPORT void tfhe_useXaiMinusOneTables(const int32_t use);
+
 #endif
@@ -18,6 +18,9 @@ struct LweKeySwitchKey {
     LweSample** ks1_raw;// de taille nl  pointe vers un tableau ks0_raw dont les cases sont espaceés de base positions
     LweSample*** ks; ///< the keyswitch elements: a n.l.base matrix
     // de taille n pointe vers ks1 un tableau dont les cases sont espaceés de ell positions
+    Torus32* ks_flat; ///< if not null, the masks of all the elements: a 64-byte aligned n.l.base.flat_stride array
+    int32_t flat_stride; ///< row length of ks_flat: out_params->n rounded up to a multiple of 16
+    TfheMaskSeed seed; ///< if not null, the mask of the element p is tfhe_seededUniformTorus32(seed, p) (see lweCreateSeededKeySwitchKey)
 
 #ifdef __cplusplus
     LweKeySwitchKey(int32_t n, int32_t t, int32_t basebit, const LweParams* out_params, LweSample* ks0_raw);
@@ -27,6 +30,28 @@ struct LweKeySwitchKey {
 #endif
 };
 
+/**
+ * moves the masks of all the keyswitch elements into ks_flat: one contiguous
+ * cache-aligned array, zero-padded to flat_stride coefficients per element.
+ * The LweSamples of ks stay valid (their a point into ks_flat), and the
+ * keyswitches then accumulate the rows of ks_flat with SIMD adds.
+ */
+EXPORT void lweFlattenKeySwitchKey(LweKeySwitchKey* ks);
+
+/** same as lweKeySwitchTranslate_fromArray, on a flattened key */
+EXPORT void lweKeySwitchTranslate_fromFlat(LweSample* result, const LweKeySwitchKey* ks, const Torus32* ai);
+
+/** same as lweSparseKeySwitchTranslate_fromArray, on a flattened key */
+EXPORT void lweSparseKeySwitchTranslate_fromFlat(LweSample* result, const LweKeySwitchKey* ks, const Torus32* ai);
+
+/**
+ * lweSparseKeySwitchTranslate_fromFlat of the nbSamples masks samples[s].a
+ * into results[s]: the key is streamed once per batch of samples instead of
+ * once per sample (the digits of the batch are extracted together)
+ */
+EXPORT void lweSparseKeySwitchTranslateBatch_fromFlat(LweSample* results, const LweKeySwitchKey* ks,
+                                                      const LweSample* samples, const int32_t nbSamples);
+
 //allocate memory space for a LweKeySwitchKey
 EXPORT LweKeySwitchKey* alloc_LweKeySwitchKey();
 EXPORT LweKeySwitchKey* alloc_LweKeySwitchKey_array(int32_t nbelts);
@@ -7,9 +7,14 @@
 #include "tfhe_core.h"
 
 #ifdef __cplusplus
+#include <functional>
 #include <random>
-extern std::default_random_engine generator;
-extern std::uniform_int_distribution<Torus32> uniformTorus32_distrib;
+/*
+ * each thread has its own generator: the first one keeps the default seed,
+ * the ones of the other threads are seeded from std::random_device
+ */
+extern thread_local std::default_random_engine generator;
+extern thread_local std::uniform_int_distribution<Torus32> uniformTorus32_distrib;
 static const int64_t _two31 = INT64_C(1) << 31; // 2^31
 static const int64_t _two32 = INT64_C(1) << 32; // 2^32
 static const double _two32_double = _two32;
@@ -22,6 +27,46 @@ static const double _two31_double = _two31;
  */ 
 EXPORT Torus32 gaussian32(Torus32 message, double sigma);
 
+/**
+ * fills result with n uniform Torus32, expanded deterministically from
+ * (seed, row): the masks of the seeded keys are regenerated from it instead
+ * of being stored. This is the ChaCha20 keystream of the key seed, with the
+ * nonce row: each row expands on its own.
+ */
+EXPORT void tfhe_seededUniformTorus32(Torus32 *result, const int32_t n,
+                                      const TfheMaskSeed *seed, const uint64_t row);
+
+/**
+ * a new random (non-zero) seed for tfhe_seededUniformTorus32, drawn from
+ * the entropy source of the system (std::random_device)
+ */
+EXPORT TfheMaskSeed tfhe_newMaskSeed();
+
+/** 1 if the seed is all zero (no seed), 0 otherwise */
+EXPORT int32_t tfhe_isNullMaskSeed(const TfheMaskSeed *seed);
+
+/**
+ * number of threads that generate and convert the keys (0 = one per
+ * hardware thread, which is the default; 1 = no helper thread). The keys
+ * generated from a given seed do not depend on it.
+ */
+EXPORT void tfhe_setKeyGenerationThreads(const int32_t nb_threads);
+
+#ifdef __cplusplus
+/**
+ * runs job(begin, end) on consecutive chunks of [0, nbelts[, shared between
+ * the key generation threads (the caller included). The chunks do not
+ * depend on the number of threads. If seed_generators, the generator of the
+ * thread is seeded before each chunk from draws of the generator of the
+ * caller, one per chunk: the random streams of the chunks are independent,
+ * and the result is reproducible for a given seed of the caller, whatever
+ * the number of threads.
+ */
+void tfhe_keyGenerationParallelFor(const int32_t nbelts,
+                                   const bool seed_generators,
+                                   const std::function<void(int32_t, int32_t)> &job);
+#endif
+
 /** conversion from double to Torus32 */
 EXPORT Torus32 dtot32(double d);
 /** conversion from Torus32 to double */
@@ -23,13 +23,20 @@
 
 #include "tfhe_gate_bootstrapping_functions.h"
 
+#include "tfhe_gate_executor.h"
+
+#include "tfhe_bootstrap_team.h"
+
 #include "tfhe_io.h"
 
 ///////////////////////////////////////////////////
 //  TFHE bootstrapping internal functions
 //////////////////////////////////////////////////
 
-/** sets the seed of the random number generator to the given values */
+/**
+ * sets the seed of the random number generator of the calling thread to the
+ * given values (each thread has its own generator)
+ */
 EXPORT void tfhe_random_generator_setSeed(uint32_t *values, int32_t size);
 
 EXPORT void tfhe_blindRotate(TLweSample *accum, const TGswSample *bk,
@@ -48,6 +55,15 @@ EXPORT void tfhe_bootstrap(LweSample *result, const LweBootstrappingKey *bk,
 EXPORT void tfhe_createLweBootstrappingKey(LweBootstrappingKey *bk,
                                            const LweKey *key_in,
                                            const TGswKey *rgsw_key);
+/**
+ * same as tfhe_createLweBootstrappingKey, but all the masks (of bk and of
+ * the keyswitch key) are expanded from random seeds: the key can then be
+ * exported in compressed form (see
+ * export_tfheGateBootstrappingCloudKeySet_compressed_toFile)
+ */
+EXPORT void tfhe_createSeededLweBootstrappingKey(LweBootstrappingKey *bk,
+                                                 const LweKey *key_in,
+                                                 const TGswKey *rgsw_key);
 
 EXPORT void tfhe_blindRotate_FFT(TLweSample *accum, const TGswSampleFFT *bk,
                                  const int32_t *bara, const int32_t n,
@@ -70,12 +86,13 @@ EXPORT void tfhe_sparseBlindRotate_FFT(TLweSample *accum,
                                        const int32_t *bara, const int32_t n,
                                        const int32_t hw,
                                        const TLweParams *params,
-                                       const TGswParams *bk_params);
+                                       const TGswParams *bk_params,
+                                       LweBootstrappingWorkspace *ws);
 
 EXPORT void tfhe_sparseBlindRotateAndExtract_FFT(
     LweSample *result, const TorusPolynomial *v, const TGswSampleFFT *bk,
     const int32_t barb, const int32_t *bara, const int32_t n, const int32_t hw,
-    const TGswParams *bk_params);
+    const TGswParams *bk_params, LweBootstrappingWorkspace *ws);
 
 EXPORT void tfhe_sparseBootstrap_woKS_FFT(LweSample *result, const int32_t hw,
                                           const LweBootstrappingKeyFFT *bk,
@@ -84,4 +101,105 @@ EXPORT void tfhe_sparseBootstrap_FFT(LweSample *result, const int32_t hw,
                                      const LweBootstrappingKeyFFT *bk,
                                      Torus32 mu, const LweSample *x);
 
+/*
+ * Programmable sparse bootstrapping: the test vector is given by the caller
+ * instead of the constant [mu,...,mu] of the sign function. The coefficient
+ * j of testvect is the output for the phases near j/2N, and its opposite
+ * for the phases near 1/2+j/2N.
+ */
+EXPORT void tfhe_sparseProgrammableBootstrap_woKS_FFT(
+    LweSample *result, const int32_t hw, const LweBootstrappingKeyFFT *bk,
+    const TorusPolynomial *testvect, const LweSample *x);
+EXPORT void tfhe_sparseProgrammableBootstrap_FFT(
+    LweSample *result, const int32_t hw, const LweBootstrappingKeyFFT *bk,
+    const TorusPolynomial *testvect, const LweSample *x);
+
+/**
+ * the test vector of the lookup table m -> outputs[m] on the messages
+ * m in [0,msize[ encoded as modSwitchToTorus32(m, 2*msize): the phases of
+ * the inputs must stay in [-1/(4.msize), 1/2-1/(4.msize)[ (one bit of
+ * padding, and half the gap between two messages for the noise)
+ */
+EXPORT void tfhe_lutTestVector(TorusPolynomial *testvect,
+                               const Torus32 *outputs, const int32_t msize);
+
+/**
+ * bootstraps x = LWE(modSwitchToTorus32(m, 2*msize)) into
+ * LWE(modSwitchToTorus32(table[m], 2*msize)), for any table of msize
+ * entries in [0,msize[: a function of log2(msize) bits in one bootstrapping
+ */
+EXPORT void tfhe_sparseLutBootstrap_FFT(LweSample *result, const int32_t hw,
+                                        const LweBootstrappingKeyFFT *bk,
+                                        const int32_t *table,
+                                        const int32_t msize,
+                                        const LweSample *x);
+
+/*
+ * Multi-value sparse bootstrapping: several outputs from one blind rotation.
+ * The test vector of the output i is [mu,...,mu].factors[i] mod X^N+1, so
+ * that the blind rotation of [mu,...,mu] is shared, and the noise of each
+ * output is the noise of the rotation times the norm of its factor.
+ */
+EXPORT void tfhe_sparseMultiValueBootstrap_woKS_FFT(
+    LweSample *results, const int32_t hw, const LweBootstrappingKeyFFT *bk,
+    Torus32 mu, const IntPolynomial *factors, const int32_t nbOutputs,
+    const LweSample *x);
+EXPORT void tfhe_sparseMultiValueBootstrap_FFT(
+    LweSample *results, const int32_t hw, const LweBootstrappingKeyFFT *bk,
+    Torus32 mu, const IntPolynomial *factors, const int32_t nbOutputs,
+    const LweSample *x);
+
+/**
+ * tfhe_sparseLutBootstrap_FFT of the nbTables tables tables[i*msize..] at
+ * once, with a single blind rotation: for instance the sum and the carry of
+ * a full adder from the sum of its three input bits
+ */
+EXPORT void tfhe_sparseMultiLutBootstrap_FFT(LweSample *results,
+                                             const int32_t hw,
+                                             const LweBootstrappingKeyFFT *bk,
+                                             const int32_t *tables,
+                                             const int32_t nbTables,
+                                             const int32_t msize,
+                                             const LweSample *x);
+
+/*
+ * Batched versions of the sparse bootstrapping: the nbSamples inputs x and
+ * outputs results are contiguous arrays (see new_LweSample_array), and each
+ * block of the bootstrapping key is applied to the whole batch at once.
+ */
+EXPORT void tfhe_sparseBatchBlindRotate_FFT(TLweSample *accums,
+                                            const TGswSampleFFT *bkFFT,
+                                            const int32_t *bara,
+                                            const int32_t nbSamples,
+                                            const int32_t n, const int32_t hw,
+                                            const TGswParams *bk_params,
+                                            LweBootstrappingWorkspace *ws);
+EXPORT void tfhe_sparseBatchBootstrap_woKS_FFT(LweSample *results,
+                                               const int32_t hw,
+                                               const LweBootstrappingKeyFFT *bk,
+                                               Torus32 mu, const LweSample *x,
+                                               const int32_t nbSamples);
+EXPORT void tfhe_sparseBatchBootstrap_FFT(LweSample *results, const int32_t hw,
+                                          const LweBootstrappingKeyFFT *bk,
+                                          Torus32 mu, const LweSample *x,
+                                          const int32_t nbSamples);
+
+/*
+ * Counters of the sparse blind rotations (all threads, since the start of
+ * the program or the last reset). A block whose d coefficients bara are all
+ * zero leaves the accumulator unchanged: it is skipped before any
+ * decomposition or FFT.
+ */
+typedef struct TFheSparseRotateStats {
+  int64_t nb_blocks;          ///< key blocks met by the blind rotations
+  int64_t nb_skipped_blocks;  ///< blocks skipped (all their bara are 0)
+  int64_t nb_entries;         ///< key entries met (d per block)
+  int64_t nb_skipped_entries; ///< entries with bara = 0 (skipped blocks included)
+} TFheSparseRotateStats;
+
+/** reads the counters of the sparse blind rotations */
+EXPORT void tfhe_sparseRotateStats(TFheSparseRotateStats *result);
+/** sets the counters of the sparse blind rotations to 0 */
+EXPORT void tfhe_resetSparseRotateStats();
+
 #endif // TFHE_H
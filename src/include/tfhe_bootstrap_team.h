@@ -0,0 +1,62 @@
+#ifndef TFHE_BOOTSTRAP_TEAM_H
+#define TFHE_BOOTSTRAP_TEAM_H
+
+///@file
+///@brief a small team of threads that share the work of one bootstrapping
+
+#include "tfhe_core.h"
+
+//////////////////////////////////////////
+// Bootstrap team public interface
+//////////////////////////////////////////
+
+/*
+ * A bootstrap team lowers the latency of a single bootstrapping, for the
+ * critical paths (carry chains...) that cannot be batched or spread over a
+ * gate executor. The thread that bootstraps is the member 0 of the team, and
+ * the nb_threads-1 helpers join it inside the blind rotation: in each block
+ * of the sparse bootstrapping, the decompositions in the FFT domain, the
+ * products of the d key elements and the final FFTs are split between the
+ * members, which meet at a cheap spinning barrier between the steps.
+ *
+ * A team serves one bootstrapping at a time: it is attached to the calling
+ * thread with tfhe_useBootstrapTeam. The products are summed in a different
+ * order than in the sequential blind rotation, so the results are not
+ * bit-identical, only their phases are close.
+ */
+struct TFheBootstrapTeam;
+typedef struct TFheBootstrapTeam TFheBootstrapTeam;
+
+/** maximum number of members of a team */
+#define TFHE_BOOTSTRAP_TEAM_MAX_THREADS 64
+
+/** a job of the team: called once by each member, with member=0..nb_threads-1 */
+typedef void (*TFheBootstrapTeamJob)(int32_t member, void *arg);
+
+/**
+ * creates a bootstrap team and starts its helper threads
+ * @param nb_threads the number of members, counting the caller (0 = one per
+ *        hardware thread, at most TFHE_BOOTSTRAP_TEAM_MAX_THREADS)
+ */
+EXPORT TFheBootstrapTeam *new_bootstrap_team(int32_t nb_threads);
+
+/** stops the helper threads and deletes the team */
+EXPORT void delete_bootstrap_team(TFheBootstrapTeam *team);
+
+/** number of members of the team, counting the caller */
+EXPORT int32_t tfhe_bootstrapTeamNbThreads(const TFheBootstrapTeam *team);
+
+/**
+ * the sparse bootstrappings of the calling thread are shared with the team
+ * (0 = back to the sequential blind rotation)
+ */
+EXPORT void tfhe_useBootstrapTeam(TFheBootstrapTeam *team);
+
+/** runs job on all the members of the team, and waits until they are all done */
+EXPORT void tfhe_bootstrapTeamRun(TFheBootstrapTeam *team,
+                                  TFheBootstrapTeamJob job, void *arg);
+
+/** waits until all the members of the team reach the barrier (inside a job) */
+EXPORT void tfhe_bootstrapTeamBarrier(TFheBootstrapTeam *team);
+
+#endif // TFHE_BOOTSTRAP_TEAM_H
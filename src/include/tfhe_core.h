@@ -27,6 +27,15 @@ EXPORT void die_dramatically(const char *message);
 typedef int32_t Torus32; // avant uint32_t
 // typedef int64_t Torus64; //avant uint64_t
 
+/**
+ * seed of the expanded uniform masks: a 256-bit ChaCha20 key
+ * (see tfhe_seededUniformTorus32). All zero means no seed.
+ */
+struct TfheMaskSeed {
+    uint32_t key[8];
+};
+typedef struct TfheMaskSeed TfheMaskSeed;
+
 struct LweParams;
 struct LweKey;
 struct LweSample;
@@ -41,12 +50,15 @@ struct TGswSample;
 struct TGswSampleFFT;
 struct LweBootstrappingKey;
 struct LweBootstrappingKeyFFT;
+struct LweBootstrappingWorkspace;
+struct LweRotatedKeyFFT;
 struct IntPolynomial;
 struct TorusPolynomial;
 struct LagrangeHalfCPolynomial;
 struct TFheGateBootstrappingParameterSet;
 struct TFheGateBootstrappingCloudKeySet;
 struct TFheGateBootstrappingSecretKeySet;
+struct TFheGateBootstrappingSeededCiphertextArray;
 
 // this is for compatibility with C code, to be able to use
 //"LweParams" as a type and not "struct LweParams"
@@ -64,6 +76,8 @@ typedef struct TGswSample TGswSample;
 typedef struct TGswSampleFFT TGswSampleFFT;
 typedef struct LweBootstrappingKey LweBootstrappingKey;
 typedef struct LweBootstrappingKeyFFT LweBootstrappingKeyFFT;
+typedef struct LweBootstrappingWorkspace LweBootstrappingWorkspace;
+typedef struct LweRotatedKeyFFT LweRotatedKeyFFT;
 typedef struct IntPolynomial IntPolynomial;
 typedef struct TorusPolynomial TorusPolynomial;
 typedef struct LagrangeHalfCPolynomial LagrangeHalfCPolynomial;
@@ -73,5 +87,7 @@ typedef struct TFheGateBootstrappingCloudKeySet
     TFheGateBootstrappingCloudKeySet;
 typedef struct TFheGateBootstrappingSecretKeySet
     TFheGateBootstrappingSecretKeySet;
+typedef struct TFheGateBootstrappingSeededCiphertextArray
+    TFheGateBootstrappingSeededCiphertextArray;
 
 #endif // TFHE_CORE_H
@@ -27,6 +27,21 @@ EXPORT TFheGateBootstrappingSecretKeySet *
 new_random_sparse_bootstrapping_secret_keyset(
     const TFheGateBootstrappingParameterSet *params);
 
+/**
+ * same as new_random_gate_bootstrapping_secret_keyset and
+ * new_random_sparse_bootstrapping_secret_keyset, but the masks of the
+ * cloud key are expanded from random seeds (see
+ * tfhe_createSeededLweBootstrappingKey): only these keysets can be exported
+ * with export_tfheGateBootstrappingCloudKeySet_compressed_toFile
+ */
+EXPORT TFheGateBootstrappingSecretKeySet *
+new_random_seeded_gate_bootstrapping_secret_keyset(
+    const TFheGateBootstrappingParameterSet *params);
+
+EXPORT TFheGateBootstrappingSecretKeySet *
+new_random_seeded_sparse_bootstrapping_secret_keyset(
+    const TFheGateBootstrappingParameterSet *params);
+
 /** deletes gate bootstrapping parameters */
 EXPORT void
 delete_gate_bootstrapping_parameters(TFheGateBootstrappingParameterSet *params);
@@ -58,6 +73,25 @@ EXPORT void delete_gate_bootstrapping_ciphertext_array(int32_t nbelems,
 EXPORT void bootsSymEncrypt(LweSample *result, int32_t message,
                             const TFheGateBootstrappingSecretKeySet *params);
 
+/** generate a new unititialized seeded ciphertext array of length nbelems */
+EXPORT TFheGateBootstrappingSeededCiphertextArray *
+new_gate_bootstrapping_seeded_ciphertext_array(
+    int32_t nbelems, const TFheGateBootstrappingParameterSet *params);
+
+/** deletes a seeded ciphertext array */
+EXPORT void delete_gate_bootstrapping_seeded_ciphertext_array(
+    TFheGateBootstrappingSeededCiphertextArray *results);
+
+/**
+ * encrypts the results->nbelems booleans of messages, with the masks
+ * expanded from a new random results->seed (the sample i from the row i):
+ * the array can then be exported in compressed form
+ * (export_gate_bootstrapping_ciphertext_array_compressed_toFile)
+ */
+EXPORT void bootsSymEncryptSeeded(TFheGateBootstrappingSeededCiphertextArray *results,
+                                  const int32_t *messages,
+                                  const TFheGateBootstrappingSecretKeySet *key);
+
 /** decrypts a boolean */
 EXPORT int32_t bootsSymDecrypt(const LweSample *sample,
                                const TFheGateBootstrappingSecretKeySet *params);
@@ -66,11 +100,18 @@ EXPORT int32_t bootsSymDecrypt(const LweSample *sample,
 EXPORT void bootsCONSTANT(LweSample *result, int32_t value,
                           const TFheGateBootstrappingCloudKeySet *bk);
 
+/*
+ * All the bootstrapped gates below use the sparse (block-key) bootstrapping
+ * when the cloud key is sparse (bk->sparse, see
+ * new_random_sparse_bootstrapping_secret_keyset), and the dense one otherwise
+ */
+
 /** bootstrapped Nand Gate */
 EXPORT void bootsNAND(LweSample *result, const LweSample *ca,
                       const LweSample *cb,
                       const TFheGateBootstrappingCloudKeySet *bk);
 
+/** bootstrapped Nand Gate, always with the sparse bootstrapping */
 EXPORT void bootsSparseNAND(LweSample *result, const LweSample *ca,
                             const LweSample *cb,
                             const TFheGateBootstrappingCloudKeySet *bk);
@@ -122,4 +163,21 @@ EXPORT void bootsMUX(LweSample *result, const LweSample *a, const LweSample *b,
                      const LweSample *c,
                      const TFheGateBootstrappingCloudKeySet *bk);
 
+/*
+ * 3-input gates with a single bootstrapping: a full adder a+b+c is
+ * bootsXOR3 (sum) and bootsMAJ3 (carry), and negated inputs are free
+ * (bootsMAJ3(not(a),b,c) is the borrow of a subtraction). AND3 and OR3 do
+ * not fit in one bootstrapping: the sums of three inputs of +/-1/8 are 1/4
+ * apart, and the test vector gives opposite outputs to the phases 1/2
+ * apart (0 and 2 true inputs).
+ */
+/** bootstrapped Majority gate: result = (a+b+c >= 2) */
+EXPORT void bootsMAJ3(LweSample *result, const LweSample *ca,
+                      const LweSample *cb, const LweSample *cc,
+                      const TFheGateBootstrappingCloudKeySet *bk);
+/** bootstrapped 3-input Xor gate: result = a xor b xor c */
+EXPORT void bootsXOR3(LweSample *result, const LweSample *ca,
+                      const LweSample *cb, const LweSample *cc,
+                      const TFheGateBootstrappingCloudKeySet *bk);
+
 #endif // TFHE_GATE_BOOTSTRAPPING_FUNCTIONS_H
@@ -36,6 +36,7 @@ struct TFheGateBootstrappingCloudKeySet {
   const TFheGateBootstrappingParameterSet *const params;
   const LweBootstrappingKey *const bk;
   const LweBootstrappingKeyFFT *const bkFFT;
+  const int32_t sparse; ///< 1 if the gates use the sparse (block-key) bootstrapping
 #ifdef __cplusplus
 
   TFheGateBootstrappingCloudKeySet(
@@ -43,6 +44,11 @@ struct TFheGateBootstrappingCloudKeySet {
       const LweBootstrappingKey *const bk,
       const LweBootstrappingKeyFFT *const bkFFT);
 
+  TFheGateBootstrappingCloudKeySet(
+      const TFheGateBootstrappingParameterSet *const params,
+      const LweBootstrappingKey *const bk,
+      const LweBootstrappingKeyFFT *const bkFFT, const int32_t sparse);
+
   TFheGateBootstrappingCloudKeySet(const TFheGateBootstrappingCloudKeySet &) =
       delete;
 
@@ -64,6 +70,12 @@ struct TFheGateBootstrappingSecretKeySet {
       const LweBootstrappingKeyFFT *const bkFFT, const LweKey *lwe_key,
       const TGswKey *tgsw_key);
 
+  TFheGateBootstrappingSecretKeySet(
+      const TFheGateBootstrappingParameterSet *const params,
+      const LweBootstrappingKey *const bk,
+      const LweBootstrappingKeyFFT *const bkFFT, const LweKey *lwe_key,
+      const TGswKey *tgsw_key, const int32_t sparse);
+
   TFheGateBootstrappingSecretKeySet(const TFheGateBootstrappingSecretKeySet &) =
       delete;
 
@@ -72,4 +84,26 @@ struct TFheGateBootstrappingSecretKeySet {
 #endif
 };
 
+/**
+ * an array of ciphertexts whose masks are expanded from seed, the sample i
+ * from the row i (see bootsSymEncryptSeeded): it is exported with its seed
+ * and the b parts only
+ */
+struct TFheGateBootstrappingSeededCiphertextArray {
+  const int32_t nbelems;
+  LweSample *const samples;
+  TfheMaskSeed seed; ///< the seed of the masks, drawn by bootsSymEncryptSeeded
+#ifdef __cplusplus
+
+  TFheGateBootstrappingSeededCiphertextArray(const int32_t nbelems,
+                                             LweSample *const samples);
+
+  TFheGateBootstrappingSeededCiphertextArray(
+      const TFheGateBootstrappingSeededCiphertextArray &) = delete;
+
+  void operator=(const TFheGateBootstrappingSeededCiphertextArray &) = delete;
+
+#endif
+};
+
 #endif // TFHE_GATE_BOOTSTRAPPING_STRUCTURES_H
@@ -0,0 +1,77 @@
+#ifndef TFHE_GATE_EXECUTOR_H
+#define TFHE_GATE_EXECUTOR_H
+
+///@file
+///@brief multithreaded evaluation of a graph of bootstrapped gates
+
+#include "tfhe_core.h"
+
+//////////////////////////////////////////
+// Gate executor public interface
+//////////////////////////////////////////
+
+/*
+ * A gate executor records a sequence of boots* gates (the graph), and then
+ * evaluates it on a pool of worker threads. The dependencies between the
+ * gates are deduced from the LweSample pointers that they read and write, so
+ * that the result is always the same as the sequential evaluation of the
+ * gates in the order of submission: a gate waits for the last writer of each
+ * of its inputs, and for the previous readers and writer of its output.
+ * Independent gates run concurrently, each worker keeping its own
+ * (thread_local) FFT processor from one gate to the next.
+ *
+ * The submitted samples must stay allocated until tfhe_gateExecutorRun
+ * returns, and must not be accessed by the caller in between.
+ */
+struct TFheGateExecutor;
+typedef struct TFheGateExecutor TFheGateExecutor;
+
+/** signature of the unary gates (bootsNOT, bootsCOPY) */
+typedef void (*TFheUnaryGate)(LweSample *result, const LweSample *ca,
+                              const TFheGateBootstrappingCloudKeySet *bk);
+/** signature of the binary gates (bootsNAND, bootsAND, ...) */
+typedef void (*TFheBinaryGate)(LweSample *result, const LweSample *ca,
+                               const LweSample *cb,
+                               const TFheGateBootstrappingCloudKeySet *bk);
+/** signature of the ternary gates (bootsMUX) */
+typedef void (*TFheTernaryGate)(LweSample *result, const LweSample *ca,
+                                const LweSample *cb, const LweSample *cc,
+                                const TFheGateBootstrappingCloudKeySet *bk);
+
+/**
+ * creates a gate executor and starts its worker threads
+ * @param nb_threads the number of workers (0 = one per hardware thread)
+ */
+EXPORT TFheGateExecutor *new_gate_executor(int32_t nb_threads);
+
+/** stops the worker threads and deletes the executor */
+EXPORT void delete_gate_executor(TFheGateExecutor *executor);
+
+/** number of worker threads of the executor */
+EXPORT int32_t tfhe_gateExecutorNbThreads(const TFheGateExecutor *executor);
+
+/** adds result = gate(ca) to the graph */
+EXPORT void tfhe_gateExecutorAddUnary(TFheGateExecutor *executor,
+                                      TFheUnaryGate gate, LweSample *result,
+                                      const LweSample *ca,
+                                      const TFheGateBootstrappingCloudKeySet *bk);
+
+/** adds result = gate(ca,cb) to the graph */
+EXPORT void tfhe_gateExecutorAddBinary(
+    TFheGateExecutor *executor, TFheBinaryGate gate, LweSample *result,
+    const LweSample *ca, const LweSample *cb,
+    const TFheGateBootstrappingCloudKeySet *bk);
+
+/** adds result = gate(ca,cb,cc) to the graph */
+EXPORT void tfhe_gateExecutorAddTernary(
+    TFheGateExecutor *executor, TFheTernaryGate gate, LweSample *result,
+    const LweSample *ca, const LweSample *cb, const LweSample *cc,
+    const TFheGateBootstrappingCloudKeySet *bk);
+
+/**
+ * evaluates all the gates submitted since the last run, and waits until they
+ * are done. The graph is then cleared, and the executor can be reused.
+ */
+EXPORT void tfhe_gateExecutorRun(TFheGateExecutor *executor);
+
+#endif // TFHE_GATE_EXECUTOR_H
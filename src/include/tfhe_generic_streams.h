@@ -17,6 +17,11 @@ const int32_t TLWE_SAMPLE_TYPE_UID = 84;
 const int32_t TLWE_SAMPLE_FFT_TYPE_UID = 83;
 const int32_t TGSW_SAMPLE_TYPE_UID = 168;
 const int32_t TGSW_SAMPLE_FFT_TYPE_UID = 167;
+/*
+ * Seed-compressed LWE array 44: 1 int32 (nbelems), 1 double (max variance),
+ * 8 uint32 (seed), nbelems Torus32 (b)
+ */
+const int32_t LWE_SEEDED_SAMPLE_ARRAY_TYPE_UID = 44;
 /*
  * Types for the different keys
  * LWE 42: n Torus32 (a), 1 Torus32 (b), 1 double (current_variance)
@@ -28,6 +33,14 @@ const int32_t TLWE_KEY_TYPE_UID = 85;
 const int32_t TGSW_KEY_TYPE_UID = 169;
 const int32_t LWE_KEYSWITCH_KEY_TYPE_UID = 200;
 const int32_t LWE_BOOTSTRAPPING_KEY_TYPE_UID = 201;
+/*
+ * Seed-compressed keys: the uniform masks are replaced by the 256-bit seed
+ * they are expanded from (see tfhe_seededUniformTorus32)
+ * KEYSWITCH 202: 1 double (variance), 8 uint32 (seed), N.t.(base-1) Torus32 (b)
+ * BOOTSTRAPPING 203: 1 double (variance), 8 uint32 (seed), n.kpl.N Torus32 (b)
+ */
+const int32_t LWE_SEEDED_KEYSWITCH_KEY_TYPE_UID = 202;
+const int32_t LWE_SEEDED_BOOTSTRAPPING_KEY_TYPE_UID = 203;
 
 /**
  * This is a generic Istream wrapper: supports getLine() and feof()
@@ -97,6 +110,8 @@ public:
 
     virtual const std::string &getProperty(const std::string &name) const =0;
 
+    virtual bool hasProperty(const std::string &name) const =0;
+
     virtual double getProperty_double(const std::string &name) const =0;
 
     virtual int64_t getProperty_int64_t(const std::string &name) const =0;
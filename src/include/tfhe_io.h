@@ -415,6 +415,14 @@ EXPORT void export_tfheGateBootstrappingCloudKeySet_toFile(FILE *F, const TFheGa
  */
 EXPORT TFheGateBootstrappingCloudKeySet *new_tfheGateBootstrappingCloudKeySet_fromFile(FILE *F);
 
+/**
+ * This function prints the tfhe gate bootstrapping cloud key to a file, in seed-compressed
+ * form: the uniform masks are replaced by their seeds (the keyset must have been created
+ * from seeds). It is read back with new_tfheGateBootstrappingCloudKeySet_fromFile
+ */
+EXPORT void export_tfheGateBootstrappingCloudKeySet_compressed_toFile(FILE *F,
+                                                                      const TFheGateBootstrappingCloudKeySet *params);
+
 #ifdef __cplusplus
 
 /**
@@ -429,6 +437,13 @@ export_tfheGateBootstrappingCloudKeySet_toStream(std::ostream &F, const TFheGate
  */
 EXPORT TFheGateBootstrappingCloudKeySet *new_tfheGateBootstrappingCloudKeySet_fromStream(std::istream &F);
 
+/**
+ * This function prints the tfhe gate bootstrapping cloud key to a stream, in seed-compressed
+ * form. It is read back with new_tfheGateBootstrappingCloudKeySet_fromStream
+ */
+EXPORT void export_tfheGateBootstrappingCloudKeySet_compressed_toStream(std::ostream &F,
+                                                                        const TFheGateBootstrappingCloudKeySet *params);
+
 #endif
 
 /* ****************************
@@ -462,6 +477,31 @@ EXPORT TFheGateBootstrappingSecretKeySet *new_tfheGateBootstrappingSecretKeySet_
 
 #endif
 
+/* ****************************
+ * Mapped TFheGateBootstrappingCloudKeySet
+**************************** */
+
+/**
+ * This function prints the tfhe gate bootstrapping cloud key to a file, in the
+ * binary mapped format: a versioned header followed by the page-aligned FFT key
+ * (in the layout of the fft processor of this build) and the flattened keyswitch key.
+ * The file can only be mapped by a build with the same fft processor and endianness.
+ */
+EXPORT void export_tfheGateBootstrappingCloudKeySet_mapped_toFile(FILE *F,
+                                                                  const TFheGateBootstrappingCloudKeySet *keyset);
+
+/**
+ * This function maps read-only a cloud key file written by
+ * export_tfheGateBootstrappingCloudKeySet_mapped_toFile: the FFT key and the
+ * keyswitch key are used in place, so the loading costs no FFT, and the processes that
+ * map the same file share its pages. The keyset has no coefficient-domain key (bk is 0).
+ * The result must be deleted with delete_mapped_gate_bootstrapping_cloud_keyset();
+ */
+EXPORT TFheGateBootstrappingCloudKeySet *new_tfheGateBootstrappingCloudKeySet_mapFile(const char *filename);
+
+/** unmaps a cloud keyset created by new_tfheGateBootstrappingCloudKeySet_mapFile */
+EXPORT void delete_mapped_gate_bootstrapping_cloud_keyset(TFheGateBootstrappingCloudKeySet *keyset);
+
 /* ****************************
  * TFheGateBootstrappingCiphertext
 **************************** */
@@ -480,6 +520,22 @@ EXPORT void export_gate_bootstrapping_ciphertext_toFile(FILE *F, const LweSample
 EXPORT void import_gate_bootstrapping_ciphertext_fromFile(FILE *F, LweSample *sample,
                                                           const TFheGateBootstrappingParameterSet *params);
 
+/**
+ * This function prints an array of ciphertexts encrypted with bootsSymEncryptSeeded
+ * to a file, in compressed form: only its seed and the b parts are written
+ */
+EXPORT void export_gate_bootstrapping_ciphertext_array_compressed_toFile(FILE *F,
+                                                                         const TFheGateBootstrappingSeededCiphertextArray *samples,
+                                                                         const TFheGateBootstrappingParameterSet *params);
+
+/**
+ * This function reads an array of nbelems compressed ciphertexts from a File, and
+ * expands their masks
+ */
+EXPORT void import_gate_bootstrapping_ciphertext_array_compressed_fromFile(FILE *F, LweSample *samples,
+                                                                           int32_t nbelems,
+                                                                           const TFheGateBootstrappingParameterSet *params);
+
 #ifdef __cplusplus
 
 /**
@@ -496,6 +552,22 @@ EXPORT void export_gate_bootstrapping_ciphertext_toStream(std::ostream &F, const
 EXPORT void import_gate_bootstrapping_ciphertext_fromStream(std::istream &F, LweSample *sample,
                                                             const TFheGateBootstrappingParameterSet *params);
 
+/**
+ * This function prints an array of ciphertexts encrypted with bootsSymEncryptSeeded
+ * to a stream, in compressed form: only its seed and the b parts are written
+ */
+EXPORT void export_gate_bootstrapping_ciphertext_array_compressed_toStream(std::ostream &F,
+                                                                           const TFheGateBootstrappingSeededCiphertextArray *samples,
+                                                                           const TFheGateBootstrappingParameterSet *params);
+
+/**
+ * This function reads an array of nbelems compressed ciphertexts from a stream, and
+ * expands their masks
+ */
+EXPORT void import_gate_bootstrapping_ciphertext_array_compressed_fromStream(std::istream &F, LweSample *samples,
+                                                                             int32_t nbelems,
+                                                                             const TFheGateBootstrappingParameterSet *params);
+
 #endif
 
 
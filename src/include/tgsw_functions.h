@@ -18,6 +18,15 @@ EXPORT void tGswSymEncrypt(TGswSample *result, const IntPolynomial *message,
                            double alpha, const TGswKey *key);
 EXPORT void tGswSymEncryptInt(TGswSample *result, const int32_t message,
                               double alpha, const TGswKey *key);
+/**
+ * same as tGswSymEncryptInt, where the mask of the line p is seeded by
+ * (seed, row.kpl+p), see tLweSymEncryptZeroSeeded. The message of the mask
+ * blocks is moved to the body (-message.h_j.s_bloc), so that the masks stay
+ * exactly the seeded ones: the phases are the same as with tGswAddMuIntH
+ */
+EXPORT void tGswSymEncryptIntSeeded(TGswSample *result, const int32_t message,
+                                    double alpha, const TGswKey *key,
+                                    const TfheMaskSeed *seed, uint64_t row);
 EXPORT void tGswSymDecrypt(IntPolynomial *result, const TGswSample *sample,
                            const TGswKey *key, const int32_t Msize);
 EXPORT int32_t tGswSymDecryptInt(const TGswSample *sample, const TGswKey *key);
@@ -45,6 +54,10 @@ EXPORT void tGswTLweDecompH(IntPolynomial *result, const TLweSample *sample,
 EXPORT void tGswTorus32PolynomialDecompH(IntPolynomial *result,
                                          const TorusPolynomial *sample,
                                          const TGswParams *params);
+// same decomposition, directly in the fft domain (fused kernel)
+EXPORT void tGswTorus32PolynomialDecompHFFT(LagrangeHalfCPolynomial *result,
+                                            const TorusPolynomial *sample,
+                                            const TGswParams *params);
 EXPORT void tGswTLweDecompH(IntPolynomial *result, const TLweSample *sample,
                             const TGswParams *params);
 
@@ -95,11 +108,43 @@ EXPORT void tGswFFTExternMulToTLwe(TLweSample *accum, const TGswSampleFFT *gsw,
 EXPORT void tGswFFTExternMulToTLweHoisting(TLweSample *accum,
                                            const TGswSampleFFT *gsw,
                                            const int32_t *bara, const int32_t d,
-                                           const TGswParams *params);
-
+                                           const TGswParams *params,
+                                           LweBootstrappingWorkspace *ws);
+
+/**
+ * result = accum + gsw (*) accum, the addition being done in the FFT domain
+ * (accum is recomposed from its decomposition, up to its rounding 1/2Bg^l).
+ * The sparse blind rotations only use it if the key opts in (see
+ * tfhe_setAccumRecompositionFFT)
+ */
+EXPORT void tGswFFTExternMulToTLweHoistingAddTo(TLweSample *result,
+                                                const TLweSample *accum,
+                                                const TGswSampleFFT *gsw,
+                                                const int32_t *bara,
+                                                const int32_t d,
+                                                const TGswParams *params,
+                                                LweBootstrappingWorkspace *ws);
+
+/**
+ * acc += sum of (X^bara[i]-1) * (gsw_i (*) decaFFT) for the entries
+ * i = first, first+step, ... < d: the products of the hoisted external
+ * product, shared between the members of a bootstrap team (ws is the scratch
+ * space of the member)
+ */
+EXPORT void tGswFFTExternMulHoistingShare(TLweSampleFFT *acc,
+                                          const TGswSampleFFT *gsw,
+                                          const int32_t *bara, const int32_t d,
+                                          const int32_t first,
+                                          const int32_t step,
+                                          const LagrangeHalfCPolynomial *decaFFT,
+                                          const TGswParams *params,
+                                          LweBootstrappingWorkspace *ws);
+
+/** result = (X^ai-1)*bki, xaim1 is a scratch polynomial of degree N */
 EXPORT void tGswFFTMulByXaiMinusOne(TGswSampleFFT *result, const int32_t ai,
                                     const TGswSampleFFT *bki,
-                                    const TGswParams *params);
+                                    const TGswParams *params,
+                                    LagrangeHalfCPolynomial *xaim1);
 
 EXPORT void tGswFFTAddTo(TGswSampleFFT *result, const TGswSampleFFT *sample,
                          const TGswParams *params);
@@ -136,11 +181,12 @@ EXPORT void tfhe_sparseBlindRotate_FFT(TLweSample *accum,
                                        const int32_t *bara, const int32_t n,
                                        const int32_t hw,
                                        const TLweParams *params,
-                                       const TGswParams *bk_params);
+                                       const TGswParams *bk_params,
+                                       LweBootstrappingWorkspace *ws);
 EXPORT void tfhe_sparseBlindRotateAndExtract_FFT(
     LweSample *result, const TorusPolynomial *v, const TGswSampleFFT *bk,
     const int32_t barb, const int32_t *bara, const int32_t n, const int32_t hw,
-    const TGswParams *bk_params);
+    const TGswParams *bk_params, LweBootstrappingWorkspace *ws);
 
 EXPORT void tfhe_sparseBootstrap_FFT(LweSample *result, const int32_t hw,
                                      const LweBootstrappingKeyFFT *bk,
@@ -64,6 +64,8 @@ struct TLweSample {
 struct TLweSampleFFT {
   LagrangeHalfCPolynomial *a; ///< array of length k+1: mask + right term
   LagrangeHalfCPolynomial *b; ///< alias of a[k] to get the right term
+  float *a_float32; ///< or, single precision storage: k+1 blocks of N floats
+                    ///< (a and b are then 0, see tLweFFTToFloat32)
   double current_variance;    ///< avg variance of the sample
   const int32_t k;            // required during the destructor call...
 #ifdef __cplusplus
@@ -49,6 +49,10 @@ EXPORT void tLweSubMulTo(TLweSample *result, int32_t p,
 /*create an homogeneous tlwe sample*/
 EXPORT void tLweSymEncryptZero(TLweSample *result, double alpha,
                                const TLweKey *key);
+/** same, with the mask a[i] = tfhe_seededUniformTorus32(seed, row.k+i) */
+EXPORT void tLweSymEncryptZeroSeeded(TLweSample *result, double alpha,
+                                     const TLweKey *key,
+                                     const TfheMaskSeed *seed, uint64_t row);
 
 /** result = result + p.sample */
 EXPORT void tLweAddMulRTo(TLweSample *result, const IntPolynomial *p,
@@ -102,8 +106,22 @@ EXPORT void tLweFFTAddMulRTo(TLweSampleFFT *result,
 EXPORT void tLweFFTAddTo(TLweSampleFFT *result, const TLweSampleFFT *sample,
                          const TLweParams *params);
 
+/**
+ * stores sample in single precision (see TLweSampleFFT::a_float32): it then
+ * takes half the memory, but can only be the sample of tLweFFTAddMulRTo
+ */
+EXPORT void tLweFFTToFloat32(TLweSampleFFT *sample, const TLweParams *params);
+
+/** result += (X^ai-1)*sample, xaim1 is a scratch polynomial of degree N */
 EXPORT void tLweFFTAddMulByXaiMinusOne(TLweSampleFFT *result, int32_t ai,
                                        const TLweSampleFFT *sample,
-                                       const TLweParams *params);
+                                       const TLweParams *params,
+                                       LagrangeHalfCPolynomial *xaim1);
+
+/** result += (X^ai-1)*sample, where xaim1_table[a] = X^a-1 for all a in [0,2N)
+ * (see tfhe_xaiMinusOneTable) */
+EXPORT void tLweFFTAddMulByXaiMinusOneTable(
+    TLweSampleFFT *result, int32_t ai, const TLweSampleFFT *sample,
+    const TLweParams *params, const LagrangeHalfCPolynomial *xaim1_table);
 
 #endif // TLWE_FUNCTIONS_H
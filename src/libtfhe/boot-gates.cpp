@@ -24,6 +24,55 @@ using namespace std;
 // zones on the torus -> to see
 //*//*****************************************
 
+/*
+ * Temporary samples of the gates, owned by the workspace of the calling
+ * thread (0 and 1 for the inputs of the bootstrappings, 2 and 3 for their
+ * outputs), so that the gates do not allocate anything
+ */
+static LweSample *bootsTemp(const TFheGateBootstrappingCloudKeySet *bk,
+                            int32_t i) {
+  LweBootstrappingWorkspace *ws = tfhe_threadBootstrappingWorkspace(
+      bk->params->tgsw_params, bk->params->in_out_params->n);
+  return ws->gate_temp[i];
+}
+
+/*
+ * Gate bootstrapping: result = LWE(mu) iff phase(x)>0, LWE(-mu) iff phase(x)<0
+ * Uses the sparse (block-key) bootstrapping if the cloud key is sparse,
+ * the dense one otherwise
+ */
+static void bootsBootstrap(LweSample *result, Torus32 mu, const LweSample *x,
+                           const TFheGateBootstrappingCloudKeySet *bk) {
+  if (bk->sparse)
+    tfhe_sparseBootstrap_FFT(result, bk->params->hw, bk->bkFFT, mu, x);
+  else
+    tfhe_bootstrap_FFT(result, bk->bkFFT, mu, x);
+}
+
+/*
+ * Same as bootsBootstrap, without the final keyswitch
+ * (result has the extracted parameters)
+ */
+static void bootsBootstrap_woKS(LweSample *result, Torus32 mu,
+                                const LweSample *x,
+                                const TFheGateBootstrappingCloudKeySet *bk) {
+  if (bk->sparse)
+    tfhe_sparseBootstrap_woKS_FFT(result, bk->params->hw, bk->bkFFT, mu, x);
+  else
+    tfhe_bootstrap_woKS_FFT(result, bk->bkFFT, mu, x);
+}
+
+/*
+ * Keyswitch from the extracted parameters back to the in_out parameters
+ */
+static void bootsKeySwitch(LweSample *result, const LweSample *u,
+                           const TFheGateBootstrappingCloudKeySet *bk) {
+  if (bk->sparse)
+    lweSparseKeySwitch(result, bk->bkFFT->ks, u);
+  else
+    lweKeySwitch(result, bk->bkFFT->ks, u);
+}
+
 /*
  * Homomorphic bootstrapped NAND gate
  * Takes in input 2 LWE samples (with message space [-1/8,1/8], noise<1/16)
@@ -35,7 +84,7 @@ EXPORT void bootsNAND(LweSample *result, const LweSample *ca,
   static const Torus32 MU = modSwitchToTorus32(1, 8);
   const LweParams *in_out_params = bk->params->in_out_params;
 
-  LweSample *temp_result = new_LweSample(in_out_params);
+  LweSample *temp_result = bootsTemp(bk, 0);
 
   // compute: (0,1/8) - ca - cb
   static const Torus32 NandConst = modSwitchToTorus32(1, 8);
@@ -45,9 +94,7 @@ EXPORT void bootsNAND(LweSample *result, const LweSample *ca,
 
   // if the phase is positive, the result is 1/8
   // if the phase is positive, else the result is -1/8
-  tfhe_bootstrap_FFT(result, bk->bkFFT, MU, temp_result);
-
-  delete_LweSample(temp_result);
+  bootsBootstrap(result, MU, temp_result, bk);
 }
 
 /*
@@ -61,7 +108,7 @@ EXPORT void bootsSparseNAND(LweSample *result, const LweSample *ca,
   static const Torus32 MU = modSwitchToTorus32(1, 8);
   const LweParams *in_out_params = bk->params->in_out_params;
 
-  LweSample *temp_result = new_LweSample(in_out_params);
+  LweSample *temp_result = bootsTemp(bk, 0);
 
   // compute: (0,1/8) - ca - cb
   static const Torus32 NandConst = modSwitchToTorus32(1, 8);
@@ -71,10 +118,9 @@ EXPORT void bootsSparseNAND(LweSample *result, const LweSample *ca,
 
   // if the phase is positive, the result is 1/8
   // if the phase is positive, else the result is -1/8
+  // (always sparse, whatever the cloud key flag)
   const int32_t hw = bk->params->hw;
   tfhe_sparseBootstrap_FFT(result, hw, bk->bkFFT, MU, temp_result);
-
-  delete_LweSample(temp_result);
 }
 
 /*
@@ -87,7 +133,7 @@ EXPORT void bootsOR(LweSample *result, const LweSample *ca, const LweSample *cb,
   static const Torus32 MU = modSwitchToTorus32(1, 8);
   const LweParams *in_out_params = bk->params->in_out_params;
 
-  LweSample *temp_result = new_LweSample(in_out_params);
+  LweSample *temp_result = bootsTemp(bk, 0);
 
   // compute: (0,1/8) + ca + cb
   static const Torus32 OrConst = modSwitchToTorus32(1, 8);
@@ -97,9 +143,7 @@ EXPORT void bootsOR(LweSample *result, const LweSample *ca, const LweSample *cb,
 
   // if the phase is positive, the result is 1/8
   // if the phase is positive, else the result is -1/8
-  tfhe_bootstrap_FFT(result, bk->bkFFT, MU, temp_result);
-
-  delete_LweSample(temp_result);
+  bootsBootstrap(result, MU, temp_result, bk);
 }
 
 /*
@@ -113,7 +157,7 @@ EXPORT void bootsAND(LweSample *result, const LweSample *ca,
   static const Torus32 MU = modSwitchToTorus32(1, 8);
   const LweParams *in_out_params = bk->params->in_out_params;
 
-  LweSample *temp_result = new_LweSample(in_out_params);
+  LweSample *temp_result = bootsTemp(bk, 0);
 
   // compute: (0,-1/8) + ca + cb
   static const Torus32 AndConst = modSwitchToTorus32(-1, 8);
@@ -123,9 +167,7 @@ EXPORT void bootsAND(LweSample *result, const LweSample *ca,
 
   // if the phase is positive, the result is 1/8
   // if the phase is positive, else the result is -1/8
-  tfhe_bootstrap_FFT(result, bk->bkFFT, MU, temp_result);
-
-  delete_LweSample(temp_result);
+  bootsBootstrap(result, MU, temp_result, bk);
 }
 
 /*
@@ -139,7 +181,7 @@ EXPORT void bootsXOR(LweSample *result, const LweSample *ca,
   static const Torus32 MU = modSwitchToTorus32(1, 8);
   const LweParams *in_out_params = bk->params->in_out_params;
 
-  LweSample *temp_result = new_LweSample(in_out_params);
+  LweSample *temp_result = bootsTemp(bk, 0);
 
   // compute: (0,1/4) + 2*(ca + cb)
   static const Torus32 XorConst = modSwitchToTorus32(1, 4);
@@ -149,9 +191,7 @@ EXPORT void bootsXOR(LweSample *result, const LweSample *ca,
 
   // if the phase is positive, the result is 1/8
   // if the phase is positive, else the result is -1/8
-  tfhe_bootstrap_FFT(result, bk->bkFFT, MU, temp_result);
-
-  delete_LweSample(temp_result);
+  bootsBootstrap(result, MU, temp_result, bk);
 }
 
 /*
@@ -165,7 +205,7 @@ EXPORT void bootsXNOR(LweSample *result, const LweSample *ca,
   static const Torus32 MU = modSwitchToTorus32(1, 8);
   const LweParams *in_out_params = bk->params->in_out_params;
 
-  LweSample *temp_result = new_LweSample(in_out_params);
+  LweSample *temp_result = bootsTemp(bk, 0);
 
   // compute: (0,-1/4) + 2*(-ca-cb)
   static const Torus32 XnorConst = modSwitchToTorus32(-1, 4);
@@ -175,9 +215,7 @@ EXPORT void bootsXNOR(LweSample *result, const LweSample *ca,
 
   // if the phase is positive, the result is 1/8
   // if the phase is positive, else the result is -1/8
-  tfhe_bootstrap_FFT(result, bk->bkFFT, MU, temp_result);
-
-  delete_LweSample(temp_result);
+  bootsBootstrap(result, MU, temp_result, bk);
 }
 
 /*
@@ -225,7 +263,7 @@ EXPORT void bootsNOR(LweSample *result, const LweSample *ca,
   static const Torus32 MU = modSwitchToTorus32(1, 8);
   const LweParams *in_out_params = bk->params->in_out_params;
 
-  LweSample *temp_result = new_LweSample(in_out_params);
+  LweSample *temp_result = bootsTemp(bk, 0);
 
   // compute: (0,-1/8) - ca - cb
   static const Torus32 NorConst = modSwitchToTorus32(-1, 8);
@@ -235,9 +273,7 @@ EXPORT void bootsNOR(LweSample *result, const LweSample *ca,
 
   // if the phase is positive, the result is 1/8
   // if the phase is positive, else the result is -1/8
-  tfhe_bootstrap_FFT(result, bk->bkFFT, MU, temp_result);
-
-  delete_LweSample(temp_result);
+  bootsBootstrap(result, MU, temp_result, bk);
 }
 
 /*
@@ -251,7 +287,7 @@ EXPORT void bootsANDNY(LweSample *result, const LweSample *ca,
   static const Torus32 MU = modSwitchToTorus32(1, 8);
   const LweParams *in_out_params = bk->params->in_out_params;
 
-  LweSample *temp_result = new_LweSample(in_out_params);
+  LweSample *temp_result = bootsTemp(bk, 0);
 
   // compute: (0,-1/8) - ca + cb
   static const Torus32 AndNYConst = modSwitchToTorus32(-1, 8);
@@ -261,9 +297,7 @@ EXPORT void bootsANDNY(LweSample *result, const LweSample *ca,
 
   // if the phase is positive, the result is 1/8
   // if the phase is positive, else the result is -1/8
-  tfhe_bootstrap_FFT(result, bk->bkFFT, MU, temp_result);
-
-  delete_LweSample(temp_result);
+  bootsBootstrap(result, MU, temp_result, bk);
 }
 
 /*
@@ -277,7 +311,7 @@ EXPORT void bootsANDYN(LweSample *result, const LweSample *ca,
   static const Torus32 MU = modSwitchToTorus32(1, 8);
   const LweParams *in_out_params = bk->params->in_out_params;
 
-  LweSample *temp_result = new_LweSample(in_out_params);
+  LweSample *temp_result = bootsTemp(bk, 0);
 
   // compute: (0,-1/8) + ca - cb
   static const Torus32 AndYNConst = modSwitchToTorus32(-1, 8);
@@ -287,9 +321,7 @@ EXPORT void bootsANDYN(LweSample *result, const LweSample *ca,
 
   // if the phase is positive, the result is 1/8
   // if the phase is positive, else the result is -1/8
-  tfhe_bootstrap_FFT(result, bk->bkFFT, MU, temp_result);
-
-  delete_LweSample(temp_result);
+  bootsBootstrap(result, MU, temp_result, bk);
 }
 
 /*
@@ -303,7 +335,7 @@ EXPORT void bootsORNY(LweSample *result, const LweSample *ca,
   static const Torus32 MU = modSwitchToTorus32(1, 8);
   const LweParams *in_out_params = bk->params->in_out_params;
 
-  LweSample *temp_result = new_LweSample(in_out_params);
+  LweSample *temp_result = bootsTemp(bk, 0);
 
   // compute: (0,1/8) - ca + cb
   static const Torus32 OrNYConst = modSwitchToTorus32(1, 8);
@@ -313,9 +345,7 @@ EXPORT void bootsORNY(LweSample *result, const LweSample *ca,
 
   // if the phase is positive, the result is 1/8
   // if the phase is positive, else the result is -1/8
-  tfhe_bootstrap_FFT(result, bk->bkFFT, MU, temp_result);
-
-  delete_LweSample(temp_result);
+  bootsBootstrap(result, MU, temp_result, bk);
 }
 
 /*
@@ -329,7 +359,7 @@ EXPORT void bootsORYN(LweSample *result, const LweSample *ca,
   static const Torus32 MU = modSwitchToTorus32(1, 8);
   const LweParams *in_out_params = bk->params->in_out_params;
 
-  LweSample *temp_result = new_LweSample(in_out_params);
+  LweSample *temp_result = bootsTemp(bk, 0);
 
   // compute: (0,1/8) + ca - cb
   static const Torus32 OrYNConst = modSwitchToTorus32(1, 8);
@@ -339,9 +369,7 @@ EXPORT void bootsORYN(LweSample *result, const LweSample *ca,
 
   // if the phase is positive, the result is 1/8
   // if the phase is positive, else the result is -1/8
-  tfhe_bootstrap_FFT(result, bk->bkFFT, MU, temp_result);
-
-  delete_LweSample(temp_result);
+  bootsBootstrap(result, MU, temp_result, bk);
 }
 
 /*
@@ -357,10 +385,10 @@ EXPORT void bootsMUX(LweSample *result, const LweSample *a, const LweSample *b,
   const LweParams *extracted_params =
       &bk->params->tgsw_params->tlwe_params->extracted_lweparams;
 
-  LweSample *temp_result = new_LweSample(in_out_params);
-  LweSample *temp_result1 = new_LweSample(extracted_params);
-  LweSample *u1 = new_LweSample(extracted_params);
-  LweSample *u2 = new_LweSample(extracted_params);
+  LweSample *temp_result = bootsTemp(bk, 0);
+  LweSample *temp_result1 = bootsTemp(bk, 1);
+  LweSample *u1 = bootsTemp(bk, 2);
+  LweSample *u2 = bootsTemp(bk, 3);
 
   // compute "AND(a,b)": (0,-1/8) + a + b
   static const Torus32 AndConst = modSwitchToTorus32(-1, 8);
@@ -368,14 +396,14 @@ EXPORT void bootsMUX(LweSample *result, const LweSample *a, const LweSample *b,
   lweAddTo(temp_result, a, in_out_params);
   lweAddTo(temp_result, b, in_out_params);
   // Bootstrap without KeySwitch
-  tfhe_bootstrap_woKS_FFT(u1, bk->bkFFT, MU, temp_result);
+  bootsBootstrap_woKS(u1, MU, temp_result, bk);
 
   // compute "AND(not(a),c)": (0,-1/8) - a + c
   lweNoiselessTrivial(temp_result, AndConst, in_out_params);
   lweSubTo(temp_result, a, in_out_params);
   lweAddTo(temp_result, c, in_out_params);
   // Bootstrap without KeySwitch
-  tfhe_bootstrap_woKS_FFT(u2, bk->bkFFT, MU, temp_result);
+  bootsBootstrap_woKS(u2, MU, temp_result, bk);
 
   // Add u1=u1+u2
   static const Torus32 MuxConst = modSwitchToTorus32(1, 8);
@@ -383,10 +411,56 @@ EXPORT void bootsMUX(LweSample *result, const LweSample *a, const LweSample *b,
   lweAddTo(temp_result1, u1, extracted_params);
   lweAddTo(temp_result1, u2, extracted_params);
   // Key switching
-  lweKeySwitch(result, bk->bkFFT->ks, temp_result1);
+  bootsKeySwitch(result, temp_result1, bk);
+}
 
-  delete_LweSample(u2);
-  delete_LweSample(u1);
-  delete_LweSample(temp_result1);
-  delete_LweSample(temp_result);
+/*
+ * Homomorphic bootstrapped Majority(a,b,c): true iff at least two inputs
+ * are true (the carry of a full adder a+b+c)
+ * Takes in input 3 LWE samples (with message space [-1/8,1/8], noise<1/16)
+ * Outputs a LWE bootstrapped sample (with message space [-1/8,1/8], noise<1/16)
+ */
+EXPORT void bootsMAJ3(LweSample *result, const LweSample *ca,
+                      const LweSample *cb, const LweSample *cc,
+                      const TFheGateBootstrappingCloudKeySet *bk) {
+  static const Torus32 MU = modSwitchToTorus32(1, 8);
+  const LweParams *in_out_params = bk->params->in_out_params;
+
+  LweSample *temp_result = bootsTemp(bk, 0);
+
+  // compute: ca + cb + cc, in {-3/8,-1/8,1/8,3/8} for 0..3 true inputs
+  lweCopy(temp_result, ca, in_out_params);
+  lweAddTo(temp_result, cb, in_out_params);
+  lweAddTo(temp_result, cc, in_out_params);
+
+  // if the phase is positive, the result is 1/8
+  // if the phase is positive, else the result is -1/8
+  bootsBootstrap(result, MU, temp_result, bk);
+}
+
+/*
+ * Homomorphic bootstrapped Xor(a,b,c): true iff an odd number of inputs
+ * are true (the sum of a full adder a+b+c)
+ * Takes in input 3 LWE samples (with message space [-1/8,1/8], noise<1/16)
+ * Outputs a LWE bootstrapped sample (with message space [-1/8,1/8], noise<1/16)
+ */
+EXPORT void bootsXOR3(LweSample *result, const LweSample *ca,
+                      const LweSample *cb, const LweSample *cc,
+                      const TFheGateBootstrappingCloudKeySet *bk) {
+  static const Torus32 MU = modSwitchToTorus32(1, 8);
+  const LweParams *in_out_params = bk->params->in_out_params;
+
+  LweSample *temp_result = bootsTemp(bk, 0);
+
+  // compute: (0,1/2) + 2*(ca + cb + cc), in {-1/4,1/4,-1/4,1/4} for 0..3
+  // true inputs
+  static const Torus32 Xor3Const = modSwitchToTorus32(1, 2);
+  lweNoiselessTrivial(temp_result, Xor3Const, in_out_params);
+  lweAddMulTo(temp_result, 2, ca, in_out_params);
+  lweAddMulTo(temp_result, 2, cb, in_out_params);
+  lweAddMulTo(temp_result, 2, cc, in_out_params);
+
+  // if the phase is positive, the result is 1/8
+  // if the phase is positive, else the result is -1/8
+  bootsBootstrap(result, MU, temp_result, bk);
 }
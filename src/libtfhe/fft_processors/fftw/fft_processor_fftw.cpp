@@ -6,6 +6,7 @@
 #include <cassert>
 #include <cmath>
 #include <mutex>
+#include <vector>
 
 FFT_Processor_fftw::FFT_Processor_fftw(const int32_t N): _2N(2*N),N(N),Ns2(N/2) {
     rev_in = (double*) malloc(sizeof(double) * _2N);
@@ -48,7 +49,7 @@ void FFT_Processor_fftw::execute_reverse_torus32(cplx* res, const Torus32* a) {
 }
 void FFT_Processor_fftw::execute_direct_Torus32(Torus32* res, const cplx* a) {
     static const double _2p32 = double(INT64_C(1)<<32);
-    static const double _1sN = double(1)/double(N);
+    const double _1sN = double(1)/double(N);
     cplx* in_cplx = (cplx*) in; //fftw_complex and cplx are layout-compatible
     for (int32_t i=0; i<=Ns2; i++) in_cplx[2*i]=0;
     for (int32_t i=0; i<Ns2; i++) in_cplx[2*i+1]=a[i];
@@ -66,16 +67,67 @@ FFT_Processor_fftw::~FFT_Processor_fftw() {
     delete[] omegaxminus1;
 }
 
+namespace {
+// the FFT processors of a thread, indexed by log2(N), released when the thread exits
+struct ThreadFFTProcessors {
+    FFT_Processor_fftw* procs[32];
+
+    ThreadFFTProcessors() {
+        for (int32_t i=0; i<32; i++) procs[i]=0;
+    }
+
+    ~ThreadFFTProcessors() {
+        for (int32_t i=0; i<32; i++) delete procs[i];
+    }
+};
+
+thread_local ThreadFFTProcessors thread_fft_processors;
+}
+
+FFT_Processor_fftw* fft_processor_fftw(const int32_t N) {
+    const int32_t logN = __builtin_ctz(N);
+    assert(N == (1<<logN));
+    FFT_Processor_fftw*& proc = thread_fft_processors.procs[logN];
+    if (proc == 0) proc = new FFT_Processor_fftw(N);
+    return proc;
+}
 
 /**
  * FFT functions 
  */
 EXPORT void IntPolynomial_ifft(LagrangeHalfCPolynomial* result, const IntPolynomial* p) {
-    fp1024_fftw.execute_reverse_int(((LagrangeHalfCPolynomial_IMPL*)result)->coefsC, p->coefs);
+    fft_processor_fftw(p->N)->execute_reverse_int(((LagrangeHalfCPolynomial_IMPL*)result)->coefsC, p->coefs);
 }
 EXPORT void TorusPolynomial_ifft(LagrangeHalfCPolynomial* result, const TorusPolynomial* p) {
-    fp1024_fftw.execute_reverse_torus32(((LagrangeHalfCPolynomial_IMPL*)result)->coefsC, p->coefsT);
+    fft_processor_fftw(p->N)->execute_reverse_torus32(((LagrangeHalfCPolynomial_IMPL*)result)->coefsC, p->coefsT);
 }
 EXPORT void TorusPolynomial_fft(TorusPolynomial* result, const LagrangeHalfCPolynomial* p) {
-    fp1024_fftw.execute_direct_Torus32(result->coefsT, ((LagrangeHalfCPolynomial_IMPL*)p)->coefsC);
+    fft_processor_fftw(result->N)->execute_direct_Torus32(result->coefsT, ((LagrangeHalfCPolynomial_IMPL*)p)->coefsC);
+}
+
+// no batched kernel: one polynomial at a time
+EXPORT void IntPolynomial_ifft_batch(LagrangeHalfCPolynomial* results, const IntPolynomial* p, const int32_t count) {
+    for (int32_t j = 0; j < count; j++)
+        IntPolynomial_ifft(results + j, p + j);
+}
+
+EXPORT void TorusPolynomial_fft_batch(TorusPolynomial* results, LagrangeHalfCPolynomial* p, const int32_t count) {
+    for (int32_t j = 0; j < count; j++)
+        TorusPolynomial_fft(results + j, p + j);
+}
+
+// no fused kernel: the digits go through an integer buffer
+EXPORT void TorusPolynomial_decompH_ifft(LagrangeHalfCPolynomial* results, const TorusPolynomial* p,
+                                         const int32_t l, const int32_t Bgbit, const uint32_t offset) {
+    const int32_t N = p->N;
+    const uint32_t maskMod = (1u << Bgbit) - 1;
+    const int32_t halfBg = 1 << (Bgbit - 1);
+    static thread_local std::vector<int32_t> digit;
+    digit.resize(N);
+    for (int32_t j = 0; j < l; j++) {
+        const int32_t decal = 32 - (j + 1) * Bgbit;
+        for (int32_t i = 0; i < N; i++)
+            digit[i] = int32_t(((uint32_t(p->coefsT[i]) + offset) >> decal) & maskMod) - halfBg;
+        fft_processor_fftw(N)->execute_reverse_int(((LagrangeHalfCPolynomial_IMPL*)(results + j))->coefsC, digit.data());
+    }
 }
@@ -1,12 +1,14 @@
 #include <polynomials.h>
 #include "lagrangehalfc_impl.h"
 
-thread_local FFT_Processor_fftw fp1024_fftw(1024);
-
 LagrangeHalfCPolynomial_IMPL::LagrangeHalfCPolynomial_IMPL(const int32_t N) {
-    assert(N==1024);
     coefsC = new cplx[N/2];
-    proc = &fp1024_fftw;
+    proc = fft_processor_fftw(N);
+}
+
+LagrangeHalfCPolynomial_IMPL::LagrangeHalfCPolynomial_IMPL(const int32_t N, cplx* coefs) {
+    coefsC = coefs;
+    proc = fft_processor_fftw(N);
 }
 
 LagrangeHalfCPolynomial_IMPL::~LagrangeHalfCPolynomial_IMPL() {
@@ -36,6 +38,17 @@ EXPORT void destroy_LagrangeHalfCPolynomial_array(int32_t nbelts, LagrangeHalfCP
 	(objbis+i)->~LagrangeHalfCPolynomial_IMPL();
     }
 }
+
+EXPORT void init_LagrangeHalfCPolynomial_view(LagrangeHalfCPolynomial* obj, const int32_t N, double* coefs) {
+    new(obj) LagrangeHalfCPolynomial_IMPL(N, (cplx*) coefs);
+}
+
+EXPORT const double* LagrangeHalfCPolynomial_coefs(const LagrangeHalfCPolynomial* p) {
+    return (const double*) ((const LagrangeHalfCPolynomial_IMPL*) p)->coefsC;
+}
+
+//the N/2 complex values, interleaved
+EXPORT const char* LagrangeHalfCPolynomial_layout() { return "fftw"; }
  
 
 //MISC OPERATIONS
@@ -120,6 +133,29 @@ EXPORT void LagrangeHalfCPolynomialSubMul(
 	rr[i] -= aa[i]*bb[i];
 }
 
+EXPORT void LagrangeHalfCPolynomial_toFloat32(float* result, const LagrangeHalfCPolynomial* p) {
+    const LagrangeHalfCPolynomial_IMPL* p1 = (const LagrangeHalfCPolynomial_IMPL*) p;
+    const int32_t N = p1->proc->N;
+    const double* pp = (const double*) p1->coefsC;
+    for (int32_t i=0; i<N; i++)
+	result[i] = float(pp[i]);
+}
+
+/** termwise multiplication and addTo in Lagrange space, b being in single
+ * precision (the N/2 complex values, interleaved) */
+EXPORT void LagrangeHalfCPolynomialAddMulFloat32(
+	LagrangeHalfCPolynomial* accum,
+	const LagrangeHalfCPolynomial* a,
+	const float* b)
+{
+    LagrangeHalfCPolynomial_IMPL* result1 = (LagrangeHalfCPolynomial_IMPL*) accum;
+    const int32_t Ns2 = result1->proc->Ns2;
+    cplx* aa = ((LagrangeHalfCPolynomial_IMPL*) a)->coefsC;
+    cplx* rr = result1->coefsC;
+    for (int32_t i=0; i<Ns2; i++)
+	rr[i] += aa[i]*cplx(b[2*i],b[2*i+1]);
+}
+
 EXPORT void LagrangeHalfCPolynomialAddTo(
 	LagrangeHalfCPolynomial* accum, 
 	const LagrangeHalfCPolynomial* a) {
@@ -34,7 +34,9 @@ class FFT_Processor_fftw {
     ~FFT_Processor_fftw();
 };
 
-extern thread_local FFT_Processor_fftw fp1024_fftw;
+/** the FFT processor of the current thread for the dimension N (a power of
+ * two), created on first use */
+FFT_Processor_fftw* fft_processor_fftw(const int32_t N);
 
 /**
  * structure that represents a real polynomial P mod X^N+1
@@ -48,6 +50,8 @@ struct LagrangeHalfCPolynomial_IMPL
    FFT_Processor_fftw* proc;
 
    LagrangeHalfCPolynomial_IMPL(int32_t N);
+   // on external coefficients (must not be destroyed, see init_LagrangeHalfCPolynomial_view)
+   LagrangeHalfCPolynomial_IMPL(int32_t N, cplx *coefs);
    ~LagrangeHalfCPolynomial_IMPL();
 };
 
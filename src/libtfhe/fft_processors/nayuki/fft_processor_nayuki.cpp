@@ -4,6 +4,7 @@
 #include "fft.h"
 #include <cassert>
 #include <cmath>
+#include <vector>
 
 FFT_Processor_nayuki::FFT_Processor_nayuki(const int32_t N): _2N(2*N),N(N),Ns2(N/2) {
     real_inout = (double*) malloc(sizeof(double) * _2N);
@@ -17,10 +18,13 @@ FFT_Processor_nayuki::FFT_Processor_nayuki(const int32_t N): _2N(2*N),N(N),Ns2(N
     }
 }
 
+// the direct transform outputs N times the coefficients: its rounding
+// errors are compared to the coefficients (the thresholds are those of N=1024)
 void FFT_Processor_nayuki::check_alternate_real() {
 #ifndef NDEBUG
-    for (int32_t i=0; i<_2N; i++) assert(fabs(imag_inout[i])<1e-8);
-    for (int32_t i=0; i<N; i++) assert(fabs(real_inout[i]+real_inout[N+i])<1e-9);
+    const double scale = N/1024.;
+    for (int32_t i=0; i<_2N; i++) assert(fabs(imag_inout[i])<1e-8*scale);
+    for (int32_t i=0; i<N; i++) assert(fabs(real_inout[i]+real_inout[N+i])<1e-9*scale);
 #endif
 }
 
@@ -62,7 +66,7 @@ void FFT_Processor_nayuki::execute_reverse_torus32(cplx* res, const Torus32* a)
 
 void FFT_Processor_nayuki::execute_direct_torus32(Torus32* res, const cplx* a) {
     static const double _2p32 = double(INT64_C(1)<<32);
-    static const double _1sN = double(1)/double(N);
+    const double _1sN = double(1)/double(N);
     //double* a_dbl=(double*) a;
     for (int32_t i=0; i<N; i++) real_inout[2*i]=0;
     for (int32_t i=0; i<N; i++) imag_inout[2*i]=0;
@@ -93,20 +97,70 @@ FFT_Processor_nayuki::~FFT_Processor_nayuki() {
     free(omegaxminus1);    
 }
 
-thread_local FFT_Processor_nayuki fp1024_nayuki(1024);
+namespace {
+// the FFT processors of a thread, indexed by log2(N), released when the thread exits
+struct ThreadFFTProcessors {
+    FFT_Processor_nayuki* procs[32];
+
+    ThreadFFTProcessors() {
+        for (int32_t i=0; i<32; i++) procs[i]=0;
+    }
+
+    ~ThreadFFTProcessors() {
+        for (int32_t i=0; i<32; i++) delete procs[i];
+    }
+};
+
+thread_local ThreadFFTProcessors thread_fft_processors;
+}
+
+FFT_Processor_nayuki* fft_processor_nayuki(const int32_t N) {
+    const int32_t logN = __builtin_ctz(N);
+    assert(N == (1<<logN));
+    FFT_Processor_nayuki*& proc = thread_fft_processors.procs[logN];
+    if (proc == 0) proc = new FFT_Processor_nayuki(N);
+    return proc;
+}
 
 /**
  * FFT functions 
  */
 EXPORT void IntPolynomial_ifft(LagrangeHalfCPolynomial* result, const IntPolynomial* p) {
     LagrangeHalfCPolynomial_IMPL* r = (LagrangeHalfCPolynomial_IMPL*) result;
-    fp1024_nayuki.execute_reverse_int(r->coefsC, p->coefs);
+    fft_processor_nayuki(p->N)->execute_reverse_int(r->coefsC, p->coefs);
 }
 EXPORT void TorusPolynomial_ifft(LagrangeHalfCPolynomial* result, const TorusPolynomial* p) {
     LagrangeHalfCPolynomial_IMPL* r = (LagrangeHalfCPolynomial_IMPL*) result;
-    fp1024_nayuki.execute_reverse_torus32(r->coefsC, p->coefsT);
+    fft_processor_nayuki(p->N)->execute_reverse_torus32(r->coefsC, p->coefsT);
 }
 EXPORT void TorusPolynomial_fft(TorusPolynomial* result, const LagrangeHalfCPolynomial* p) {
     LagrangeHalfCPolynomial_IMPL* r = (LagrangeHalfCPolynomial_IMPL*) p;
-    fp1024_nayuki.execute_direct_torus32(result->coefsT, r->coefsC);
+    fft_processor_nayuki(result->N)->execute_direct_torus32(result->coefsT, r->coefsC);
+}
+
+// no batched kernel: one polynomial at a time
+EXPORT void IntPolynomial_ifft_batch(LagrangeHalfCPolynomial* results, const IntPolynomial* p, const int32_t count) {
+    for (int32_t j = 0; j < count; j++)
+        IntPolynomial_ifft(results + j, p + j);
+}
+
+EXPORT void TorusPolynomial_fft_batch(TorusPolynomial* results, LagrangeHalfCPolynomial* p, const int32_t count) {
+    for (int32_t j = 0; j < count; j++)
+        TorusPolynomial_fft(results + j, p + j);
+}
+
+// no fused kernel: the digits go through an integer buffer
+EXPORT void TorusPolynomial_decompH_ifft(LagrangeHalfCPolynomial* results, const TorusPolynomial* p,
+                                         const int32_t l, const int32_t Bgbit, const uint32_t offset) {
+    const int32_t N = p->N;
+    const uint32_t maskMod = (1u << Bgbit) - 1;
+    const int32_t halfBg = 1 << (Bgbit - 1);
+    static thread_local std::vector<int32_t> digit;
+    digit.resize(N);
+    for (int32_t j = 0; j < l; j++) {
+        const int32_t decal = 32 - (j + 1) * Bgbit;
+        for (int32_t i = 0; i < N; i++)
+            digit[i] = int32_t(((uint32_t(p->coefsT[i]) + offset) >> decal) & maskMod) - halfBg;
+        fft_processor_nayuki(N)->execute_reverse_int(((LagrangeHalfCPolynomial_IMPL*)(results + j))->coefsC, digit.data());
+    }
 }
@@ -31,7 +31,9 @@ class FFT_Processor_nayuki {
     ~FFT_Processor_nayuki();
 };
 
-extern thread_local FFT_Processor_nayuki fp1024_nayuki;
+/** the FFT processor of the current thread for the dimension N (a power of
+ * two), created on first use */
+FFT_Processor_nayuki* fft_processor_nayuki(const int32_t N);
 
 /**
  * structure that represents a real polynomial P mod X^N+1
@@ -45,6 +47,8 @@ struct LagrangeHalfCPolynomial_IMPL
    FFT_Processor_nayuki* proc;
 
    LagrangeHalfCPolynomial_IMPL(int32_t N);
+   // on external coefficients (must not be destroyed, see init_LagrangeHalfCPolynomial_view)
+   LagrangeHalfCPolynomial_IMPL(int32_t N, cplx *coefs);
    ~LagrangeHalfCPolynomial_IMPL();
 };
 
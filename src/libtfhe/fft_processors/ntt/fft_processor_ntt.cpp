@@ -0,0 +1,429 @@
+#include <polynomials.h>
+#include "lagrangehalfc_impl.h"
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+using namespace ntt;
+
+namespace {
+// P0-1 and P1-1 are multiples of 2^25: N can go up to 2^24
+const int32_t LOG_MAX_2N = 25;
+
+uint32_t mulMod(const uint32_t a, const uint32_t b, const uint32_t p) {
+    return uint32_t((uint64_t(a) * b) % p);
+}
+
+uint32_t powMod(uint32_t a, uint64_t e, const uint32_t p) {
+    uint32_t r = 1;
+    for (; e; e >>= 1) {
+        if (e & 1) r = mulMod(r, a, p);
+        a = mulMod(a, a, p);
+    }
+    return r;
+}
+
+int32_t bitReverse(int32_t x, const int32_t logN) {
+    int32_t r = 0;
+    for (int32_t i = 0; i < logN; i++, x >>= 1)
+        r = (r << 1) | (x & 1);
+    return r;
+}
+
+// The stages t=4,2,1 of the AVX2 transforms work on blocks of 16 residues
+// (two vectors A,B): the lanes of A and B are permuted by LANE_PERM so that
+// the low halves hold the x of the butterflies and the high halves their y,
+// then x=[A.lo,B.lo] and y=[A.hi,B.hi]. LANE_PERM_INV puts them back.
+const int32_t LANE_PERM[3][8] = {
+    {0, 2, 4, 6, 1, 3, 5, 7},   // t=1
+    {0, 1, 4, 5, 2, 3, 6, 7},   // t=2
+    {0, 1, 2, 3, 4, 5, 6, 7}};  // t=4
+const int32_t LANE_PERM_INV[3][8] = {
+    {0, 4, 1, 5, 2, 6, 3, 7},
+    {0, 1, 4, 5, 2, 3, 6, 7},
+    {0, 1, 2, 3, 4, 5, 6, 7}};
+
+#ifdef __AVX2__
+inline __m256i load8(const uint32_t* a) {
+    return _mm256_loadu_si256((const __m256i*) a);
+}
+
+inline void store8(uint32_t* a, const __m256i x) {
+    _mm256_storeu_si256((__m256i*) a, x);
+}
+
+inline __m256i set8(const uint32_t x) {
+    return _mm256_set1_epi32(int32_t(x));
+}
+
+// Cooley-Tukey butterfly, x,y in [0,2p[ -> x+wy, x-wy in [0,2p[
+inline void butterflyCT8(__m256i& x, __m256i& y, const __m256i w, const __m256i wp, const __m256i p) {
+    const __m256i u = reduce8(x, p);
+    const __m256i v = reduce8(mulShoupLazy8(y, w, wp, p), p);
+    x = _mm256_add_epi32(u, v);
+    y = _mm256_sub_epi32(_mm256_add_epi32(u, p), v);
+}
+
+// Gentleman-Sande butterfly, x,y in [0,2p[ -> x+y, w(x-y) in [0,2p[
+inline void butterflyGS8(__m256i& x, __m256i& y, const __m256i w, const __m256i wp, const __m256i p) {
+    const __m256i u = reduce8(x, p);
+    const __m256i v = reduce8(y, p);
+    x = _mm256_add_epi32(u, v);
+    y = mulShoupLazy8(_mm256_sub_epi32(_mm256_add_epi32(u, p), v), w, wp, p);
+}
+
+// one stage t in {1,2,4} over the blocks of 16 residues, with the twiddles
+// in lane order
+template<bool forward>
+void smallStage8(uint32_t* a, const int32_t N, const int32_t s, const uint32_t* tw, const uint32_t* tws,
+                 const __m256i p) {
+    const __m256i perm = _mm256_loadu_si256((const __m256i*) LANE_PERM[s]);
+    const __m256i perm_inv = _mm256_loadu_si256((const __m256i*) LANE_PERM_INV[s]);
+    for (int32_t blk = 0; blk < N / 16; blk++) {
+        uint32_t* ab = a + 16 * blk;
+        const __m256i A = _mm256_permutevar8x32_epi32(load8(ab), perm);
+        const __m256i B = _mm256_permutevar8x32_epi32(load8(ab + 8), perm);
+        __m256i x = _mm256_permute2x128_si256(A, B, 0x20);
+        __m256i y = _mm256_permute2x128_si256(A, B, 0x31);
+        if (forward)
+            butterflyCT8(x, y, load8(tw + 8 * blk), load8(tws + 8 * blk), p);
+        else
+            butterflyGS8(x, y, load8(tw + 8 * blk), load8(tws + 8 * blk), p);
+        store8(ab, _mm256_permutevar8x32_epi32(_mm256_permute2x128_si256(x, y, 0x20), perm_inv));
+        store8(ab + 8, _mm256_permutevar8x32_epi32(_mm256_permute2x128_si256(x, y, 0x31), perm_inv));
+    }
+}
+#endif
+}
+
+void FFT_Processor_ntt::initModulus(Modulus& m, const uint32_t p, const uint32_t generator, const int32_t logN) {
+    m.p = p;
+    uint32_t inv = p; // p^-1 mod 2^32 by Newton iterations (p.p = 1 mod 8)
+    for (int32_t i = 0; i < 4; i++) inv *= 2 - p * inv;
+    assert(p * inv == 1);
+    m.pinv = -inv;
+    m.R = uint32_t((uint64_t(1) << 32) % p);
+    m.R_shoup = shoup(m.R, p);
+    m.scale = mulMod(powMod(N, p - 2, p), powMod(m.R, p - 2, p), p);
+    m.scale_shoup = shoup(m.scale, p);
+
+    m.psi_rev = new uint32_t[N];
+    m.psi_rev_shoup = new uint32_t[N];
+    m.psi_inv_rev = new uint32_t[N];
+    m.psi_inv_rev_shoup = new uint32_t[N];
+    m.xaiminus1 = new uint32_t[_2N];
+
+    // psi^x for x in [0,2N[
+    const uint32_t root = powMod(generator, (p - 1) >> LOG_MAX_2N, p);
+    const uint32_t psi = powMod(root, UINT64_C(1) << (LOG_MAX_2N - logN - 1), p);
+    std::vector<uint32_t> psi_pow(_2N);
+    psi_pow[0] = 1;
+    for (int32_t x = 1; x < _2N; x++) psi_pow[x] = mulMod(psi_pow[x-1], psi, p);
+    assert(psi_pow[N] == p - 1);
+    for (int32_t i = 0; i < N; i++) {
+        const int32_t r = bitReverse(i, logN);
+        m.psi_rev[i] = psi_pow[r];
+        m.psi_rev_shoup[i] = shoup(m.psi_rev[i], p);
+        m.psi_inv_rev[i] = psi_pow[(_2N - r) % _2N];
+        m.psi_inv_rev_shoup[i] = shoup(m.psi_inv_rev[i], p);
+    }
+    for (int32_t x = 0; x < _2N; x++)
+        m.xaiminus1[x] = mulShoup(sub(psi_pow[x], 1, p), m.R, m.R_shoup, p);
+
+    // the stage t uses the twiddles of the group i = index/2t, starting at N/2t
+    for (int32_t s = 0; s < 3; s++) {
+        m.lane_tw[s] = m.lane_tw_shoup[s] = m.lane_inv_tw[s] = m.lane_inv_tw_shoup[s] = 0;
+        if (N < 16) continue;
+        const int32_t t = 1 << s;
+        m.lane_tw[s] = new uint32_t[Ns2];
+        m.lane_tw_shoup[s] = new uint32_t[Ns2];
+        m.lane_inv_tw[s] = new uint32_t[Ns2];
+        m.lane_inv_tw_shoup[s] = new uint32_t[Ns2];
+        for (int32_t blk = 0; blk < N / 16; blk++)
+            for (int32_t L = 0; L < 8; L++) {
+                const int32_t e = L < 4 ? LANE_PERM[s][L] : 8 + LANE_PERM[s][L - 4];
+                const int32_t i = N / (2 * t) + (16 * blk + e) / (2 * t);
+                m.lane_tw[s][8 * blk + L] = m.psi_rev[i];
+                m.lane_tw_shoup[s][8 * blk + L] = m.psi_rev_shoup[i];
+                m.lane_inv_tw[s][8 * blk + L] = m.psi_inv_rev[i];
+                m.lane_inv_tw_shoup[s][8 * blk + L] = m.psi_inv_rev_shoup[i];
+            }
+    }
+}
+
+FFT_Processor_ntt::FFT_Processor_ntt(const int32_t N): _2N(2*N),N(N),Ns2(N/2) {
+    const int32_t logN = __builtin_ctz(N);
+    assert(N == (1<<logN) && logN < LOG_MAX_2N);
+    buf = new uint32_t[NB_PRIMES * N];
+    eval_exp = new int32_t[N];
+    initModulus(mod[0], P0, 5, logN);
+    initModulus(mod[1], P1, 31, logN);
+    // the forward transform outputs the evaluations in bit-reversed order
+    for (int32_t i = 0; i < N; i++)
+        eval_exp[i] = 2 * bitReverse(i, logN) + 1;
+    crt_c = powMod(P0 % P1, P1 - 2, P1);
+    crt_c_shoup = shoup(crt_c, P1);
+}
+
+// negacyclic Cooley-Tukey transform, natural order in, bit-reversed order
+// out (the values stay in [0,2p[)
+void FFT_Processor_ntt::forward(uint32_t* a, const Modulus& md) {
+    const uint32_t p = md.p;
+    int32_t m = 1;
+    int32_t t = N;
+#ifdef __AVX2__
+    if (N >= 16) {
+        const __m256i p8 = set8(p);
+        for (; m < N / 8; m <<= 1) {
+            t >>= 1;
+            for (int32_t i = 0; i < m; i++) {
+                const __m256i w = set8(md.psi_rev[m + i]);
+                const __m256i wp = set8(md.psi_rev_shoup[m + i]);
+                uint32_t* x = a + 2 * i * t;
+                uint32_t* y = x + t;
+                for (int32_t j = 0; j < t; j += 8) {
+                    __m256i xj = load8(x + j);
+                    __m256i yj = load8(y + j);
+                    butterflyCT8(xj, yj, w, wp, p8);
+                    store8(x + j, xj);
+                    store8(y + j, yj);
+                }
+            }
+        }
+        for (int32_t s = 2; s >= 0; s--)
+            smallStage8<true>(a, N, s, md.lane_tw[s], md.lane_tw_shoup[s], p8);
+        for (int32_t i = 0; i < N; i += 8)
+            store8(a + i, reduce8(load8(a + i), p8));
+        return;
+    }
+#endif
+    for (; m < N; m <<= 1) {
+        t >>= 1;
+        for (int32_t i = 0; i < m; i++) {
+            const uint32_t w = md.psi_rev[m + i];
+            const uint32_t wp = md.psi_rev_shoup[m + i];
+            uint32_t* x = a + 2 * i * t;
+            uint32_t* y = x + t;
+            for (int32_t j = 0; j < t; j++) {
+                const uint32_t u = reduce(x[j], p);
+                const uint32_t v = reduce(mulShoupLazy(y[j], w, wp, p), p);
+                x[j] = u + v;
+                y[j] = u + p - v;
+            }
+        }
+    }
+    for (int32_t i = 0; i < N; i++)
+        a[i] = reduce(a[i], p);
+}
+
+// Gentleman-Sande transform, bit-reversed order in, natural order out (the
+// values stay in [0,2p[), followed by the multiplication by N^-1.2^-32
+void FFT_Processor_ntt::inverse(uint32_t* a, const Modulus& md) {
+    const uint32_t p = md.p;
+    int32_t t = 1;
+    int32_t m = N;
+#ifdef __AVX2__
+    if (N >= 16) {
+        const __m256i p8 = set8(p);
+        for (int32_t s = 0; s < 3; s++)
+            smallStage8<false>(a, N, s, md.lane_inv_tw[s], md.lane_inv_tw_shoup[s], p8);
+        for (t = 8, m = N / 8; m > 1; m >>= 1, t <<= 1) {
+            const int32_t h = m >> 1;
+            for (int32_t i = 0; i < h; i++) {
+                const __m256i w = set8(md.psi_inv_rev[h + i]);
+                const __m256i wp = set8(md.psi_inv_rev_shoup[h + i]);
+                uint32_t* x = a + 2 * i * t;
+                uint32_t* y = x + t;
+                for (int32_t j = 0; j < t; j += 8) {
+                    __m256i xj = load8(x + j);
+                    __m256i yj = load8(y + j);
+                    butterflyGS8(xj, yj, w, wp, p8);
+                    store8(x + j, xj);
+                    store8(y + j, yj);
+                }
+            }
+        }
+        const __m256i scale = set8(md.scale);
+        const __m256i scale_shoup = set8(md.scale_shoup);
+        for (int32_t i = 0; i < N; i += 8)
+            store8(a + i, reduce8(mulShoupLazy8(load8(a + i), scale, scale_shoup, p8), p8));
+        return;
+    }
+#endif
+    for (; m > 1; m >>= 1) {
+        const int32_t h = m >> 1;
+        for (int32_t i = 0; i < h; i++) {
+            const uint32_t w = md.psi_inv_rev[h + i];
+            const uint32_t wp = md.psi_inv_rev_shoup[h + i];
+            uint32_t* x = a + 2 * i * t;
+            uint32_t* y = x + t;
+            for (int32_t j = 0; j < t; j++) {
+                const uint32_t u = reduce(x[j], p);
+                const uint32_t v = reduce(y[j], p);
+                x[j] = u + v;
+                y[j] = mulShoupLazy(u + p - v, w, wp, p);
+            }
+        }
+        t <<= 1;
+    }
+    for (int32_t i = 0; i < N; i++)
+        a[i] = mulShoup(a[i], md.scale, md.scale_shoup, p);
+}
+
+// the Montgomery forms of the signed integers a
+void FFT_Processor_ntt::toMontArray(uint32_t* res, const int32_t* a, const Modulus& md) {
+    const uint32_t p = md.p;
+    int32_t i = 0;
+#ifdef __AVX2__
+    const __m256i p8 = set8(p);
+    const __m256i p2 = set8(2 * p);
+    const __m256i R = set8(md.R);
+    const __m256i R_shoup = set8(md.R_shoup);
+    for (; i + 8 <= N; i += 8) {
+        __m256i x = load8((const uint32_t*) (a + i));
+        // + 2p for the negative ones
+        x = _mm256_add_epi32(x, _mm256_and_si256(_mm256_srai_epi32(x, 31), p2));
+        store8(res + i, reduce8(mulShoupLazy8(x, R, R_shoup, p8), p8));
+    }
+#endif
+    for (; i < N; i++)
+        res[i] = mulShoup(fromInt32(a[i], p), md.R, md.R_shoup, p);
+}
+
+void FFT_Processor_ntt::execute_reverse_int(uint32_t* res, const int32_t* a) {
+    for (int32_t q = 0; q < NB_PRIMES; q++) {
+        toMontArray(res + q * N, a, mod[q]);
+        forward(res + q * N, mod[q]);
+    }
+}
+
+void FFT_Processor_ntt::execute_reverse_torus32(uint32_t* res, const Torus32* a) {
+    execute_reverse_int(res, a);
+}
+
+// Garner: v = v0 + P0.t with t = (v1-v0)/P0 mod P1, in [0,Q[, is the exact
+// coefficient if v < Q/2, and v-Q otherwise. Only its residue mod 2^32 is
+// needed: v > Q/2 iff t > (P1-1)/2, or t = (P1-1)/2 and v0 > (P0-1)/2.
+void FFT_Processor_ntt::execute_direct_torus32(Torus32* res, const uint32_t* a) {
+    static const uint32_t H0 = (P0 - 1) / 2;
+    static const uint32_t H1 = (P1 - 1) / 2;
+    static const uint32_t Q = uint32_t(uint64_t(P0) * P1);
+    memcpy(buf, a, NB_PRIMES * N * sizeof(uint32_t));
+    for (int32_t q = 0; q < NB_PRIMES; q++)
+        inverse(buf + q * N, mod[q]);
+    const uint32_t* v0 = buf;
+    const uint32_t* v1 = buf + N;
+    int32_t i = 0;
+#ifdef __AVX2__
+    const __m256i p0 = set8(P0);
+    const __m256i p1 = set8(P1);
+    const __m256i c = set8(crt_c);
+    const __m256i c_shoup = set8(crt_c_shoup);
+    const __m256i h0 = set8(H0);
+    const __m256i h1 = set8(H1);
+    const __m256i q8 = set8(Q);
+    for (; i + 8 <= N; i += 8) {
+        const __m256i x0 = load8(v0 + i);
+        const __m256i d = reduce8(_mm256_sub_epi32(_mm256_add_epi32(load8(v1 + i), p1), reduce8(x0, p1)), p1);
+        const __m256i t = reduce8(mulShoupLazy8(d, c, c_shoup, p1), p1);
+        // (the values are below 2^31: the signed comparisons are fine)
+        const __m256i neg = _mm256_or_si256(_mm256_cmpgt_epi32(t, h1),
+                                            _mm256_and_si256(_mm256_cmpeq_epi32(t, h1), _mm256_cmpgt_epi32(x0, h0)));
+        const __m256i v = _mm256_add_epi32(x0, _mm256_mullo_epi32(t, p0));
+        store8((uint32_t*) (res + i), _mm256_sub_epi32(v, _mm256_and_si256(neg, q8)));
+    }
+#endif
+    for (; i < N; i++) {
+        const uint32_t d = sub(v1[i], reduce(v0[i], P1), P1);
+        const uint32_t t = mulShoup(d, crt_c, crt_c_shoup, P1);
+        const bool neg = t > H1 || (t == H1 && v0[i] > H0);
+        res[i] = Torus32(v0[i] + t * P0 - (neg ? Q : 0));
+    }
+}
+
+FFT_Processor_ntt::~FFT_Processor_ntt() {
+    for (int32_t q = 0; q < NB_PRIMES; q++) {
+        Modulus& m = mod[q];
+        for (int32_t s = 0; s < 3; s++) {
+            delete[] m.lane_tw[s];
+            delete[] m.lane_tw_shoup[s];
+            delete[] m.lane_inv_tw[s];
+            delete[] m.lane_inv_tw_shoup[s];
+        }
+        delete[] m.psi_rev;
+        delete[] m.psi_rev_shoup;
+        delete[] m.psi_inv_rev;
+        delete[] m.psi_inv_rev_shoup;
+        delete[] m.xaiminus1;
+    }
+    delete[] buf;
+    delete[] eval_exp;
+}
+
+namespace {
+// the NTT processors of a thread, indexed by log2(N), released when the thread exits
+struct ThreadFFTProcessors {
+    FFT_Processor_ntt* procs[32];
+
+    ThreadFFTProcessors() {
+        for (int32_t i=0; i<32; i++) procs[i]=0;
+    }
+
+    ~ThreadFFTProcessors() {
+        for (int32_t i=0; i<32; i++) delete procs[i];
+    }
+};
+
+thread_local ThreadFFTProcessors thread_fft_processors;
+}
+
+FFT_Processor_ntt* fft_processor_ntt(const int32_t N) {
+    const int32_t logN = __builtin_ctz(N);
+    assert(N == (1<<logN));
+    FFT_Processor_ntt*& proc = thread_fft_processors.procs[logN];
+    if (proc == 0) proc = new FFT_Processor_ntt(N);
+    return proc;
+}
+
+/**
+ * FFT functions
+ */
+EXPORT void IntPolynomial_ifft(LagrangeHalfCPolynomial* result, const IntPolynomial* p) {
+    LagrangeHalfCPolynomial_IMPL* r = (LagrangeHalfCPolynomial_IMPL*) result;
+    fft_processor_ntt(p->N)->execute_reverse_int(r->coefs, p->coefs);
+}
+EXPORT void TorusPolynomial_ifft(LagrangeHalfCPolynomial* result, const TorusPolynomial* p) {
+    LagrangeHalfCPolynomial_IMPL* r = (LagrangeHalfCPolynomial_IMPL*) result;
+    fft_processor_ntt(p->N)->execute_reverse_torus32(r->coefs, p->coefsT);
+}
+EXPORT void TorusPolynomial_fft(TorusPolynomial* result, const LagrangeHalfCPolynomial* p) {
+    LagrangeHalfCPolynomial_IMPL* r = (LagrangeHalfCPolynomial_IMPL*) p;
+    fft_processor_ntt(result->N)->execute_direct_torus32(result->coefsT, r->coefs);
+}
+
+// no batched kernel: one polynomial at a time
+EXPORT void IntPolynomial_ifft_batch(LagrangeHalfCPolynomial* results, const IntPolynomial* p, const int32_t count) {
+    for (int32_t j = 0; j < count; j++)
+        IntPolynomial_ifft(results + j, p + j);
+}
+
+EXPORT void TorusPolynomial_fft_batch(TorusPolynomial* results, LagrangeHalfCPolynomial* p, const int32_t count) {
+    for (int32_t j = 0; j < count; j++)
+        TorusPolynomial_fft(results + j, p + j);
+}
+
+// no fused kernel: the digits go through an integer buffer
+EXPORT void TorusPolynomial_decompH_ifft(LagrangeHalfCPolynomial* results, const TorusPolynomial* p,
+                                         const int32_t l, const int32_t Bgbit, const uint32_t offset) {
+    const int32_t N = p->N;
+    const uint32_t maskMod = (1u << Bgbit) - 1;
+    const int32_t halfBg = 1 << (Bgbit - 1);
+    static thread_local std::vector<int32_t> digit;
+    digit.resize(N);
+    for (int32_t j = 0; j < l; j++) {
+        const int32_t decal = 32 - (j + 1) * Bgbit;
+        for (int32_t i = 0; i < N; i++)
+            digit[i] = int32_t(((uint32_t(p->coefsT[i]) + offset) >> decal) & maskMod) - halfBg;
+        fft_processor_ntt(N)->execute_reverse_int(((LagrangeHalfCPolynomial_IMPL*)(results + j))->coefs, digit.data());
+    }
+}
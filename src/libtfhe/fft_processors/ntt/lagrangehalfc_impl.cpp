@@ -0,0 +1,228 @@
+#include <polynomials.h>
+#include "lagrangehalfc_impl.h"
+
+using namespace ntt;
+
+LagrangeHalfCPolynomial_IMPL::LagrangeHalfCPolynomial_IMPL(const int32_t N) {
+    coefs = new uint32_t[ntt::NB_PRIMES * N];
+    proc = fft_processor_ntt(N);
+}
+
+LagrangeHalfCPolynomial_IMPL::LagrangeHalfCPolynomial_IMPL(const int32_t N, uint32_t* coefs) {
+    this->coefs = coefs;
+    proc = fft_processor_ntt(N);
+}
+
+LagrangeHalfCPolynomial_IMPL::~LagrangeHalfCPolynomial_IMPL() {
+    delete[] coefs;
+}
+
+//initialize the key structure
+//(equivalent of the C++ constructor)
+EXPORT void init_LagrangeHalfCPolynomial(LagrangeHalfCPolynomial* obj, const int32_t N) {
+    new(obj) LagrangeHalfCPolynomial_IMPL(N);
+}
+EXPORT void init_LagrangeHalfCPolynomial_array(int32_t nbelts, LagrangeHalfCPolynomial* obj, const int32_t N) {
+    for (int32_t i=0; i<nbelts; i++) {
+	new(obj+i) LagrangeHalfCPolynomial_IMPL(N);
+    }
+}
+
+//destroys the LagrangeHalfCPolynomial structure
+//(equivalent of the C++ destructor)
+EXPORT void destroy_LagrangeHalfCPolynomial(LagrangeHalfCPolynomial* obj) {
+    LagrangeHalfCPolynomial_IMPL* objbis = (LagrangeHalfCPolynomial_IMPL*) obj;
+    objbis->~LagrangeHalfCPolynomial_IMPL();
+}
+EXPORT void destroy_LagrangeHalfCPolynomial_array(int32_t nbelts, LagrangeHalfCPolynomial* obj) {
+    LagrangeHalfCPolynomial_IMPL* objbis = (LagrangeHalfCPolynomial_IMPL*) obj;
+    for (int32_t i=0; i<nbelts; i++) {
+	(objbis+i)->~LagrangeHalfCPolynomial_IMPL();
+    }
+}
+
+// the 2N residues take the room of N doubles
+EXPORT void init_LagrangeHalfCPolynomial_view(LagrangeHalfCPolynomial* obj, const int32_t N, double* coefs) {
+    new(obj) LagrangeHalfCPolynomial_IMPL(N, (uint32_t*) coefs);
+}
+
+EXPORT const double* LagrangeHalfCPolynomial_coefs(const LagrangeHalfCPolynomial* p) {
+    return (const double*) ((const LagrangeHalfCPolynomial_IMPL*) p)->coefs;
+}
+
+//the N residues mod P0 then the N residues mod P1 (Montgomery form), in
+//bit-reversed order
+EXPORT const char* LagrangeHalfCPolynomial_layout() { return "ntt-crt"; }
+
+
+//MISC OPERATIONS
+/** sets to zero */
+EXPORT void LagrangeHalfCPolynomialClear(
+	LagrangeHalfCPolynomial* reps) {
+    LagrangeHalfCPolynomial_IMPL* reps1 = (LagrangeHalfCPolynomial_IMPL*) reps;
+    const int32_t N = reps1->proc->N;
+    for (int32_t i=0; i<NB_PRIMES*N; i++)
+	reps1->coefs[i] = 0;
+}
+
+// the constant polynomial mu takes the value mu at every root
+EXPORT void LagrangeHalfCPolynomialSetTorusConstant(LagrangeHalfCPolynomial* result, const Torus32 mu) {
+    LagrangeHalfCPolynomial_IMPL* result1 = (LagrangeHalfCPolynomial_IMPL*) result;
+    const int32_t N = result1->proc->N;
+    for (int32_t q=0; q<NB_PRIMES; q++) {
+	uint32_t* b = result1->coefs + q*N;
+	const uint32_t muc = result1->proc->toMont(mu, q);
+	for (int32_t j=0; j<N; j++)
+	    b[j]=muc;
+    }
+}
+
+EXPORT void LagrangeHalfCPolynomialAddTorusConstant(LagrangeHalfCPolynomial* result, const Torus32 mu) {
+    LagrangeHalfCPolynomial_IMPL* result1 = (LagrangeHalfCPolynomial_IMPL*) result;
+    const int32_t N = result1->proc->N;
+    for (int32_t q=0; q<NB_PRIMES; q++) {
+	uint32_t* b = result1->coefs + q*N;
+	const uint32_t p = result1->proc->modulus(q).p;
+	const uint32_t muc = result1->proc->toMont(mu, q);
+	for (int32_t j=0; j<N; j++)
+	    b[j]=add(b[j],muc,p);
+    }
+}
+
+EXPORT void LagrangeHalfCPolynomialSetXaiMinusOne(LagrangeHalfCPolynomial* result, const int32_t ai) {
+    LagrangeHalfCPolynomial_IMPL* result1 = (LagrangeHalfCPolynomial_IMPL*) result;
+    const FFT_Processor_ntt* proc = result1->proc;
+    const int32_t N = proc->N;
+    const int32_t _2N = proc->_2N;
+    for (int32_t q=0; q<NB_PRIMES; q++) {
+	const uint32_t* xaiminus1 = proc->modulus(q).xaiminus1;
+	for (int32_t i=0; i<N; i++)
+	    result1->coefs[q*N+i]=xaiminus1[(int64_t(proc->eval_exp[i])*ai)%_2N];
+    }
+}
+
+// The termwise operations handle the N residues of each prime, 8 at a time
+// with AVX2
+#ifdef __AVX2__
+namespace {
+inline __m256i load8(const uint32_t* a) {
+    return _mm256_loadu_si256((const __m256i*) a);
+}
+
+inline void store8(uint32_t* a, const __m256i x) {
+    _mm256_storeu_si256((__m256i*) a, x);
+}
+}
+#endif
+
+/** termwise multiplication in Lagrange space */
+EXPORT void LagrangeHalfCPolynomialMul(
+	LagrangeHalfCPolynomial* result,
+	const LagrangeHalfCPolynomial* a,
+	const LagrangeHalfCPolynomial* b) {
+    LagrangeHalfCPolynomial_IMPL* result1 = (LagrangeHalfCPolynomial_IMPL*) result;
+    const int32_t N = result1->proc->N;
+    for (int32_t q=0; q<NB_PRIMES; q++) {
+	const FFT_Processor_ntt::Modulus& md = result1->proc->modulus(q);
+	const uint32_t* aa = ((LagrangeHalfCPolynomial_IMPL*) a)->coefs + q*N;
+	const uint32_t* bb = ((LagrangeHalfCPolynomial_IMPL*) b)->coefs + q*N;
+	uint32_t* rr = result1->coefs + q*N;
+	int32_t i=0;
+#ifdef __AVX2__
+	const __m256i p = _mm256_set1_epi32(md.p);
+	const __m256i pinv = _mm256_set1_epi32(md.pinv);
+	for (; i+8<=N; i+=8)
+	    store8(rr+i, mulMont8(load8(aa+i), load8(bb+i), p, pinv));
+#endif
+	for (; i<N; i++)
+	    rr[i] = mulMont(aa[i],bb[i],md.p,md.pinv);
+    }
+}
+
+/** termwise multiplication and addTo in Lagrange space */
+EXPORT void LagrangeHalfCPolynomialAddMul(
+	LagrangeHalfCPolynomial* accum,
+	const LagrangeHalfCPolynomial* a,
+	const LagrangeHalfCPolynomial* b)
+{
+    LagrangeHalfCPolynomial_IMPL* result1 = (LagrangeHalfCPolynomial_IMPL*) accum;
+    const int32_t N = result1->proc->N;
+    for (int32_t q=0; q<NB_PRIMES; q++) {
+	const FFT_Processor_ntt::Modulus& md = result1->proc->modulus(q);
+	const uint32_t* aa = ((LagrangeHalfCPolynomial_IMPL*) a)->coefs + q*N;
+	const uint32_t* bb = ((LagrangeHalfCPolynomial_IMPL*) b)->coefs + q*N;
+	uint32_t* rr = result1->coefs + q*N;
+	int32_t i=0;
+#ifdef __AVX2__
+	const __m256i p = _mm256_set1_epi32(md.p);
+	const __m256i pinv = _mm256_set1_epi32(md.pinv);
+	for (; i+8<=N; i+=8) {
+	    const __m256i m = mulMont8(load8(aa+i), load8(bb+i), p, pinv);
+	    store8(rr+i, reduce8(_mm256_add_epi32(load8(rr+i), m), p));
+	}
+#endif
+	for (; i<N; i++)
+	    rr[i] = add(rr[i],mulMont(aa[i],bb[i],md.p,md.pinv),md.p);
+    }
+}
+
+
+/** termwise multiplication and subTo in Lagrange space */
+EXPORT void LagrangeHalfCPolynomialSubMul(
+	LagrangeHalfCPolynomial* accum,
+	const LagrangeHalfCPolynomial* a,
+	const LagrangeHalfCPolynomial* b)
+{
+    LagrangeHalfCPolynomial_IMPL* result1 = (LagrangeHalfCPolynomial_IMPL*) accum;
+    const int32_t N = result1->proc->N;
+    for (int32_t q=0; q<NB_PRIMES; q++) {
+	const FFT_Processor_ntt::Modulus& md = result1->proc->modulus(q);
+	const uint32_t* aa = ((LagrangeHalfCPolynomial_IMPL*) a)->coefs + q*N;
+	const uint32_t* bb = ((LagrangeHalfCPolynomial_IMPL*) b)->coefs + q*N;
+	uint32_t* rr = result1->coefs + q*N;
+	int32_t i=0;
+#ifdef __AVX2__
+	const __m256i p = _mm256_set1_epi32(md.p);
+	const __m256i pinv = _mm256_set1_epi32(md.pinv);
+	for (; i+8<=N; i+=8) {
+	    const __m256i m = mulMont8(load8(aa+i), load8(bb+i), p, pinv);
+	    store8(rr+i, reduce8(_mm256_sub_epi32(_mm256_add_epi32(load8(rr+i), p), m), p));
+	}
+#endif
+	for (; i<N; i++)
+	    rr[i] = sub(rr[i],mulMont(aa[i],bb[i],md.p,md.pinv),md.p);
+    }
+}
+
+// the residues do not fit in single precision floats
+EXPORT void LagrangeHalfCPolynomial_toFloat32(float* result, const LagrangeHalfCPolynomial* p) {
+    die_dramatically("the ntt processor has no single precision storage");
+}
+
+EXPORT void LagrangeHalfCPolynomialAddMulFloat32(
+	LagrangeHalfCPolynomial* accum,
+	const LagrangeHalfCPolynomial* a,
+	const float* b)
+{
+    die_dramatically("the ntt processor has no single precision storage");
+}
+
+EXPORT void LagrangeHalfCPolynomialAddTo(
+	LagrangeHalfCPolynomial* accum,
+	const LagrangeHalfCPolynomial* a) {
+    LagrangeHalfCPolynomial_IMPL* result1 = (LagrangeHalfCPolynomial_IMPL*) accum;
+    const int32_t N = result1->proc->N;
+    for (int32_t q=0; q<NB_PRIMES; q++) {
+	const uint32_t p = result1->proc->modulus(q).p;
+	const uint32_t* aa = ((LagrangeHalfCPolynomial_IMPL*) a)->coefs + q*N;
+	uint32_t* rr = result1->coefs + q*N;
+	int32_t i=0;
+#ifdef __AVX2__
+	const __m256i p8 = _mm256_set1_epi32(p);
+	for (; i+8<=N; i+=8)
+	    store8(rr+i, reduce8(_mm256_add_epi32(load8(rr+i), load8(aa+i)), p8));
+#endif
+	for (; i<N; i++)
+	    rr[i] = add(rr[i],aa[i],p);
+    }
+}
@@ -0,0 +1,186 @@
+#ifndef LAGRANGEHALFC_IMPL_H
+#define LAGRANGEHALFC_IMPL_H
+
+#include <cassert>
+#include <cstdint>
+#include "tfhe.h"
+#include "polynomials.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/**
+ * The ntt processor computes exact products. It is only built with
+ * -DENABLE_NTT=on.
+ *
+ * The transforms are done modulo two 31-bit primes
+ *   P0 = 63.2^25 + 1 and P1 = 15.2^27 + 1 (P0-1 and P1-1 are multiples of 2^25)
+ * and the integer coefficients are recovered by CRT modulo Q = P0.P1 (about
+ * 2^61.9). With AVX2, the butterflies (Shoup) and the termwise products
+ * (Montgomery) handle 8 residues per instruction, with _mm256_mul_epu32 for
+ * the 32x32->64-bit products.
+ *
+ * A product of an integer polynomial of norm <= B by a torus polynomial,
+ * summed over K terms, is exact as long as K.N.B.2^31 < Q/2: for instance
+ * N=1024, K=(k+1).l=4 and digits up to 2^16.
+ */
+namespace ntt {
+static const int32_t NB_PRIMES = 2;
+static const uint32_t P0 = UINT32_C(2113929217);
+static const uint32_t P1 = UINT32_C(2013265921);
+
+/** x mod p, for x in [0,2p[ */
+inline uint32_t reduce(const uint32_t x, const uint32_t p) {
+    return x >= p ? x - p : x;
+}
+
+/** a+b mod p, for a,b in [0,p[ */
+inline uint32_t add(const uint32_t a, const uint32_t b, const uint32_t p) {
+    return reduce(a + b, p);
+}
+
+/** a-b mod p, for a,b in [0,p[ */
+inline uint32_t sub(const uint32_t a, const uint32_t b, const uint32_t p) {
+    return reduce(a + p - b, p);
+}
+
+/** a representative in [0,2p[ of a signed 32-bit integer (p > 2^30) */
+inline uint32_t fromInt32(const int32_t x, const uint32_t p) {
+    return x < 0 ? uint32_t(x) + 2 * p : uint32_t(x);
+}
+
+/**
+ * Shoup multiplication by the constant w < p, given wp = floor(w.2^32/p):
+ * x.w mod p in [0,2p[, for any x < 2^32
+ */
+inline uint32_t mulShoupLazy(const uint32_t x, const uint32_t w, const uint32_t wp, const uint32_t p) {
+    const uint32_t q = uint32_t((uint64_t(x) * wp) >> 32);
+    return x * w - q * p;
+}
+
+inline uint32_t mulShoup(const uint32_t x, const uint32_t w, const uint32_t wp, const uint32_t p) {
+    return reduce(mulShoupLazy(x, w, wp, p), p);
+}
+
+/** the Shoup companion floor(w.2^32/p) of w < p */
+inline uint32_t shoup(const uint32_t w, const uint32_t p) {
+    return uint32_t((uint64_t(w) << 32) / p);
+}
+
+/**
+ * Montgomery product a.b.2^-32 mod p in [0,p[, for a,b in [0,p[
+ * (pinv = -p^-1 mod 2^32)
+ */
+inline uint32_t mulMont(const uint32_t a, const uint32_t b, const uint32_t p, const uint32_t pinv) {
+    const uint64_t t = uint64_t(a) * b;
+    const uint32_t m = uint32_t(t) * pinv;
+    return reduce(uint32_t((t + uint64_t(m) * p) >> 32), p);
+}
+
+#ifdef __AVX2__
+/** the same operations on 8 residues (p, pinv, w and wp broadcast or not) */
+inline __m256i reduce8(const __m256i x, const __m256i p) {
+    return _mm256_min_epu32(x, _mm256_sub_epi32(x, p));
+}
+
+/** the high 32 bits of the 8 products a.b */
+inline __m256i mulhi8(const __m256i a, const __m256i b) {
+    const __m256i even = _mm256_mul_epu32(a, b);
+    const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    return _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+
+inline __m256i mulShoupLazy8(const __m256i x, const __m256i w, const __m256i wp, const __m256i p) {
+    const __m256i q = mulhi8(x, wp);
+    return _mm256_sub_epi32(_mm256_mullo_epi32(x, w), _mm256_mullo_epi32(q, p));
+}
+
+inline __m256i mulMont8(const __m256i a, const __m256i b, const __m256i p, const __m256i pinv) {
+    const __m256i te = _mm256_mul_epu32(a, b);
+    const __m256i to = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    const __m256i ue = _mm256_add_epi64(te, _mm256_mul_epu32(_mm256_mul_epu32(te, pinv), p));
+    const __m256i uo = _mm256_add_epi64(to, _mm256_mul_epu32(_mm256_mul_epu32(to, pinv), p));
+    return reduce8(_mm256_blend_epi32(_mm256_srli_epi64(ue, 32), uo, 0xAA), p);
+}
+#endif
+}
+
+/**
+ * number theoretic transforms modulo ntt::P0 and ntt::P1: the residues are
+ * kept in Montgomery form (x.2^32 mod p), so that the termwise products are
+ * single Montgomery products
+ */
+class FFT_Processor_ntt {
+    public:
+    const int32_t _2N;
+    const int32_t N;
+    const int32_t Ns2;
+
+    /** the tables of one prime */
+    struct Modulus {
+        uint32_t p;
+        uint32_t pinv;            // -p^-1 mod 2^32
+        uint32_t R;               // 2^32 mod p
+        uint32_t R_shoup;
+        uint32_t scale;           // N^-1.2^-32 mod p
+        uint32_t scale_shoup;
+        uint32_t* psi_rev;        // psi^brev(i), psi a primitive 2N-th root of unity
+        uint32_t* psi_rev_shoup;
+        uint32_t* psi_inv_rev;    // psi^-brev(i)
+        uint32_t* psi_inv_rev_shoup;
+        // the twiddles of the stages t=1,2,4 in the lane order of the AVX2 kernels
+        uint32_t* lane_tw[3];
+        uint32_t* lane_tw_shoup[3];
+        uint32_t* lane_inv_tw[3];
+        uint32_t* lane_inv_tw_shoup[3];
+        uint32_t* xaiminus1;      // (psi^x-1).2^32 mod p for x in [0,2N[
+    };
+
+    private:
+    Modulus mod[ntt::NB_PRIMES];
+    uint32_t crt_c;               // P0^-1 mod P1
+    uint32_t crt_c_shoup;
+    uint32_t* buf;
+    void initModulus(Modulus& m, const uint32_t p, const uint32_t generator, const int32_t logN);
+    void forward(uint32_t* a, const Modulus& m);
+    void inverse(uint32_t* a, const Modulus& m);
+    void toMontArray(uint32_t* res, const int32_t* a, const Modulus& m);
+    public:
+    int32_t* eval_exp;            // the slot i is the evaluation at psi^eval_exp[i]
+
+    FFT_Processor_ntt(const int32_t N);
+    const Modulus& modulus(const int32_t q) const { return mod[q]; }
+    void execute_reverse_int(uint32_t* res, const int32_t* a);
+    void execute_reverse_torus32(uint32_t* res, const Torus32* a);
+    void execute_direct_torus32(Torus32* res, const uint32_t* a);
+    /** the Montgomery form of the constant x modulo the prime q */
+    uint32_t toMont(const int32_t x, const int32_t q) const {
+        return ntt::mulShoup(ntt::fromInt32(x, mod[q].p), mod[q].R, mod[q].R_shoup, mod[q].p);
+    }
+    ~FFT_Processor_ntt();
+};
+
+/** the NTT processor of the current thread for the dimension N (a power of
+ * two), created on first use */
+FFT_Processor_ntt* fft_processor_ntt(const int32_t N);
+
+/**
+ * structure that represents a polynomial P mod X^N+1 with integer
+ * coefficients as its N evaluations modulo ntt::P0, followed by its N
+ * evaluations modulo ntt::P1:
+ * P(psi^e_0), ..., P(psi^e_(N-1))
+ * where psi is a primitive 2N-th root of unity and the e_i are the odd
+ * exponents (in the bit-reversed order of the transform)
+ */
+struct LagrangeHalfCPolynomial_IMPL
+{
+   uint32_t* coefs;
+   FFT_Processor_ntt* proc;
+
+   LagrangeHalfCPolynomial_IMPL(int32_t N);
+   // on external coefficients (must not be destroyed, see init_LagrangeHalfCPolynomial_view)
+   LagrangeHalfCPolynomial_IMPL(int32_t N, uint32_t *coefs);
+   ~LagrangeHalfCPolynomial_IMPL();
+};
+
+#endif // LAGRANGEHALFC_IMPL_H
@@ -2,6 +2,7 @@
 #include "spqlios-fft.h"
 #include <cassert>
 #include <cmath>
+#include <immintrin.h>
 
 using namespace std;
 
@@ -15,7 +16,12 @@ int32_t rev(int32_t x, int32_t M) {
 }
 
 FFT_Processor_Spqlios::FFT_Processor_Spqlios(const int32_t N)
-    : _2N(2 * N), N(N), Ns2(N / 2) {
+    : _2N(2 * N), N(N), Ns2(N / 2), _2sN(double(2) / double(N)) {
+#ifdef SPQLIOS_AVX512
+  // the avx512 kernels process 8 complex coefficients (N/4 >= 8) at a time
+  if (N < 32)
+    die_dramatically("the avx512 spqlios processor needs N >= 32");
+#endif
   tables_direct = new_fft_table(N);
   tables_reverse = new_ifft_table(N);
   real_inout_direct = fft_table_get_buffer(tables_direct);
@@ -36,6 +42,18 @@ FFT_Processor_Spqlios::FFT_Processor_Spqlios(const int32_t N)
   }
 }
 
+#ifdef SPQLIOS_AVX512
+void FFT_Processor_Spqlios::execute_reverse_int(double *res, const int32_t *a) {
+  // for (int32_t i=0; i<N; i++) real_inout_rev[i]=(double)a[i];
+  for (int32_t i = 0; i < N; i += 8)
+    _mm512_storeu_pd(real_inout_rev + i,
+                     _mm512_cvtepi32_pd(_mm256_loadu_si256((const __m256i *)(a + i))));
+  ifft(tables_reverse, real_inout_rev);
+  // for (int32_t i=0; i<N; i++) res[i]=real_inout_rev[i];
+  for (int32_t i = 0; i < N; i += 8)
+    _mm512_storeu_pd(res + i, _mm512_loadu_pd(real_inout_rev + i));
+}
+#else
 void FFT_Processor_Spqlios::execute_reverse_int(double *res, const int32_t *a) {
   // for (int32_t i=0; i<N; i++) real_inout_rev[i]=(double)a[i];
   {
@@ -73,6 +91,7 @@ void FFT_Processor_Spqlios::execute_reverse_int(double *res, const int32_t *a) {
                          : "%ymm0", "memory");
   }
 }
+#endif
 
 void FFT_Processor_Spqlios::execute_reverse_torus32(double *res,
                                                     const Torus32 *a) {
@@ -83,10 +102,24 @@ void FFT_Processor_Spqlios::execute_reverse_torus32(double *res,
   execute_reverse_int(res, aa);
 }
 
+#ifdef SPQLIOS_AVX512
+void FFT_Processor_Spqlios::execute_direct_torus32(Torus32 *res,
+                                                   const double *a) {
+  // for (int32_t i=0; i<N; i++) real_inout_direct[i]=a[i]*_2sn;
+  const __m512d scale = _mm512_set1_pd(_2sN);
+  for (int32_t i = 0; i < N; i += 8)
+    _mm512_storeu_pd(real_inout_direct + i,
+                     _mm512_mul_pd(_mm512_loadu_pd(a + i), scale));
+  fft(tables_direct, real_inout_direct);
+  // for (int32_t i=0; i<N; i++) res[i]=Torus32(int64_t(real_inout_direct[i]));
+  for (int32_t i = 0; i < N; i += 8)
+    _mm256_storeu_si256(
+        (__m256i *)(res + i),
+        _mm512_cvtepi64_epi32(_mm512_cvttpd_epi64(_mm512_loadu_pd(real_inout_direct + i))));
+}
+#else
 void FFT_Processor_Spqlios::execute_direct_torus32(Torus32 *res,
                                                    const double *a) {
-  // TODO: parallelization
-  static const double _2sN = double(2) / double(N);
   // for (int32_t i=0; i<N; i++) real_inout_direct[i]=a[i]*_2sn;
   {
     double *dst = real_inout_direct;
@@ -111,6 +144,102 @@ void FFT_Processor_Spqlios::execute_direct_torus32(Torus32 *res,
   for (int32_t i = 0; i < N; i++)
     res[i] = Torus32(int64_t(real_inout_direct[i]));
 }
+#endif
+
+void FFT_Processor_Spqlios::execute_reverse_int_batch(double *const *res,
+                                                      const int32_t *const *a,
+                                                      const int32_t count) {
+  for (int32_t j = 0; j < count; j++) {
+    double *dst = res[j];
+    const int32_t *src = a[j];
+#ifdef SPQLIOS_AVX512
+    for (int32_t i = 0; i < N; i += 8)
+      _mm512_store_pd(dst + i, _mm512_cvtepi32_pd(
+                                   _mm256_loadu_si256((const __m256i *)(src + i))));
+#elif defined __AVX__
+    for (int32_t i = 0; i < N; i += 4)
+      _mm256_store_pd(dst + i, _mm256_cvtepi32_pd(
+                                   _mm_loadu_si128((const __m128i *)(src + i))));
+#else
+    for (int32_t i = 0; i < N; i++)
+      dst[i] = src[i];
+#endif
+  }
+  ifft_batch(tables_reverse, res, count);
+}
+
+void FFT_Processor_Spqlios::execute_direct_torus32_batch(Torus32 *const *res,
+                                                         double *const *a,
+                                                         const int32_t count) {
+  for (int32_t j = 0; j < count; j++) {
+    double *src = a[j];
+#ifdef SPQLIOS_AVX512
+    const __m512d scale = _mm512_set1_pd(_2sN);
+    for (int32_t i = 0; i < N; i += 8)
+      _mm512_store_pd(src + i, _mm512_mul_pd(_mm512_load_pd(src + i), scale));
+#elif defined __AVX__
+    const __m256d scale = _mm256_set1_pd(_2sN);
+    for (int32_t i = 0; i < N; i += 4)
+      _mm256_store_pd(src + i, _mm256_mul_pd(_mm256_load_pd(src + i), scale));
+#else
+    for (int32_t i = 0; i < N; i++)
+      src[i] *= _2sN;
+#endif
+  }
+  fft_batch(tables_direct, a, count);
+  for (int32_t j = 0; j < count; j++) {
+    const double *src = a[j];
+    Torus32 *dst = res[j];
+#ifdef SPQLIOS_AVX512
+    for (int32_t i = 0; i < N; i += 8)
+      _mm256_storeu_si256(
+          (__m256i *)(dst + i),
+          _mm512_cvtepi64_epi32(_mm512_cvttpd_epi64(_mm512_load_pd(src + i))));
+#else
+    for (int32_t i = 0; i < N; i++)
+      dst[i] = Torus32(int64_t(src[i]));
+#endif
+  }
+}
+
+void FFT_Processor_Spqlios::execute_reverse_decomp(double *const *res,
+                                                   const Torus32 *a,
+                                                   const int32_t l,
+                                                   const int32_t Bgbit,
+                                                   const uint32_t offset) {
+  const uint32_t *buf = (const uint32_t *)a;
+  const uint32_t maskMod = (1u << Bgbit) - 1;
+  const int32_t halfBg = 1 << (Bgbit - 1);
+#ifdef __AVX2__
+  const __m256i voffset = _mm256_set1_epi32(offset);
+  const __m256i vmask = _mm256_set1_epi32(maskMod);
+  const __m256i vhalfBg = _mm256_set1_epi32(halfBg);
+  for (int32_t i = 0; i < N; i += 8) {
+    const __m256i x = _mm256_add_epi32(
+        _mm256_loadu_si256((const __m256i *)(buf + i)), voffset);
+    for (int32_t p = 0; p < l; p++) {
+      const __m128i decal = _mm_cvtsi32_si128(32 - (p + 1) * Bgbit);
+      const __m256i digit = _mm256_sub_epi32(
+          _mm256_and_si256(_mm256_srl_epi32(x, decal), vmask), vhalfBg);
+#ifdef SPQLIOS_AVX512
+      _mm512_store_pd(res[p] + i, _mm512_cvtepi32_pd(digit));
+#else
+      _mm256_store_pd(res[p] + i,
+                      _mm256_cvtepi32_pd(_mm256_castsi256_si128(digit)));
+      _mm256_store_pd(res[p] + i + 4,
+                      _mm256_cvtepi32_pd(_mm256_extracti128_si256(digit, 1)));
+#endif
+    }
+  }
+#else
+  for (int32_t p = 0; p < l; p++) {
+    const int32_t decal = 32 - (p + 1) * Bgbit;
+    for (int32_t i = 0; i < N; i++)
+      res[p][i] = int32_t(((buf[i] + offset) >> decal) & maskMod) - halfBg;
+  }
+#endif
+  ifft_batch(tables_reverse, res, l);
+}
 
 FFT_Processor_Spqlios::~FFT_Processor_Spqlios() {
   // delete (tables_direct);
@@ -118,23 +247,97 @@ FFT_Processor_Spqlios::~FFT_Processor_Spqlios() {
   delete[] cosomegaxminus1;
 }
 
-thread_local FFT_Processor_Spqlios fftp1024(1024);
+namespace {
+// the FFT processors of a thread, indexed by log2(N), released when the
+// thread exits
+struct ThreadFFTProcessors {
+  FFT_Processor_Spqlios *procs[32];
+
+  ThreadFFTProcessors() {
+    for (int32_t i = 0; i < 32; i++)
+      procs[i] = 0;
+  }
+
+  ~ThreadFFTProcessors() {
+    for (int32_t i = 0; i < 32; i++)
+      delete procs[i];
+  }
+};
+
+thread_local ThreadFFTProcessors thread_fft_processors;
+} // namespace
+
+FFT_Processor_Spqlios *fft_processor_spqlios(const int32_t N) {
+  const int32_t logN = __builtin_ctz(N);
+  assert(N == (1 << logN));
+  FFT_Processor_Spqlios *&proc = thread_fft_processors.procs[logN];
+  if (proc == 0)
+    proc = new FFT_Processor_Spqlios(N);
+  return proc;
+}
 
 /**
  * FFT functions
  */
 EXPORT void IntPolynomial_ifft(LagrangeHalfCPolynomial *result,
                                const IntPolynomial *p) {
-  fftp1024.execute_reverse_int(((LagrangeHalfCPolynomial_IMPL *)result)->coefsC,
-                               p->coefs);
+  fft_processor_spqlios(p->N)->execute_reverse_int(
+      ((LagrangeHalfCPolynomial_IMPL *)result)->coefsC, p->coefs);
 }
 EXPORT void TorusPolynomial_ifft(LagrangeHalfCPolynomial *result,
                                  const TorusPolynomial *p) {
-  fftp1024.execute_reverse_torus32(
+  fft_processor_spqlios(p->N)->execute_reverse_torus32(
       ((LagrangeHalfCPolynomial_IMPL *)result)->coefsC, p->coefsT);
 }
 EXPORT void TorusPolynomial_fft(TorusPolynomial *result,
                                 const LagrangeHalfCPolynomial *p) {
-  fftp1024.execute_direct_torus32(result->coefsT,
-                                  ((LagrangeHalfCPolynomial_IMPL *)p)->coefsC);
+  fft_processor_spqlios(result->N)->execute_direct_torus32(
+      result->coefsT, ((LagrangeHalfCPolynomial_IMPL *)p)->coefsC);
+}
+
+namespace {
+// polynomials transformed by one call of the batched kernels
+const int32_t FFT_BATCH = 16;
+} // namespace
+
+EXPORT void IntPolynomial_ifft_batch(LagrangeHalfCPolynomial *results,
+                                     const IntPolynomial *p,
+                                     const int32_t count) {
+  double *res[FFT_BATCH];
+  const int32_t *a[FFT_BATCH];
+  for (int32_t j0 = 0; j0 < count; j0 += FFT_BATCH) {
+    const int32_t nb = min(FFT_BATCH, count - j0);
+    for (int32_t j = 0; j < nb; j++) {
+      res[j] = ((LagrangeHalfCPolynomial_IMPL *)(results + j0 + j))->coefsC;
+      a[j] = p[j0 + j].coefs;
+    }
+    fft_processor_spqlios(p->N)->execute_reverse_int_batch(res, a, nb);
+  }
+}
+
+EXPORT void TorusPolynomial_decompH_ifft(LagrangeHalfCPolynomial *results,
+                                         const TorusPolynomial *p,
+                                         const int32_t l, const int32_t Bgbit,
+                                         const uint32_t offset) {
+  double *res[32];
+  assert(l <= 32);
+  for (int32_t j = 0; j < l; j++)
+    res[j] = ((LagrangeHalfCPolynomial_IMPL *)(results + j))->coefsC;
+  fft_processor_spqlios(p->N)->execute_reverse_decomp(res, p->coefsT, l, Bgbit,
+                                                      offset);
+}
+
+EXPORT void TorusPolynomial_fft_batch(TorusPolynomial *results,
+                                      LagrangeHalfCPolynomial *p,
+                                      const int32_t count) {
+  Torus32 *res[FFT_BATCH];
+  double *a[FFT_BATCH];
+  for (int32_t j0 = 0; j0 < count; j0 += FFT_BATCH) {
+    const int32_t nb = min(FFT_BATCH, count - j0);
+    for (int32_t j = 0; j < nb; j++) {
+      res[j] = results[j0 + j].coefsT;
+      a[j] = ((LagrangeHalfCPolynomial_IMPL *)(p + j0 + j))->coefsC;
+    }
+    fft_processor_spqlios(results->N)->execute_direct_torus32_batch(res, a, nb);
+  }
 }
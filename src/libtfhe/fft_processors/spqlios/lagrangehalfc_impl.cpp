@@ -1,16 +1,23 @@
 #include "lagrangehalfc_impl.h"
 #include <polynomials.h>
+#include <immintrin.h>
 
 using namespace std;
 
 LagrangeHalfCPolynomial_IMPL::LagrangeHalfCPolynomial_IMPL(const int32_t N) {
-  assert(N == 1024);
-  coefsC = new double[N];
-  proc = &fftp1024;
+  // aligned like the buffers of the fft tables, for the in-place batches
+  coefsC = (double *)aligned_alloc(64, N * sizeof(double));
+  proc = fft_processor_spqlios(N);
+}
+
+LagrangeHalfCPolynomial_IMPL::LagrangeHalfCPolynomial_IMPL(const int32_t N,
+                                                           double *coefs) {
+  coefsC = coefs;
+  proc = fft_processor_spqlios(N);
 }
 
 LagrangeHalfCPolynomial_IMPL::~LagrangeHalfCPolynomial_IMPL() {
-  delete[] coefsC;
+  free(coefsC);
 }
 
 // initialize the key structure
@@ -42,6 +49,19 @@ destroy_LagrangeHalfCPolynomial_array(int32_t nbelts,
   }
 }
 
+EXPORT void init_LagrangeHalfCPolynomial_view(LagrangeHalfCPolynomial *obj,
+                                              const int32_t N, double *coefs) {
+  new (obj) LagrangeHalfCPolynomial_IMPL(N, coefs);
+}
+
+EXPORT const double *
+LagrangeHalfCPolynomial_coefs(const LagrangeHalfCPolynomial *p) {
+  return ((const LagrangeHalfCPolynomial_IMPL *)p)->coefsC;
+}
+
+// the N/2 real parts, then the N/2 imaginary parts
+EXPORT const char *LagrangeHalfCPolynomial_layout() { return "spqlios"; }
+
 // MISC OPERATIONS
 /** sets to zero */
 EXPORT void LagrangeHalfCPolynomialClear(LagrangeHalfCPolynomial *reps) {
@@ -180,3 +200,63 @@ EXPORT void LagrangeHalfCPolynomialAddTo(LagrangeHalfCPolynomial *accum,
     rr[i] += ar[i];
   }
 }
+
+EXPORT void LagrangeHalfCPolynomial_toFloat32(float *result,
+                                              const LagrangeHalfCPolynomial *p) {
+  const LagrangeHalfCPolynomial_IMPL *p1 =
+      (const LagrangeHalfCPolynomial_IMPL *)p;
+  const int32_t N = p1->proc->N;
+  for (int32_t i = 0; i < N; i++)
+    result[i] = float(p1->coefsC[i]);
+}
+
+// same layout as the doubles: the real parts b[0..Ns2[, then the imaginary
+// parts b[Ns2..N[, widened to double before the products
+EXPORT void LagrangeHalfCPolynomialAddMulFloat32(LagrangeHalfCPolynomial *accum,
+                                                 const LagrangeHalfCPolynomial *a,
+                                                 const float *b) {
+  LagrangeHalfCPolynomial_IMPL *result1 = (LagrangeHalfCPolynomial_IMPL *)accum;
+  const int32_t Ns2 = result1->proc->Ns2;
+  double *rre = result1->coefsC;
+  double *rim = rre + Ns2;
+  const double *are = ((LagrangeHalfCPolynomial_IMPL *)a)->coefsC;
+  const double *aim = are + Ns2;
+  const float *bre = b;
+  const float *bim = b + Ns2;
+#if defined SPQLIOS_AVX512
+  for (int32_t i = 0; i < Ns2; i += 8) {
+    const __m512d ar = _mm512_loadu_pd(are + i);
+    const __m512d ai = _mm512_loadu_pd(aim + i);
+    const __m512d br = _mm512_cvtps_pd(_mm256_loadu_ps(bre + i));
+    const __m512d bi = _mm512_cvtps_pd(_mm256_loadu_ps(bim + i));
+    __m512d rr = _mm512_loadu_pd(rre + i);
+    __m512d ri = _mm512_loadu_pd(rim + i);
+    rr = _mm512_fnmadd_pd(ai, bi, _mm512_fmadd_pd(ar, br, rr));
+    ri = _mm512_fmadd_pd(ai, br, _mm512_fmadd_pd(ar, bi, ri));
+    _mm512_storeu_pd(rre + i, rr);
+    _mm512_storeu_pd(rim + i, ri);
+  }
+#elif defined __FMA__
+  for (int32_t i = 0; i < Ns2; i += 4) {
+    const __m256d ar = _mm256_loadu_pd(are + i);
+    const __m256d ai = _mm256_loadu_pd(aim + i);
+    const __m256d br = _mm256_cvtps_pd(_mm_loadu_ps(bre + i));
+    const __m256d bi = _mm256_cvtps_pd(_mm_loadu_ps(bim + i));
+    __m256d rr = _mm256_loadu_pd(rre + i);
+    __m256d ri = _mm256_loadu_pd(rim + i);
+    rr = _mm256_fnmadd_pd(ai, bi, _mm256_fmadd_pd(ar, br, rr));
+    ri = _mm256_fmadd_pd(ai, br, _mm256_fmadd_pd(ar, bi, ri));
+    _mm256_storeu_pd(rre + i, rr);
+    _mm256_storeu_pd(rim + i, ri);
+  }
+#else
+  for (int32_t i = 0; i < Ns2; i++) {
+    const double br = bre[i];
+    const double bi = bim[i];
+    const double ar = are[i];
+    const double ai = aim[i];
+    rre[i] += ar * br - ai * bi;
+    rim[i] += ar * bi + ai * br;
+  }
+#endif
+}
@@ -23,6 +23,8 @@ public:
     double *cosomegaxminus1;
     double *sinomegaxminus1;
     int32_t *reva; //rev(2i+1,_2N)
+    // (new fields must stay after Ns2: the assembly code reads it at a fixed offset)
+    const double _2sN; //2/N, rescaling of the direct fft
 
     FFT_Processor_Spqlios(const int32_t N);
 
@@ -32,10 +34,24 @@ public:
 
     void execute_direct_torus32(Torus32 *res, const double *a);
 
+    // ifft of the count polynomials a[j], directly in the buffers res[j]
+    // (64-byte aligned), the levels of the polynomials being interleaved
+    void execute_reverse_int_batch(double *const *res, const int32_t *const *a, const int32_t count);
+
+    // fft of the count buffers a[j] (64-byte aligned, overwritten) into res[j]
+    void execute_direct_torus32_batch(Torus32 *const *res, double *const *a, const int32_t count);
+
+    // ifft of the l gadget digits of a, which are written as doubles
+    // directly in the buffers res[0..l[ (64-byte aligned)
+    void execute_reverse_decomp(double *const *res, const Torus32 *a, const int32_t l,
+                                const int32_t Bgbit, const uint32_t offset);
+
     ~FFT_Processor_Spqlios();
 };
 
-extern thread_local FFT_Processor_Spqlios fftp1024;
+/** the FFT processor of the current thread for the dimension N (a power of
+ * two), created on first use */
+FFT_Processor_Spqlios *fft_processor_spqlios(const int32_t N);
 
 /**
  * structure that represents a real polynomial P mod X^N+1
@@ -48,6 +64,8 @@ struct LagrangeHalfCPolynomial_IMPL {
     FFT_Processor_Spqlios *proc;
 
     LagrangeHalfCPolynomial_IMPL(int32_t N);
+    // on external coefficients (must not be destroyed, see init_LagrangeHalfCPolynomial_view)
+    LagrangeHalfCPolynomial_IMPL(int32_t N, double *coefs);
 
     ~LagrangeHalfCPolynomial_IMPL();
 };
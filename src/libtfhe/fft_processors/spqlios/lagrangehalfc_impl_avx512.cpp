@@ -0,0 +1,83 @@
+#include "lagrangehalfc_impl.h"
+#include <immintrin.h>
+
+// AVX-512 version of the termwise operations of lagrangehalfc_impl_fma.s:
+// the real parts are coefsC[0..Ns2[ and the imaginary parts coefsC[Ns2..N[
+
+/** termwise multiplication in Lagrange space */
+EXPORT void LagrangeHalfCPolynomialMul(LagrangeHalfCPolynomial *result,
+                                       const LagrangeHalfCPolynomial *a,
+                                       const LagrangeHalfCPolynomial *b) {
+  LagrangeHalfCPolynomial_IMPL *result1 =
+      (LagrangeHalfCPolynomial_IMPL *)result;
+  const int32_t Ns2 = result1->proc->Ns2;
+  double *rre = result1->coefsC;
+  double *rim = rre + Ns2;
+  const double *are = ((LagrangeHalfCPolynomial_IMPL *)a)->coefsC;
+  const double *aim = are + Ns2;
+  const double *bre = ((LagrangeHalfCPolynomial_IMPL *)b)->coefsC;
+  const double *bim = bre + Ns2;
+
+  for (int32_t i = 0; i < Ns2; i += 8) {
+    const __m512d ar = _mm512_loadu_pd(are + i);
+    const __m512d ai = _mm512_loadu_pd(aim + i);
+    const __m512d br = _mm512_loadu_pd(bre + i);
+    const __m512d bi = _mm512_loadu_pd(bim + i);
+    _mm512_storeu_pd(rre + i, _mm512_fmsub_pd(ar, br, _mm512_mul_pd(ai, bi)));
+    _mm512_storeu_pd(rim + i, _mm512_fmadd_pd(ar, bi, _mm512_mul_pd(ai, br)));
+  }
+}
+
+/** termwise multiplication and addTo in Lagrange space */
+EXPORT void LagrangeHalfCPolynomialAddMul(LagrangeHalfCPolynomial *accum,
+                                          const LagrangeHalfCPolynomial *a,
+                                          const LagrangeHalfCPolynomial *b) {
+  LagrangeHalfCPolynomial_IMPL *result1 = (LagrangeHalfCPolynomial_IMPL *)accum;
+  const int32_t Ns2 = result1->proc->Ns2;
+  double *rre = result1->coefsC;
+  double *rim = rre + Ns2;
+  const double *are = ((LagrangeHalfCPolynomial_IMPL *)a)->coefsC;
+  const double *aim = are + Ns2;
+  const double *bre = ((LagrangeHalfCPolynomial_IMPL *)b)->coefsC;
+  const double *bim = bre + Ns2;
+
+  for (int32_t i = 0; i < Ns2; i += 8) {
+    const __m512d ar = _mm512_loadu_pd(are + i);
+    const __m512d ai = _mm512_loadu_pd(aim + i);
+    const __m512d br = _mm512_loadu_pd(bre + i);
+    const __m512d bi = _mm512_loadu_pd(bim + i);
+    __m512d rr = _mm512_loadu_pd(rre + i);
+    __m512d ri = _mm512_loadu_pd(rim + i);
+    rr = _mm512_fnmadd_pd(ai, bi, _mm512_fmadd_pd(ar, br, rr));
+    ri = _mm512_fmadd_pd(ai, br, _mm512_fmadd_pd(ar, bi, ri));
+    _mm512_storeu_pd(rre + i, rr);
+    _mm512_storeu_pd(rim + i, ri);
+  }
+}
+
+/** termwise multiplication and subTo in Lagrange space */
+EXPORT void LagrangeHalfCPolynomialSubMul(LagrangeHalfCPolynomial *accum,
+                                          const LagrangeHalfCPolynomial *a,
+                                          const LagrangeHalfCPolynomial *b) {
+  LagrangeHalfCPolynomial_IMPL *result1 = (LagrangeHalfCPolynomial_IMPL *)accum;
+  const int32_t Ns2 = result1->proc->Ns2;
+  double *rre = result1->coefsC;
+  double *rim = rre + Ns2;
+  const double *are = ((LagrangeHalfCPolynomial_IMPL *)a)->coefsC;
+  const double *aim = are + Ns2;
+  const double *bre = ((LagrangeHalfCPolynomial_IMPL *)b)->coefsC;
+  const double *bim = bre + Ns2;
+
+  for (int32_t i = 0; i < Ns2; i += 8) {
+    const __m512d ar = _mm512_loadu_pd(are + i);
+    const __m512d ai = _mm512_loadu_pd(aim + i);
+    const __m512d br = _mm512_loadu_pd(bre + i);
+    const __m512d bi = _mm512_loadu_pd(bim + i);
+    __m512d rr = _mm512_loadu_pd(rre + i);
+    __m512d ri = _mm512_loadu_pd(rim + i);
+    rr = _mm512_fmadd_pd(ai, bi, _mm512_fnmadd_pd(ar, br, rr));
+    ri = _mm512_fnmadd_pd(ai, br, _mm512_fnmadd_pd(ar, bi, ri));
+    _mm512_storeu_pd(rre + i, rr);
+    _mm512_storeu_pd(rim + i, ri);
+  }
+}
@@ -0,0 +1,257 @@
+#include <stdint.h>
+#include <immintrin.h>
+
+#include "spqlios-fft.h"
+
+// AVX-512 version of fft and ifft (same tables and same data layout as
+// fft_model and ifft_model in spqlios-fft-impl.cpp, whose comments give the
+// scalar semantics of each step). The butterflies of size >= 8 work on zmm
+// registers; the trig tables, stored as |cos0..cos3|sin0..sin3|cos4..., are
+// deinterleaved on the fly with two permutes.
+
+namespace {
+
+    // same layout as FFT_PRECOMP and IFFT_PRECOMP
+    typedef struct {
+        uint64_t n;
+        double *aligned_trig_tables;
+        double *aligned_data;
+        void *buf;
+    } FFT_PRECOMP_AVX512;
+
+    // cos[0..7] and sin[0..7] from the table entries tt[0..15]
+    inline void load_trig8(__m512d &cs, __m512d &sn, const double *tt) {
+        const __m512i idx_cos = _mm512_set_epi64(11, 10, 9, 8, 3, 2, 1, 0);
+        const __m512i idx_sin = _mm512_set_epi64(15, 14, 13, 12, 7, 6, 5, 4);
+        const __m512d t0 = _mm512_loadu_pd(tt);
+        const __m512d t1 = _mm512_loadu_pd(tt + 8);
+        cs = _mm512_permutex2var_pd(t0, idx_cos, t1);
+        sn = _mm512_permutex2var_pd(t0, idx_sin, t1);
+    }
+
+    // (re + i.im) *= (cs + i.sn) on 8 coefficients
+    inline void cmul8(double *re, double *im, const __m512d cs, const __m512d sn) {
+        const __m512d r = _mm512_loadu_pd(re);
+        const __m512d i = _mm512_loadu_pd(im);
+        _mm512_storeu_pd(re, _mm512_fmsub_pd(r, cs, _mm512_mul_pd(i, sn)));
+        _mm512_storeu_pd(im, _mm512_fmadd_pd(r, sn, _mm512_mul_pd(i, cs)));
+    }
+
+    // size 2 butterflies: [a0+a1, a0-a1, a2+a3, a2-a3, ...]
+    inline void butterfly2(double *d) {
+        const __m512d x = _mm512_loadu_pd(d);
+        const __m512d e = _mm512_unpacklo_pd(x, x); // a0,a0,a2,a2...
+        const __m512d o = _mm512_unpackhi_pd(x, x); // a1,a1,a3,a3...
+        const __m512d s = _mm512_add_pd(e, o);
+        _mm512_storeu_pd(d, _mm512_mask_sub_pd(s, 0xAA, e, o));
+    }
+
+    //size 2 and size 4 butterflies of the fft (independent blocks of 8)
+    void fft_first_levels(double *pre, double *pim, const int32_t ns4) {
+        //size 2
+        for (int32_t block = 0; block < ns4; block += 8) {
+            butterfly2(pre + block);
+            butterfly2(pim + block);
+        }
+
+        //size 4
+        // r0 + r2    i0 + i2
+        // r1 + i3    i1 - r3
+        // r0 - r2    i0 - i2
+        // r1 - i3    i1 + r3
+        const __m512i idx_x = _mm512_set_epi64(5, 4, 5, 4, 1, 0, 1, 0);
+        const __m512i idx = _mm512_set_epi64(15, 6, 15, 6, 11, 2, 11, 2);
+        for (int32_t block = 0; block < ns4; block += 8) {
+            const __m512d re = _mm512_loadu_pd(pre + block);
+            const __m512d im = _mm512_loadu_pd(pim + block);
+            const __m512d xre = _mm512_permutexvar_pd(idx_x, re); // r0,r1,r0,r1
+            const __m512d xim = _mm512_permutexvar_pd(idx_x, im); // i0,i1,i0,i1
+            const __m512d yre = _mm512_permutex2var_pd(re, idx, im); // r2,i3,r2,i3
+            const __m512d yim = _mm512_permutex2var_pd(im, idx, re); // i2,r3,i2,r3
+            _mm512_storeu_pd(pre + block, _mm512_mask_sub_pd(_mm512_add_pd(xre, yre), 0xCC, xre, yre));
+            _mm512_storeu_pd(pim + block, _mm512_mask_sub_pd(_mm512_add_pd(xim, yim), 0x66, xim, yim));
+        }
+    }
+
+    //one level of the general loop of the fft (butterflies of size 2*halfnn)
+    void fft_level(double *pre, double *pim, const int32_t ns4, const int32_t halfnn, const double *cur_tt) {
+        const int32_t nn = 2 * halfnn;
+        for (int32_t block = 0; block < ns4; block += nn) {
+            if (halfnn == 4) {
+                // the two halves are in the same zmm: stay on 4 coefficients
+                double *re0 = pre + block;
+                double *im0 = pim + block;
+                double *re1 = re0 + 4;
+                double *im1 = im0 + 4;
+                const __m256d tcs = _mm256_loadu_pd(cur_tt);
+                const __m256d tsn = _mm256_loadu_pd(cur_tt + 4);
+                const __m256d r1 = _mm256_loadu_pd(re1);
+                const __m256d i1 = _mm256_loadu_pd(im1);
+                const __m256d r0 = _mm256_loadu_pd(re0);
+                const __m256d i0 = _mm256_loadu_pd(im0);
+                const __m256d tre = _mm256_fmsub_pd(r1, tcs, _mm256_mul_pd(i1, tsn));
+                const __m256d tim = _mm256_fmadd_pd(r1, tsn, _mm256_mul_pd(i1, tcs));
+                _mm256_storeu_pd(re0, _mm256_add_pd(r0, tre));
+                _mm256_storeu_pd(im0, _mm256_add_pd(i0, tim));
+                _mm256_storeu_pd(re1, _mm256_sub_pd(r0, tre));
+                _mm256_storeu_pd(im1, _mm256_sub_pd(i0, tim));
+                continue;
+            }
+            for (int32_t off = 0; off < halfnn; off += 8) {
+                double *re0 = pre + block + off;
+                double *im0 = pim + block + off;
+                double *re1 = pre + block + halfnn + off;
+                double *im1 = pim + block + halfnn + off;
+                __m512d tcs, tsn;
+                load_trig8(tcs, tsn, cur_tt + 2 * off);
+                const __m512d r1 = _mm512_loadu_pd(re1);
+                const __m512d i1 = _mm512_loadu_pd(im1);
+                const __m512d r0 = _mm512_loadu_pd(re0);
+                const __m512d i0 = _mm512_loadu_pd(im0);
+                const __m512d tre = _mm512_fmsub_pd(r1, tcs, _mm512_mul_pd(i1, tsn));
+                const __m512d tim = _mm512_fmadd_pd(r1, tsn, _mm512_mul_pd(i1, tcs));
+                _mm512_storeu_pd(re0, _mm512_add_pd(r0, tre));
+                _mm512_storeu_pd(im0, _mm512_add_pd(i0, tim));
+                _mm512_storeu_pd(re1, _mm512_sub_pd(r0, tre));
+                _mm512_storeu_pd(im1, _mm512_sub_pd(i0, tim));
+            }
+        }
+    }
+
+    //multiply by omb^j (fft) or omega^j (ifft)
+    void twist(double *pre, double *pim, const int32_t ns4, const double *tt) {
+        for (int32_t j = 0; j < ns4; j += 8) {
+            __m512d cs, sn;
+            load_trig8(cs, sn, tt + 2 * j);
+            cmul8(pre + j, pim + j, cs, sn);
+        }
+    }
+
+    //one level of the general loop of the ifft (butterflies of size 2*halfnn)
+    void ifft_level(double *are, double *aim, const int32_t ns4, const int32_t halfnn, const double *cur_tt) {
+        const int32_t nn = 2 * halfnn;
+        for (int32_t block = 0; block < ns4; block += nn) {
+            if (halfnn == 4) {
+                // the two halves are in the same zmm: stay on 4 coefficients
+                double *d00 = are + block;
+                double *d01 = aim + block;
+                double *d10 = d00 + 4;
+                double *d11 = d01 + 4;
+                const __m256d r0 = _mm256_loadu_pd(cur_tt);
+                const __m256d r1 = _mm256_loadu_pd(cur_tt + 4);
+                const __m256d a0 = _mm256_loadu_pd(d00);
+                const __m256d b0 = _mm256_loadu_pd(d01);
+                const __m256d a1 = _mm256_loadu_pd(d10);
+                const __m256d b1 = _mm256_loadu_pd(d11);
+                const __m256d tre = _mm256_sub_pd(a0, a1);
+                const __m256d tim = _mm256_sub_pd(b0, b1);
+                _mm256_storeu_pd(d00, _mm256_add_pd(a0, a1));
+                _mm256_storeu_pd(d01, _mm256_add_pd(b0, b1));
+                _mm256_storeu_pd(d10, _mm256_fmsub_pd(tre, r0, _mm256_mul_pd(tim, r1)));
+                _mm256_storeu_pd(d11, _mm256_fmadd_pd(tre, r1, _mm256_mul_pd(tim, r0)));
+                continue;
+            }
+            for (int32_t off = 0; off < halfnn; off += 8) {
+                double *d00 = are + block + off;
+                double *d01 = aim + block + off;
+                double *d10 = are + block + halfnn + off;
+                double *d11 = aim + block + halfnn + off;
+                __m512d r0, r1;
+                load_trig8(r0, r1, cur_tt + 2 * off);
+                const __m512d a0 = _mm512_loadu_pd(d00);
+                const __m512d b0 = _mm512_loadu_pd(d01);
+                const __m512d a1 = _mm512_loadu_pd(d10);
+                const __m512d b1 = _mm512_loadu_pd(d11);
+                const __m512d tre = _mm512_sub_pd(a0, a1);
+                const __m512d tim = _mm512_sub_pd(b0, b1);
+                _mm512_storeu_pd(d00, _mm512_add_pd(a0, a1));
+                _mm512_storeu_pd(d01, _mm512_add_pd(b0, b1));
+                _mm512_storeu_pd(d10, _mm512_fmsub_pd(tre, r0, _mm512_mul_pd(tim, r1)));
+                _mm512_storeu_pd(d11, _mm512_fmadd_pd(tre, r1, _mm512_mul_pd(tim, r0)));
+            }
+        }
+    }
+
+    //size 4 and size 2 butterflies of the ifft (independent blocks of 8)
+    void ifft_last_levels(double *are, double *aim, const int32_t ns4) {
+        //size 4
+        // r0 + r2    i0 + i2
+        // r1 + r3    i1 + i3
+        // r0 - r2    i0 - i2
+        // i3 - i1    r1 - r3
+        const __m512i idx_x = _mm512_set_epi64(13, 4, 5, 4, 9, 0, 1, 0);
+        const __m512i idx_y = _mm512_set_epi64(15, 6, 7, 6, 11, 2, 3, 2);
+        for (int32_t block = 0; block < ns4; block += 8) {
+            const __m512d re = _mm512_loadu_pd(are + block);
+            const __m512d im = _mm512_loadu_pd(aim + block);
+            const __m512d xre = _mm512_permutex2var_pd(re, idx_x, im); // r0,r1,r0,i1
+            const __m512d yre = _mm512_permutex2var_pd(re, idx_y, im); // r2,r3,r2,i3
+            const __m512d xim = _mm512_permutex2var_pd(im, idx_x, re); // i0,i1,i0,r1
+            const __m512d yim = _mm512_permutex2var_pd(im, idx_y, re); // i2,i3,i2,r3
+            __m512d sre = _mm512_mask_sub_pd(_mm512_add_pd(xre, yre), 0x44, xre, yre);
+            sre = _mm512_mask_sub_pd(sre, 0x88, yre, xre);
+            _mm512_storeu_pd(are + block, sre);
+            _mm512_storeu_pd(aim + block, _mm512_mask_sub_pd(_mm512_add_pd(xim, yim), 0xCC, xim, yim));
+        }
+
+        //size 2
+        for (int32_t block = 0; block < ns4; block += 8) {
+            butterfly2(are + block);
+            butterfly2(aim + block);
+        }
+    }
+
+}
+
+// the batches run each level on all the buffers before the next one: the
+// butterflies of different buffers are independent, and share the trig
+// tables of the level
+extern "C" void fft_batch(const void *tables, double *const *c, const int32_t count) {
+    const FFT_PRECOMP_AVX512 *fft_tables = (const FFT_PRECOMP_AVX512 *) tables;
+    const int32_t n = fft_tables->n;
+    const double *trig_tables = fft_tables->aligned_trig_tables;
+    const int32_t ns4 = n / 4;
+
+    for (int32_t j = 0; j < count; j++)
+        fft_first_levels(c[j], c[j] + ns4, ns4);
+
+    //general loop
+    const double *cur_tt = trig_tables;
+    for (int32_t halfnn = 4; halfnn < ns4; halfnn *= 2) {
+        for (int32_t j = 0; j < count; j++)
+            fft_level(c[j], c[j] + ns4, ns4, halfnn, cur_tt);
+        cur_tt += 2 * halfnn;
+    }
+
+    for (int32_t j = 0; j < count; j++)
+        twist(c[j], c[j] + ns4, ns4, cur_tt);
+}
+
+extern "C" void ifft_batch(const void *tables, double *const *c, const int32_t count) {
+    const FFT_PRECOMP_AVX512 *fft_tables = (const FFT_PRECOMP_AVX512 *) tables;
+    const int32_t n = fft_tables->n;
+    const double *trig_tables = fft_tables->aligned_trig_tables;
+    const int32_t ns4 = n / 4;
+
+    for (int32_t j = 0; j < count; j++)
+        twist(c[j], c[j] + ns4, ns4, trig_tables);
+
+    //general loop
+    const double *cur_tt = trig_tables;
+    for (int32_t nn = ns4; nn >= 8; nn /= 2) {
+        cur_tt += 2 * nn;
+        for (int32_t j = 0; j < count; j++)
+            ifft_level(c[j], c[j] + ns4, ns4, nn / 2, cur_tt);
+    }
+
+    for (int32_t j = 0; j < count; j++)
+        ifft_last_levels(c[j], c[j] + ns4, ns4);
+}
+
+extern "C" void fft(const void *tables, double *c) {
+    fft_batch(tables, &c, 1);
+}
+
+extern "C" void ifft(const void *tables, double *c) {
+    ifft_batch(tables, &c, 1);
+}
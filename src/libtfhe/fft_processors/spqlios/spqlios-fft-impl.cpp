@@ -201,6 +201,19 @@ extern "C" double *ifft_table_get_buffer(const void *tables) {
 }
 
 //c has size n/2
+#ifndef SPQLIOS_AVX512
+// the assembly kernels transform one buffer at a time
+extern "C" void fft_batch(const void *tables, double *const *data, int32_t count) {
+    for (int32_t j = 0; j < count; j++)
+        fft(tables, data[j]);
+}
+
+extern "C" void ifft_batch(const void *tables, double *const *data, int32_t count) {
+    for (int32_t j = 0; j < count; j++)
+        ifft(tables, data[j]);
+}
+#endif
+
 extern "C" void fft_model(const void *tables) {
     double tmp0[4];
     double tmp1[4];
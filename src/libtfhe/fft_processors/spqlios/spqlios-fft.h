@@ -13,6 +13,9 @@ void fft_model(const void *tables);
 void ifft_model(void *tables);
 void fft(const void *tables, double *data);
 void ifft(const void *tables, double *data);
+// fft and ifft of count buffers (with the alignment of the table buffer), in place
+void fft_batch(const void *tables, double *const *data, int32_t count);
+void ifft_batch(const void *tables, double *const *data, int32_t count);
 
 #ifdef __cplusplus
 }
@@ -33,19 +33,23 @@ EXPORT void init_LweBootstrappingKeyFFT(LweBootstrappingKeyFFT *obj,
 
   LweKeySwitchKey *ks = new_LweKeySwitchKey(N, t, basebit, in_out_params);
   // Copy the KeySwitching key
-  for (int32_t i = 0; i < N; i++) {
-    for (int32_t j = 0; j < t; j++) {
-      for (int32_t p = 0; p < base; p++) {
-        lweCopy(&ks->ks[i][j][p], &bk->ks->ks[i][j][p], in_out_params);
+  tfhe_keyGenerationParallelFor(N, false, [&](int32_t begin, int32_t end) {
+    for (int32_t i = begin; i < end; i++) {
+      for (int32_t j = 0; j < t; j++) {
+        for (int32_t p = 0; p < base; p++) {
+          lweCopy(&ks->ks[i][j][p], &bk->ks->ks[i][j][p], in_out_params);
+        }
       }
     }
-  }
+  });
 
-  // Bootstrapping Key FFT
+  // Bootstrapping Key FFT (each thread uses its own fft processor)
   TGswSampleFFT *bkFFT = new_TGswSampleFFT_array(n, bk_params);
-  for (int32_t i = 0; i < n; ++i) {
-    tGswToFFTConvert(&bkFFT[i], &bk->bk[i], bk_params);
-  }
+  tfhe_keyGenerationParallelFor(n, false, [&](int32_t begin, int32_t end) {
+    for (int32_t i = begin; i < end; ++i) {
+      tGswToFFTConvert(&bkFFT[i], &bk->bk[i], bk_params);
+    }
+  });
 
   new (obj) LweBootstrappingKeyFFT(in_out_params, bk_params, accum_params,
                                    extract_params, bkFFT, ks);
@@ -5,8 +5,10 @@
 #ifndef TFHE_TEST_ENVIRONMENT
 
 #include "tfhe.h"
+#include <atomic>
 #include <cassert>
 #include <iostream>
+#include <vector>
 
 using namespace std;
 #define INCLUDE_ALL
@@ -17,50 +19,218 @@ using namespace std;
 
 void tfhe_sparseMuxRotate_FFT(TLweSample *result, const TLweSample *accum,
                               const TGswSampleFFT *bki, const int32_t *bara,
-                              const int32_t d, const TGswParams *bk_params) {
+                              const int32_t d, const TGswParams *bk_params,
+                              LweBootstrappingWorkspace *ws) {
+  if (ws->recompose_accum) {
+    // ACC = BKi*[(X^barai-1)*ACC]+ACC, the +ACC staying in the FFT domain
+    tGswFFTExternMulToTLweHoistingAddTo(result, accum, bki, bara, d,
+                                        bk_params, ws);
+    return;
+  }
   // ACC = BKi*[(X^barai-1)*ACC]+ACC
   // temp = (X^barai-1)*ACC
   tLweCopy(result, accum, bk_params->tlwe_params);
   // temp *= BKi
 
-  tGswFFTExternMulToTLweHoisting(result, bki, bara, d, bk_params);
+  tGswFFTExternMulToTLweHoisting(result, bki, bara, d, bk_params, ws);
 
   // ACC += temp
   tLweAddTo(result, accum, bk_params->tlwe_params);
 }
 
+namespace {
+// statistics of the sparse blind rotations, see tfhe_sparseRotateStats
+atomic<int64_t> stat_nb_blocks(0);
+atomic<int64_t> stat_nb_skipped_blocks(0);
+atomic<int64_t> stat_nb_entries(0);
+atomic<int64_t> stat_nb_skipped_entries(0);
+
+// number of zero coefficients among bara[0..d[ (the block is skipped when
+// it is d: the external product of a zero rotation is zero)
+inline int32_t tfhe_countZeroRotations(const int32_t *bara, const int32_t d) {
+  int32_t zeros = 0;
+  for (int32_t i = 0; i < d; i++)
+    zeros += (bara[i] == 0);
+  return zeros;
+}
+
+// adds the counts of one blind rotation (a few atomics per bootstrapping)
+void tfhe_recordSparseRotate(const int32_t hw, const int32_t d,
+                             const int32_t nb_skipped_blocks,
+                             const int32_t nb_zeros) {
+  stat_nb_blocks += hw;
+  stat_nb_skipped_blocks += nb_skipped_blocks;
+  stat_nb_entries += int64_t(hw) * d;
+  stat_nb_skipped_entries += nb_zeros;
+}
+} // namespace
+
+EXPORT void tfhe_sparseRotateStats(TFheSparseRotateStats *result) {
+  result->nb_blocks = stat_nb_blocks;
+  result->nb_skipped_blocks = stat_nb_skipped_blocks;
+  result->nb_entries = stat_nb_entries;
+  result->nb_skipped_entries = stat_nb_skipped_entries;
+}
+
+EXPORT void tfhe_resetSparseRotateStats() {
+  stat_nb_blocks = 0;
+  stat_nb_skipped_blocks = 0;
+  stat_nb_entries = 0;
+  stat_nb_skipped_entries = 0;
+}
+
 #if defined INCLUDE_ALL || defined INCLUDE_TFHE_BLIND_ROTATE_FFT
 #undef INCLUDE_TFHE_BLIND_ROTATE_FFT
+namespace {
+/** a sparse blind rotation shared between the members of a bootstrap team */
+struct SparseBlindRotateJob {
+  TLweSample *accum;
+  const TGswSampleFFT *bkFFT;
+  const int32_t *bara;
+  int32_t d;
+  int32_t hw;
+  const TGswParams *bk_params;
+  TFheBootstrapTeam *team;
+  int32_t nb_members;
+  // the workspace of each member: the one of member 0 holds the shared
+  // accumulators and the fft of the decomposition
+  LweBootstrappingWorkspace *ws[TFHE_BOOTSTRAP_TEAM_MAX_THREADS];
+};
+
+/**
+ * the member m of the team does, in each block: the decomposition in the
+ * FFT domain of the polynomials q = m mod nb_members, the products of the entries
+ * i = m mod nb_members in its own accumulator, and the sum of the
+ * accumulators and the final FFT of the polynomials q = m mod nb_members
+ */
+void tfhe_sparseBlindRotateMember_FFT(int32_t m, void *arg) {
+  SparseBlindRotateJob *job = (SparseBlindRotateJob *)arg;
+  const TGswParams *bk_params = job->bk_params;
+  const TLweParams *accum_params = bk_params->tlwe_params;
+  const int32_t k = accum_params->k;
+  const int32_t l = bk_params->l;
+  const int32_t d = job->d;
+  const int32_t T = job->nb_members;
+  LweBootstrappingWorkspace *ws0 = job->ws[0];
+  LweBootstrappingWorkspace *ws = ws0;
+  if (m != 0) {
+    // (the members only use the buffers of the external products)
+    ws = tfhe_threadBootstrappingWorkspace(bk_params, 0);
+    ws->rotated = ws0->rotated;
+    job->ws[m] = ws;
+  }
+  tfhe_bootstrapTeamBarrier(job->team);
+
+  LagrangeHalfCPolynomial *decaFFT = ws0->decaFFT;
+  TLweSampleFFT *sum = ws0->tmpa;
+  TLweSample *temp2 = ws0->temp;
+  TLweSample *temp3 = job->accum;
+  int32_t nb_skipped_blocks = 0;
+  int32_t nb_zeros = 0;
+
+  for (int32_t b = 0; b < job->hw; b++) {
+    // all the members skip the same blocks
+    const int32_t zeros = tfhe_countZeroRotations(job->bara + b * d, d);
+    nb_zeros += zeros;
+    if (zeros == d) {
+      nb_skipped_blocks++;
+      continue;
+    }
+    // temp2 = BKb*[(X^barab-1)*temp3]+temp3
+    for (int32_t q = m; q <= k; q += T)
+      tGswTorus32PolynomialDecompHFFT(decaFFT + q * l, temp3->a + q,
+                                      bk_params);
+    tfhe_bootstrapTeamBarrier(job->team);
+
+    tLweFFTClear(ws->tmpa, accum_params);
+    tGswFFTExternMulHoistingShare(ws->tmpa, job->bkFFT + b * d,
+                                  job->bara + b * d, d, m, T, decaFFT,
+                                  bk_params, ws);
+    tfhe_bootstrapTeamBarrier(job->team);
+
+    for (int32_t q = m; q <= k; q += T) {
+      for (int32_t j = 1; j < T; j++)
+        LagrangeHalfCPolynomialAddTo(sum->a + q, job->ws[j]->tmpa->a + q);
+      // + temp3, recomposed from its decomposition or exactly
+      if (ws0->recompose_accum)
+        for (int32_t j = 0; j < l; j++)
+          LagrangeHalfCPolynomialAddMul(sum->a + q, decaFFT + q * l + j,
+                                        ws0->gadget + j);
+      TorusPolynomial_fft(temp2->a + q, sum->a + q);
+      if (!ws0->recompose_accum)
+        torusPolynomialAddTo(temp2->a + q, temp3->a + q);
+    }
+    if (m == 0)
+      temp2->current_variance = temp3->current_variance;
+    tfhe_bootstrapTeamBarrier(job->team);
+    swap(temp2, temp3);
+  }
+
+  if (m != 0) {
+    ws->rotated = 0;
+    return;
+  }
+  if (temp3 != job->accum)
+    tLweCopy(job->accum, temp3, accum_params);
+  tfhe_recordSparseRotate(job->hw, d, nb_skipped_blocks, nb_zeros);
+}
+} // namespace
+
 /**
  * multiply the accumulator by X^sum(bara_i.s_i)
  * @param accum the TLWE sample to multiply
  * @param bk An array of n TGSW FFT samples where bk_i encodes s_i
  * @param bara An array of n coefficients between 0 and 2N-1
  * @param bk_params The parameters of bk
+ * @param ws The scratch space of the calling thread
  */
 EXPORT void tfhe_sparseBlindRotate_FFT(TLweSample *accum,
                                        const TGswSampleFFT *bkFFT,
                                        const int32_t *bara, const int32_t n,
                                        const int32_t hw,
                                        const TLweParams *params,
-                                       const TGswParams *bk_params) {
+                                       const TGswParams *bk_params,
+                                       LweBootstrappingWorkspace *ws) {
 
   const int32_t d = n / hw;
-  TLweSample *temp = new_TLweSample(bk_params->tlwe_params);
-  TLweSample *temp2 = temp;
+
+  if (ws->team && tfhe_bootstrapTeamNbThreads(ws->team) > 1) {
+    SparseBlindRotateJob job;
+    job.accum = accum;
+    job.bkFFT = bkFFT;
+    job.bara = bara;
+    job.d = d;
+    job.hw = hw;
+    job.bk_params = bk_params;
+    job.team = ws->team;
+    job.nb_members = tfhe_bootstrapTeamNbThreads(ws->team);
+    job.ws[0] = ws;
+    tfhe_bootstrapTeamRun(ws->team, tfhe_sparseBlindRotateMember_FFT, &job);
+    return;
+  }
+
+  TLweSample *temp2 = ws->temp;
   TLweSample *temp3 = accum;
+  int32_t nb_skipped_blocks = 0;
+  int32_t nb_zeros = 0;
 
   for (int32_t i = 0; i < hw; i++) {
+    // a block without rotation leaves the accumulator unchanged
+    const int32_t zeros = tfhe_countZeroRotations(bara + i * d, d);
+    nb_zeros += zeros;
+    if (zeros == d) {
+      nb_skipped_blocks++;
+      continue;
+    }
 
     tfhe_sparseMuxRotate_FFT(temp2, temp3, bkFFT + i * d, bara + i * d, d,
-                             bk_params);
+                             bk_params, ws);
     swap(temp2, temp3);
   }
   if (temp3 != accum) {
     tLweCopy(accum, temp3, bk_params->tlwe_params);
   }
-
-  delete_TLweSample(temp);
+  tfhe_recordSparseRotate(hw, d, nb_skipped_blocks, nb_zeros);
 }
 #endif
 
@@ -74,11 +244,12 @@ EXPORT void tfhe_sparseBlindRotate_FFT(TLweSample *accum,
  * @param barb A coefficients between 0 and 2N-1
  * @param bara An array of n coefficients between 0 and 2N-1
  * @param bk_params The parameters of bk
+ * @param ws The scratch space of the calling thread
  */
 EXPORT void tfhe_sparseBlindRotateAndExtract_FFT(
     LweSample *result, const TorusPolynomial *v, const TGswSampleFFT *bk,
     const int32_t barb, const int32_t *bara, const int32_t n, const int32_t hw,
-    const TGswParams *bk_params) {
+    const TGswParams *bk_params, LweBootstrappingWorkspace *ws) {
 
   const TLweParams *accum_params = bk_params->tlwe_params;
   const LweParams *extract_params = &accum_params->extracted_lweparams;
@@ -86,9 +257,9 @@ EXPORT void tfhe_sparseBlindRotateAndExtract_FFT(
   const int32_t _2N = 2 * N;
 
   // Test polynomial
-  TorusPolynomial *testvectbis = new_TorusPolynomial(N);
+  TorusPolynomial *testvectbis = ws->testvectbis;
   // Accumulator
-  TLweSample *acc = new_TLweSample(accum_params);
+  TLweSample *acc = ws->acc;
 
   int32_t temp = (_2N - barb) % _2N;
   /*
@@ -107,27 +278,25 @@ EXPORT void tfhe_sparseBlindRotateAndExtract_FFT(
 
   tLweNoiselessTrivial(acc, testvectbis, accum_params);
   // Blind rotation
-  tfhe_sparseBlindRotate_FFT(acc, bk, bara, n, hw, accum_params, bk_params);
+  tfhe_sparseBlindRotate_FFT(acc, bk, bara, n, hw, accum_params, bk_params,
+                             ws);
   // Extraction
   tLweExtractLweSample(result, acc, extract_params, accum_params);
-
-  delete_TLweSample(acc);
-  delete_TorusPolynomial(testvectbis);
 }
 #endif
 
-#if defined INCLUDE_ALL || defined INCLUDE_TFHE_BOOTSTRAP_WO_KS_FFT
-#undef INCLUDE_TFHE_BOOTSTRAP_WO_KS_FFT
+#if defined INCLUDE_ALL || defined INCLUDE_TFHE_PROGRAMMABLE_BOOTSTRAP_WO_KS_FFT
+#undef INCLUDE_TFHE_PROGRAMMABLE_BOOTSTRAP_WO_KS_FFT
 /**
- * result = LWE(mu) iff phase(x)>0, LWE(-mu) iff phase(x)<0
+ * result = LWE(v_p) where p=round(2N.phase(x)), with v_p=-v_(p-N) for p>=N
  * @param result The resulting LweSample
  * @param bk The bootstrapping + keyswitch key
- * @param mu The output message (if phase(x)>0)
+ * @param testvect The N coefficients v_0..v_(N-1) of the test vector
  * @param x The input sample
  */
-EXPORT void tfhe_sparseBootstrap_woKS_FFT(LweSample *result, const int32_t hw,
-                                          const LweBootstrappingKeyFFT *bk,
-                                          Torus32 mu, const LweSample *x) {
+EXPORT void tfhe_sparseProgrammableBootstrap_woKS_FFT(
+    LweSample *result, const int32_t hw, const LweBootstrappingKeyFFT *bk,
+    const TorusPolynomial *testvect, const LweSample *x) {
 
   const TGswParams *bk_params = bk->bk_params;
   const TLweParams *accum_params = bk->accum_params;
@@ -135,9 +304,11 @@ EXPORT void tfhe_sparseBootstrap_woKS_FFT(LweSample *result, const int32_t hw,
   const int32_t N = accum_params->N;
   const int32_t Nx2 = 2 * N;
   const int32_t n = in_params->n;
+  LweBootstrappingWorkspace *ws =
+      tfhe_threadBootstrappingWorkspace(bk_params, n);
+  assert(n <= ws->nmax);
 
-  TorusPolynomial *testvect = new_TorusPolynomial(N);
-  int32_t *bara = new int32_t[N];
+  int32_t *bara = ws->bara;
 
   // Modulus switching
   int32_t barb = modSwitchFromTorus32(x->b, Nx2);
@@ -145,16 +316,39 @@ EXPORT void tfhe_sparseBootstrap_woKS_FFT(LweSample *result, const int32_t hw,
     bara[i] = modSwitchFromTorus32(x->a[i], Nx2);
   }
 
+  // Bootstrapping rotation and extraction
+  ws->rotated = bk->rotated;
+  ws->recompose_accum = bk->recompose_accum;
+  tfhe_sparseBlindRotateAndExtract_FFT(result, testvect, bk->bkFFT, barb, bara,
+                                       n, hw, bk_params, ws);
+  ws->rotated = 0;
+  ws->recompose_accum = 0;
+}
+#endif
+
+#if defined INCLUDE_ALL || defined INCLUDE_TFHE_BOOTSTRAP_WO_KS_FFT
+#undef INCLUDE_TFHE_BOOTSTRAP_WO_KS_FFT
+/**
+ * result = LWE(mu) iff phase(x)>0, LWE(-mu) iff phase(x)<0
+ * @param result The resulting LweSample
+ * @param bk The bootstrapping + keyswitch key
+ * @param mu The output message (if phase(x)>0)
+ * @param x The input sample
+ */
+EXPORT void tfhe_sparseBootstrap_woKS_FFT(LweSample *result, const int32_t hw,
+                                          const LweBootstrappingKeyFFT *bk,
+                                          Torus32 mu, const LweSample *x) {
+
+  const int32_t N = bk->accum_params->N;
+  TorusPolynomial *testvect =
+      tfhe_threadBootstrappingWorkspace(bk->bk_params, bk->in_out_params->n)
+          ->testvect;
+
   // the initial testvec = [mu,mu,mu,...,mu]
   for (int32_t i = 0; i < N; i++)
     testvect->coefsT[i] = mu;
 
-  // Bootstrapping rotation and extraction
-  tfhe_sparseBlindRotateAndExtract_FFT(result, testvect, bk->bkFFT, barb, bara,
-                                       n, hw, bk_params);
-
-  delete[] bara;
-  delete_TorusPolynomial(testvect);
+  tfhe_sparseProgrammableBootstrap_woKS_FFT(result, hw, bk, testvect, x);
 }
 #endif
 
@@ -171,12 +365,390 @@ EXPORT void tfhe_sparseBootstrap_FFT(LweSample *result, const int32_t hw,
                                      const LweBootstrappingKeyFFT *bk,
                                      Torus32 mu, const LweSample *x) {
 
-  LweSample *u = new_LweSample(&bk->accum_params->extracted_lweparams);
+  LweSample *u =
+      tfhe_threadBootstrappingWorkspace(bk->bk_params, bk->in_out_params->n)
+          ->u;
 
   tfhe_sparseBootstrap_woKS_FFT(u, hw, bk, mu, x);
   // Key switching
   lweSparseKeySwitch(result, bk->ks, u);
+}
+#endif
+
+#if defined INCLUDE_ALL || defined INCLUDE_TFHE_LUT_TEST_VECTOR
+#undef INCLUDE_TFHE_LUT_TEST_VECTOR
+/**
+ * testvect = the test vector of the lookup table m -> outputs[m], for the
+ * messages m in [0,msize[ encoded as m/(2.msize) (one bit of padding, see
+ * tfhe_sparseLutBootstrap_FFT): the phases p/2N within 1/(4.msize) of
+ * m/(2.msize) give outputs[m]. The negative phases around 0 rotate past
+ * X^N, hence the -outputs[0] of the last half-box.
+ */
+EXPORT void tfhe_lutTestVector(TorusPolynomial *testvect,
+                               const Torus32 *outputs, const int32_t msize) {
+  const int32_t N = testvect->N;
+  assert(msize >= 1 && msize <= N);
+  for (int32_t j = 0; j < N; j++) {
+    // the nearest message of the phase j/2N
+    const int32_t m = int32_t((int64_t(2 * j) * msize + N) / (2 * N));
+    testvect->coefsT[j] = m < msize ? outputs[m] : -outputs[0];
+  }
+}
+#endif
+
+#if defined INCLUDE_ALL || defined INCLUDE_TFHE_PROGRAMMABLE_BOOTSTRAP_FFT
+#undef INCLUDE_TFHE_PROGRAMMABLE_BOOTSTRAP_FFT
+/**
+ * tfhe_sparseProgrammableBootstrap_woKS_FFT followed by the key switching
+ * @param result The resulting LweSample
+ * @param bk The bootstrapping + keyswitch key
+ * @param testvect The test vector (see tfhe_lutTestVector)
+ * @param x The input sample
+ */
+EXPORT void tfhe_sparseProgrammableBootstrap_FFT(
+    LweSample *result, const int32_t hw, const LweBootstrappingKeyFFT *bk,
+    const TorusPolynomial *testvect, const LweSample *x) {
+
+  LweSample *u =
+      tfhe_threadBootstrappingWorkspace(bk->bk_params, bk->in_out_params->n)
+          ->u;
+
+  tfhe_sparseProgrammableBootstrap_woKS_FFT(u, hw, bk, testvect, x);
+  // Key switching
+  lweSparseKeySwitch(result, bk->ks, u);
+}
+
+/**
+ * result = LWE(table[m]/(2.msize)) for x = LWE(m/(2.msize))
+ * (modSwitchToTorus32(m, 2*msize)), m in [0,msize[: the outputs use the
+ * encoding of the inputs, so that lookups can be chained
+ * @param result The resulting LweSample
+ * @param bk The bootstrapping + keyswitch key
+ * @param table The msize outputs of the lookup table, in [0,msize[
+ * @param msize The message modulus
+ * @param x The input sample
+ */
+EXPORT void tfhe_sparseLutBootstrap_FFT(LweSample *result, const int32_t hw,
+                                        const LweBootstrappingKeyFFT *bk,
+                                        const int32_t *table,
+                                        const int32_t msize,
+                                        const LweSample *x) {
+  TorusPolynomial *testvect =
+      tfhe_threadBootstrappingWorkspace(bk->bk_params, bk->in_out_params->n)
+          ->testvect;
+  static thread_local vector<Torus32> outputs;
+  outputs.resize(msize);
+  for (int32_t m = 0; m < msize; m++)
+    outputs[m] = modSwitchToTorus32(table[m], 2 * msize);
+  tfhe_lutTestVector(testvect, outputs.data(), msize);
+
+  tfhe_sparseProgrammableBootstrap_FFT(result, hw, bk, testvect, x);
+}
+#endif
+
+#if defined INCLUDE_ALL || defined INCLUDE_TFHE_MULTI_VALUE_BOOTSTRAP_FFT
+#undef INCLUDE_TFHE_MULTI_VALUE_BOOTSTRAP_FFT
+namespace {
+// ws->acc = X^-p.[mu,...,mu], p the modulus-switched phase of x
+void tfhe_sparseMultiValueBlindRotate_FFT(const int32_t hw,
+                                          const LweBootstrappingKeyFFT *bk,
+                                          Torus32 mu, const LweSample *x,
+                                          LweBootstrappingWorkspace *ws) {
+  const TGswParams *bk_params = bk->bk_params;
+  const TLweParams *accum_params = bk->accum_params;
+  const int32_t N = accum_params->N;
+  const int32_t Nx2 = 2 * N;
+  const int32_t n = bk->in_out_params->n;
+  assert(n <= ws->nmax);
+
+  int32_t *bara = ws->bara;
+  TorusPolynomial *testvectbis = ws->testvectbis;
+
+  // Modulus switching
+  const int32_t barb = modSwitchFromTorus32(x->b, Nx2);
+  for (int32_t i = 0; i < n; i++) {
+    bara[i] = modSwitchFromTorus32(x->a[i], Nx2);
+  }
+
+  // testvectbis = X^-barb.[mu,...,mu]
+  for (int32_t i = 0; i < N; i++)
+    ws->testvect->coefsT[i] = mu;
+  torusPolynomialMulByXai(testvectbis, (Nx2 - barb) % Nx2, ws->testvect);
+  tLweNoiselessTrivial(ws->acc, testvectbis, accum_params);
+
+  ws->rotated = bk->rotated;
+  ws->recompose_accum = bk->recompose_accum;
+  tfhe_sparseBlindRotate_FFT(ws->acc, bk->bkFFT, bara, n, hw, accum_params,
+                             bk_params, ws);
+  ws->rotated = 0;
+  ws->recompose_accum = 0;
+}
+
+// the lookup table factors of a thread, kept from one call to the next
+struct ThreadLutFactors {
+  IntPolynomial *factors;
+  int32_t nb;
+  int32_t N;
+
+  ThreadLutFactors() : factors(0), nb(0), N(0) {}
+
+  ~ThreadLutFactors() {
+    if (factors)
+      delete_IntPolynomial_array(nb, factors);
+  }
+
+  IntPolynomial *get(const int32_t nb, const int32_t N) {
+    if (nb > this->nb || N != this->N) {
+      if (factors)
+        delete_IntPolynomial_array(this->nb, factors);
+      factors = new_IntPolynomial_array(nb, N);
+      this->nb = nb;
+      this->N = N;
+    }
+    return factors;
+  }
+};
+
+thread_local ThreadLutFactors thread_lut_factors;
+} // namespace
+
+/**
+ * results[i] = LWE(v_i[p]) with v_i = [mu,...,mu].factors[i] mod X^N+1, for
+ * i < nbOutputs: the test vector [mu,...,mu] is blind rotated once, and the
+ * rotated accumulator is multiplied by each factor before the extraction
+ * (the noise of the rotation is multiplied by the norm of the factor)
+ * @param results The nbOutputs resulting LweSamples
+ * @param bk The bootstrapping + keyswitch key
+ * @param mu The common factor of the test vectors
+ * @param factors The nbOutputs integer factors of the test vectors
+ * @param x The input sample
+ */
+EXPORT void tfhe_sparseMultiValueBootstrap_woKS_FFT(
+    LweSample *results, const int32_t hw, const LweBootstrappingKeyFFT *bk,
+    Torus32 mu, const IntPolynomial *factors, const int32_t nbOutputs,
+    const LweSample *x) {
+  const TLweParams *accum_params = bk->accum_params;
+  LweBootstrappingWorkspace *ws =
+      tfhe_threadBootstrappingWorkspace(bk->bk_params, bk->in_out_params->n);
+
+  tfhe_sparseMultiValueBlindRotate_FFT(hw, bk, mu, x, ws);
+  for (int32_t i = 0; i < nbOutputs; i++) {
+    tLweClear(ws->temp, accum_params);
+    tLweAddMulRTo(ws->temp, factors + i, ws->acc, accum_params);
+    tLweExtractLweSample(results + i, ws->temp,
+                         &accum_params->extracted_lweparams, accum_params);
+  }
+}
+
+/** tfhe_sparseMultiValueBootstrap_woKS_FFT followed by the key switchings */
+EXPORT void tfhe_sparseMultiValueBootstrap_FFT(
+    LweSample *results, const int32_t hw, const LweBootstrappingKeyFFT *bk,
+    Torus32 mu, const IntPolynomial *factors, const int32_t nbOutputs,
+    const LweSample *x) {
+  const TLweParams *accum_params = bk->accum_params;
+  LweBootstrappingWorkspace *ws =
+      tfhe_threadBootstrappingWorkspace(bk->bk_params, bk->in_out_params->n);
+
+  tfhe_sparseMultiValueBlindRotate_FFT(hw, bk, mu, x, ws);
+  for (int32_t i = 0; i < nbOutputs; i++) {
+    tLweClear(ws->temp, accum_params);
+    tLweAddMulRTo(ws->temp, factors + i, ws->acc, accum_params);
+    tLweExtractLweSample(ws->u, ws->temp, &accum_params->extracted_lweparams,
+                         accum_params);
+    lweSparseKeySwitch(results + i, bk->ks, ws->u);
+  }
+}
+
+/**
+ * results[i] = LWE(tables[i*msize+m]/(2.msize)) for x = LWE(m/(2.msize)),
+ * i < nbTables, with a single blind rotation (see tfhe_sparseLutBootstrap_FFT
+ * for the encoding). The test vector v_i of the table i is
+ * [mu,...,mu].(1-X).w_i with mu = 1/(4.msize) and w_i the integer test
+ * vector of the table, since (1+X+...+X^(N-1)).(1-X) = 2 mod X^N+1: the
+ * factor (1-X).w_i has one coefficient per step of the table, and the noise
+ * of the rotation is multiplied by the square root of the sum of the
+ * squared steps: 2 for the sum bit of a full adder, but 3.5 for the
+ * identity on 4 messages, whose wrap-around step is 3.
+ * @param results The nbTables resulting LweSamples
+ * @param bk The bootstrapping + keyswitch key
+ * @param tables The nbTables tables of msize outputs in [0,msize[
+ * @param msize The message modulus
+ * @param x The input sample
+ */
+EXPORT void tfhe_sparseMultiLutBootstrap_FFT(LweSample *results,
+                                             const int32_t hw,
+                                             const LweBootstrappingKeyFFT *bk,
+                                             const int32_t *tables,
+                                             const int32_t nbTables,
+                                             const int32_t msize,
+                                             const LweSample *x) {
+  const int32_t N = bk->accum_params->N;
+  TorusPolynomial *w =
+      tfhe_threadBootstrappingWorkspace(bk->bk_params, bk->in_out_params->n)
+          ->testvectbis;
+  IntPolynomial *factors = thread_lut_factors.get(nbTables, N);
+
+  for (int32_t i = 0; i < nbTables; i++) {
+    // the integer test vector w_i (the outputs as integers), then (1-X).w_i
+    tfhe_lutTestVector(w, tables + i * msize, msize);
+    int32_t *f = factors[i].coefs;
+    f[0] = w->coefsT[0] + w->coefsT[N - 1];
+    for (int32_t j = 1; j < N; j++)
+      f[j] = w->coefsT[j] - w->coefsT[j - 1];
+  }
+  tfhe_sparseMultiValueBootstrap_FFT(results, hw, bk,
+                                     modSwitchToTorus32(1, 4 * msize), factors,
+                                     nbTables, x);
+}
+#endif
+
+#if defined INCLUDE_ALL || defined INCLUDE_TFHE_BATCH_BLIND_ROTATE_FFT
+#undef INCLUDE_TFHE_BATCH_BLIND_ROTATE_FFT
+/**
+ * multiply each accumulator accum_s by X^sum(bara_s_i.s_i)
+ * The key is walked block by block, and each block of d TGSW samples is
+ * applied to the whole batch before moving to the next one, so that it is
+ * fetched from memory once per batch instead of once per sample.
+ * @param accums An array of nbSamples TLWE samples to multiply
+ * @param bk An array of n TGSW FFT samples where bk_i encodes s_i
+ * @param bara An array of nbSamples x n coefficients between 0 and 2N-1
+ *        (the coefficients of the sample s start at bara + s*n)
+ * @param nbSamples The number of samples in the batch
+ * @param bk_params The parameters of bk
+ * @param ws The scratch space of the calling thread
+ */
+EXPORT void tfhe_sparseBatchBlindRotate_FFT(TLweSample *accums,
+                                            const TGswSampleFFT *bkFFT,
+                                            const int32_t *bara,
+                                            const int32_t nbSamples,
+                                            const int32_t n, const int32_t hw,
+                                            const TGswParams *bk_params,
+                                            LweBootstrappingWorkspace *ws) {
+
+  const TLweParams *accum_params = bk_params->tlwe_params;
+  const int32_t d = n / hw;
+  tfhe_reserveBatchWorkspace(ws, nbSamples, accum_params);
+  TLweSample *temp2 = ws->batch_temp;
+  TLweSample *temp3 = accums;
+  int32_t nb_skipped_blocks = 0;
+  int32_t nb_zeros = 0;
+
+  for (int32_t i = 0; i < hw; i++) {
+    const TGswSampleFFT *bki = bkFFT + i * d;
+    for (int32_t s = 0; s < nbSamples; s++) {
+      const int32_t *baras = bara + s * n + i * d;
+      const int32_t zeros = tfhe_countZeroRotations(baras, d);
+      nb_zeros += zeros;
+      if (zeros == d) {
+        // the buffers are swapped for the whole batch: only copy
+        nb_skipped_blocks++;
+        tLweCopy(temp2 + s, temp3 + s, accum_params);
+        continue;
+      }
+      tfhe_sparseMuxRotate_FFT(temp2 + s, temp3 + s, bki, baras, d, bk_params,
+                               ws);
+    }
+    swap(temp2, temp3);
+  }
+  tfhe_recordSparseRotate(hw * nbSamples, d, nb_skipped_blocks, nb_zeros);
+  if (temp3 != accums) {
+    for (int32_t s = 0; s < nbSamples; s++)
+      tLweCopy(accums + s, temp3 + s, accum_params);
+  }
+}
+#endif
+
+#if defined INCLUDE_ALL || defined INCLUDE_TFHE_BATCH_BOOTSTRAP_WO_KS_FFT
+#undef INCLUDE_TFHE_BATCH_BOOTSTRAP_WO_KS_FFT
+/**
+ * result_s = LWE(mu) iff phase(x_s)>0, LWE(-mu) iff phase(x_s)<0, for each
+ * sample s of the batch
+ * @param results The array of nbSamples resulting LweSamples
+ * @param bk The bootstrapping + keyswitch key
+ * @param mu The output message (if phase(x)>0)
+ * @param x The array of nbSamples input samples
+ * @param nbSamples The number of samples in the batch
+ */
+EXPORT void tfhe_sparseBatchBootstrap_woKS_FFT(LweSample *results,
+                                               const int32_t hw,
+                                               const LweBootstrappingKeyFFT *bk,
+                                               Torus32 mu, const LweSample *x,
+                                               const int32_t nbSamples) {
+
+  const TGswParams *bk_params = bk->bk_params;
+  const TLweParams *accum_params = bk->accum_params;
+  const LweParams *in_params = bk->in_out_params;
+  const LweParams *extract_params = &accum_params->extracted_lweparams;
+  const int32_t N = accum_params->N;
+  const int32_t Nx2 = 2 * N;
+  const int32_t n = in_params->n;
+  LweBootstrappingWorkspace *ws =
+      tfhe_threadBootstrappingWorkspace(bk_params, n);
+
+  // the batch buffers only grow with the largest batch of the thread
+  tfhe_reserveBatchWorkspace(ws, nbSamples, accum_params);
+  TorusPolynomial *testvect = ws->testvect;
+  TorusPolynomial *testvectbis = ws->testvectbis;
+  TLweSample *acc = ws->batch_acc;
+  int32_t *bara = ws->batch_bara;
+
+  // the initial testvec = [mu,mu,mu,...,mu]
+  for (int32_t i = 0; i < N; i++)
+    testvect->coefsT[i] = mu;
+
+  for (int32_t s = 0; s < nbSamples; s++) {
+    // Modulus switching
+    const int32_t barb = modSwitchFromTorus32(x[s].b, Nx2);
+    for (int32_t i = 0; i < n; i++) {
+      bara[s * n + i] = modSwitchFromTorus32(x[s].a[i], Nx2);
+    }
+
+    // acc = (0, X^{-barb}*testvect)
+    const int32_t temp = (Nx2 - barb) % Nx2;
+    if (temp != 0)
+      torusPolynomialMulByXai(testvectbis, temp, testvect);
+    else
+      torusPolynomialCopy(testvectbis, testvect);
+    tLweNoiselessTrivial(acc + s, testvectbis, accum_params);
+  }
+
+  // Blind rotation of the whole batch
+  ws->rotated = bk->rotated;
+  ws->recompose_accum = bk->recompose_accum;
+  tfhe_sparseBatchBlindRotate_FFT(acc, bk->bkFFT, bara, nbSamples, n, hw,
+                                  bk_params, ws);
+  ws->rotated = 0;
+  ws->recompose_accum = 0;
+  // Extraction
+  for (int32_t s = 0; s < nbSamples; s++)
+    tLweExtractLweSample(results + s, acc + s, extract_params, accum_params);
+}
+#endif
+
+#if defined INCLUDE_ALL || defined INCLUDE_TFHE_BATCH_BOOTSTRAP_FFT
+#undef INCLUDE_TFHE_BATCH_BOOTSTRAP_FFT
+/**
+ * result_s = LWE(mu) iff phase(x_s)>0, LWE(-mu) iff phase(x_s)<0, for each
+ * sample s of the batch
+ * @param results The array of nbSamples resulting LweSamples
+ * @param bk The bootstrapping + keyswitch key
+ * @param mu The output message (if phase(x)>0)
+ * @param x The array of nbSamples input samples
+ * @param nbSamples The number of samples in the batch
+ */
+EXPORT void tfhe_sparseBatchBootstrap_FFT(LweSample *results, const int32_t hw,
+                                          const LweBootstrappingKeyFFT *bk,
+                                          Torus32 mu, const LweSample *x,
+                                          const int32_t nbSamples) {
+
+  LweBootstrappingWorkspace *ws =
+      tfhe_threadBootstrappingWorkspace(bk->bk_params, bk->in_out_params->n);
+  // reserved before u is handed out: the calls below do not grow it again
+  tfhe_reserveBatchWorkspace(ws, nbSamples, bk->accum_params);
+  LweSample *u = ws->batch_u;
 
-  delete_LweSample(u);
+  tfhe_sparseBatchBootstrap_woKS_FFT(u, hw, bk, mu, x, nbSamples);
+  // Key switching, in one pass over the key
+  lweSparseKeySwitchBatch(results, bk->ks, u, nbSamples);
 }
 #endif
@@ -208,9 +208,39 @@ EXPORT void tfhe_createLweBootstrappingKey(LweBootstrappingKey *bk,
   // const int32_t N = accum_params->N;
   // cout << "create the bootstrapping key bk ("  << "  " << n*kpl*(k+1)*N*4 <<
   // " bytes)" << endl; cout << "  with noise_stdev: " << alpha << endl;
-  for (int32_t i = 0; i < n; i++) {
-    tGswSymEncryptInt(&bk->bk[i], kin[i], alpha, rgsw_key);
-  }
+  tfhe_keyGenerationParallelFor(n, true, [&](int32_t begin, int32_t end) {
+    for (int32_t i = begin; i < end; i++) {
+      tGswSymEncryptInt(&bk->bk[i], kin[i], alpha, rgsw_key);
+    }
+  });
+}
+#endif
+
+#if defined INCLUDE_ALL || defined INCLUDE_TFHE_CREATESEEDEDBOOTSTRAPPINGKEY
+#undef INCLUDE_TFHE_CREATESEEDEDBOOTSTRAPPINGKEY
+EXPORT void tfhe_createSeededLweBootstrappingKey(LweBootstrappingKey *bk,
+                                                 const LweKey *key_in,
+                                                 const TGswKey *rgsw_key) {
+  assert(bk->bk_params == rgsw_key->params);
+  assert(bk->in_out_params == key_in->params);
+
+  const TLweParams *accum_params = rgsw_key->params->tlwe_params;
+  const LweParams *extract_params = &accum_params->extracted_lweparams;
+
+  LweKey *extracted_key = new_LweKey(extract_params);
+  tLweExtractKey(extracted_key, &rgsw_key->tlwe_key);
+  lweCreateSeededKeySwitchKey(bk->ks, extracted_key, key_in);
+  delete_LweKey(extracted_key);
+
+  // the line p of bk[i] is seeded by the row i.kpl+p
+  const double alpha = accum_params->alpha_min;
+  const int32_t n = bk->in_out_params->n;
+  bk->seed = tfhe_newMaskSeed();
+  tfhe_keyGenerationParallelFor(n, true, [&](int32_t begin, int32_t end) {
+    for (int32_t i = begin; i < end; i++)
+      tGswSymEncryptIntSeeded(&bk->bk[i], key_in->key[i], alpha, rgsw_key,
+                              &bk->seed, i);
+  });
 }
 #endif
 
@@ -64,6 +64,19 @@ EXPORT void lweSymEncrypt(LweSample *result, Torus32 message, double alpha,
   result->current_variance = alpha * alpha;
 }
 
+EXPORT void lweSymEncryptSeeded(LweSample *result, Torus32 message,
+                                double alpha, const LweKey *key,
+                                const TfheMaskSeed *seed, uint64_t row) {
+  const int32_t n = key->params->n;
+
+  tfhe_seededUniformTorus32(result->a, n, seed, row);
+  result->b = gaussian32(message, alpha);
+  for (int32_t i = 0; i < n; ++i)
+    result->b += result->a[i] * key->key[i];
+
+  result->current_variance = alpha * alpha;
+}
+
 /*
  * This function encrypts a message by using key and a given noise value
  */
@@ -81,6 +94,21 @@ EXPORT void lweSymEncryptWithExternalNoise(LweSample *result, Torus32 message,
   result->current_variance = alpha * alpha;
 }
 
+EXPORT void lweSymEncryptSeededWithExternalNoise(LweSample *result,
+                                                 Torus32 message, double noise,
+                                                 double alpha, const LweKey *key,
+                                                 const TfheMaskSeed *seed,
+                                                 uint64_t row) {
+  const int32_t n = key->params->n;
+
+  tfhe_seededUniformTorus32(result->a, n, seed, row);
+  result->b = message + dtot32(noise);
+  for (int32_t i = 0; i < n; ++i)
+    result->b += result->a[i] * key->key[i];
+
+  result->current_variance = alpha * alpha;
+}
+
 /**
  * This function computes the phase of sample by using key : phi = b - a.s
  */
@@ -168,9 +168,11 @@ Create the key switching key: normalize the error in the beginning
  * chose a random vector of gaussian noises (same size as ks)
  * recenter the noises
  * generate the ks by creating noiseless encryprions and then add the noise
+ * (the masks are expanded from seed if it is not null)
 */
-EXPORT void lweCreateKeySwitchKey(LweKeySwitchKey *result, const LweKey *in_key,
-                                  const LweKey *out_key) {
+void lweCreateKeySwitchKey_withSeed(LweKeySwitchKey *result,
+                                    const LweKey *in_key, const LweKey *out_key,
+                                    const TfheMaskSeed *seed) {
   const int32_t n = result->n;
   const int32_t t = result->t;
   const int32_t basebit = result->basebit;
@@ -193,38 +195,49 @@ EXPORT void lweCreateKeySwitchKey(LweKeySwitchKey *result, const LweKey *in_key,
   for (int32_t i = 0; i < sizeks; ++i)
     noise[i] -= err;
 
-  // generate the ks
-  int32_t index = 0;
-  for (int32_t i = 0; i < n; ++i) {
-    for (int32_t j = 0; j < t; ++j) {
-
-      // term h=0 as trivial encryption of 0 (it will not be used in the
-      // KeySwitching)
-      lweNoiselessTrivial(&result->ks[i][j][0], 0, out_key->params);
-      // lweSymEncrypt(&result->ks[i][j][0],0,alpha,out_key);
-
-      for (int32_t h = 1; h < base; ++h) { // pas le terme en 0
-        /*
-        // noiseless encryption
-        result->ks[i][j][h].b = (in_key->key[i]*h)*(1<<(32-(j+1)*basebit));
-        for (int32_t p = 0; p < n_out; ++p) {
-            result->ks[i][j][h].a[p] = uniformTorus32_distrib(generator);
-            result->ks[i][j][h].b += result->ks[i][j][h].a[p] * out_key->key[p];
+  // generate the ks (the elements i are split between the key generation
+  // threads)
+  tfhe_keyGenerationParallelFor(n, true, [&](int32_t begin, int32_t end) {
+    int32_t index = begin * t * (base - 1);
+    for (int32_t i = begin; i < end; ++i) {
+      for (int32_t j = 0; j < t; ++j) {
+
+        // term h=0 as trivial encryption of 0 (it will not be used in the
+        // KeySwitching)
+        lweNoiselessTrivial(&result->ks[i][j][0], 0, out_key->params);
+        // lweSymEncrypt(&result->ks[i][j][0],0,alpha,out_key);
+
+        for (int32_t h = 1; h < base; ++h) { // pas le terme en 0
+          Torus32 mess = (in_key->key[i] * h) * (1 << (32 - (j + 1) * basebit));
+          if (seed)
+            lweSymEncryptSeededWithExternalNoise(
+                &result->ks[i][j][h], mess, noise[index], alpha, out_key, seed,
+                uint64_t(i * t + j) * base + h);
+          else
+            lweSymEncryptWithExternalNoise(&result->ks[i][j][h], mess,
+                                           noise[index], alpha, out_key);
+          index += 1;
         }
-        // add the noise
-        result->ks[i][j][h].b += dtot32(noise[index]);
-        */
-        Torus32 mess = (in_key->key[i] * h) * (1 << (32 - (j + 1) * basebit));
-        lweSymEncryptWithExternalNoise(&result->ks[i][j][h], mess, noise[index],
-                                       alpha, out_key);
-        index += 1;
       }
     }
-  }
+  });
+  result->seed = seed ? *seed : TfheMaskSeed();
 
   delete[] noise;
 }
 
+EXPORT void lweCreateKeySwitchKey(LweKeySwitchKey *result, const LweKey *in_key,
+                                  const LweKey *out_key) {
+  lweCreateKeySwitchKey_withSeed(result, in_key, out_key, 0x0);
+}
+
+EXPORT void lweCreateSeededKeySwitchKey(LweKeySwitchKey *result,
+                                        const LweKey *in_key,
+                                        const LweKey *out_key) {
+  const TfheMaskSeed seed = tfhe_newMaskSeed();
+  lweCreateKeySwitchKey_withSeed(result, in_key, out_key, &seed);
+}
+
 // sample=(a',b')
 EXPORT void lweKeySwitch(LweSample *result, const LweKeySwitchKey *ks,
                          const LweSample *sample) {
@@ -234,8 +247,11 @@ EXPORT void lweKeySwitch(LweSample *result, const LweKeySwitchKey *ks,
   const int32_t t = ks->t;
 
   lweNoiselessTrivial(result, sample->b, params);
-  lweKeySwitchTranslate_fromArray(result, (const LweSample ***)ks->ks, params,
-                                  sample->a, n, t, basebit);
+  if (ks->ks_flat)
+    lweKeySwitchTranslate_fromFlat(result, ks, sample->a);
+  else
+    lweKeySwitchTranslate_fromArray(result, (const LweSample ***)ks->ks, params,
+                                    sample->a, n, t, basebit);
 }
 
 // sample=(a',b')
@@ -248,8 +264,27 @@ EXPORT void lweSparseKeySwitch(LweSample *result, const LweKeySwitchKey *ks,
 
   lweCopy(result, sample, params);
 
-  lweSparseKeySwitchTranslate_fromArray(result, (const LweSample ***)ks->ks,
-                                        params, sample->a, n, t, basebit);
+  if (ks->ks_flat)
+    lweSparseKeySwitchTranslate_fromFlat(result, ks, sample->a);
+  else
+    lweSparseKeySwitchTranslate_fromArray(result, (const LweSample ***)ks->ks,
+                                          params, sample->a, n, t, basebit);
+}
+
+EXPORT void lweSparseKeySwitchBatch(LweSample *results,
+                                    const LweKeySwitchKey *ks,
+                                    const LweSample *samples,
+                                    const int32_t nbSamples) {
+  const LweParams *params = ks->out_params;
+
+  if (!ks->ks_flat) {
+    for (int32_t s = 0; s < nbSamples; s++)
+      lweSparseKeySwitch(results + s, ks, samples + s);
+    return;
+  }
+  for (int32_t s = 0; s < nbSamples; s++)
+    lweCopy(results + s, samples + s, params);
+  lweSparseKeySwitchTranslateBatch_fromFlat(results, ks, samples, nbSamples);
 }
 
 /**
@@ -270,7 +305,10 @@ EXPORT void destroy_LweKeySwitchKey(LweKeySwitchKey *obj) {
   const int32_t n = obj->n;
   const int32_t t = obj->t;
   const int32_t base = obj->base;
-  delete_LweSample_array(n * t * base, obj->ks0_raw);
+  if (obj->ks_flat)
+    free_LweSample_array(n * t * base, obj->ks0_raw); // the masks are in ks_flat
+  else
+    delete_LweSample_array(n * t * base, obj->ks0_raw);
 
   obj->~LweKeySwitchKey();
 }
@@ -1,11 +1,25 @@
 #include "lwebootstrappingkey.h"
+#include "lagrangehalfc_arithmetic.h"
+#include "lweparams.h"
+#include "lwesamples.h"
+#include "polynomials.h"
 #include "lwe-functions.h"
 #include "lwekeyswitch.h"
+#include "tfhe_bootstrap_team.h"
 #include "tfhe_core.h"
 #include "tgsw.h"
 #include "tgsw_functions.h"
+#include "tfhe_generic_templates.h"
+#include "tlwe.h"
+#include "tlwe_functions.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
 #include <cstdlib>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <vector>
 
 using namespace std;
 
@@ -16,7 +30,7 @@ LweBootstrappingKey::LweBootstrappingKey(const LweParams *in_out_params,
                                          TGswSample *bk, LweKeySwitchKey *ks)
     : in_out_params(in_out_params), bk_params(bk_params),
       accum_params(accum_params), extract_params(extract_params), bk(bk),
-      ks(ks) {}
+      ks(ks), seed() {}
 
 LweBootstrappingKey::~LweBootstrappingKey() {}
 
@@ -50,6 +64,401 @@ LweBootstrappingKeyFFT::LweBootstrappingKeyFFT(const LweParams *in_out_params,
                                                const LweKeySwitchKey *ks)
     : in_out_params(in_out_params), bk_params(bk_params),
       accum_params(accum_params), extract_params(extract_params), bkFFT(bkFFT),
-      ks(ks) {}
+      ks(ks), rotated(0), recompose_accum(0), mapped(0) {}
 
 LweBootstrappingKeyFFT::~LweBootstrappingKeyFFT() {}
+
+// the mutable state of a LweRotatedKeyFFT. The pairs (i,a) are indexed by
+// e = i*2N+a. A reader pins a slot, then checks that it still holds its
+// pair; the admission unpublishes a slot, then checks that it is not pinned:
+// (with sequentially consistent atomics) a slot is never overwritten while
+// a reader uses it.
+struct LweRotatedKeyCache {
+  atomic<int32_t> *slot_of; ///< slot of each pair, or -1
+  atomic<uint8_t> *counts;  ///< misses of each pair, up to the admission
+  atomic<int32_t> *key;     ///< pair of each slot, or -1
+  atomic<int32_t> *pins;    ///< readers of each slot
+  atomic<uint8_t> *referenced; ///< hit since the last pass of the hand
+  mutex admission;          ///< one admission at a time
+  int32_t hand;             ///< next slot examined for eviction
+  LagrangeHalfCPolynomial *xaim1;
+  atomic<int64_t> nb_hits;
+  atomic<int64_t> nb_misses;
+
+  LweRotatedKeyCache(const int32_t nb_pairs, const int32_t capacity,
+                     const int32_t N)
+      : hand(0), nb_hits(0), nb_misses(0) {
+    slot_of = new atomic<int32_t>[nb_pairs];
+    counts = new atomic<uint8_t>[nb_pairs];
+    for (int32_t e = 0; e < nb_pairs; e++) {
+      slot_of[e] = -1;
+      counts[e] = 0;
+    }
+    key = new atomic<int32_t>[capacity];
+    pins = new atomic<int32_t>[capacity];
+    referenced = new atomic<uint8_t>[capacity];
+    for (int32_t s = 0; s < capacity; s++) {
+      key[s] = -1;
+      pins[s] = 0;
+      referenced[s] = 0;
+    }
+    xaim1 = new_LagrangeHalfCPolynomial(N);
+  }
+
+  ~LweRotatedKeyCache() {
+    delete_LagrangeHalfCPolynomial(xaim1);
+    delete[] referenced;
+    delete[] pins;
+    delete[] key;
+    delete[] counts;
+    delete[] slot_of;
+  }
+};
+
+namespace {
+// number of misses of a pair before its product is cached: the pairs met
+// once (most of them, with fresh inputs) are not worth a product
+const uint8_t ROTATED_KEY_ADMISSION = 2;
+} // namespace
+
+LweRotatedKeyFFT::LweRotatedKeyFFT(const TGswParams *bk_params,
+                                   const TGswSampleFFT *bkFFT, const int32_t n,
+                                   const int32_t capacity,
+                                   TGswSampleFFT *slots,
+                                   LweRotatedKeyCache *cache)
+    : bk_params(bk_params), bkFFT(bkFFT), n(n), capacity(capacity),
+      slots(slots), cache(cache) {}
+
+LweRotatedKeyFFT::~LweRotatedKeyFFT() {}
+
+// initialize the LweRotatedKeyFFT structure
+//(equivalent of the C++ constructor)
+EXPORT void init_LweRotatedKeyFFT(LweRotatedKeyFFT *obj,
+                                  const LweBootstrappingKeyFFT *bk,
+                                  const int64_t max_bytes) {
+  const TGswParams *bk_params = bk->bk_params;
+  const int32_t N = bk->accum_params->N;
+  const int32_t n = bk->in_out_params->n;
+  const int32_t nb_pairs = n * 2 * N;
+  // each TGswSampleFFT holds kpl*(k+1) polynomials of N doubles
+  const int64_t entry_bytes =
+      int64_t(bk_params->kpl) * (bk->accum_params->k + 1) * N * sizeof(double);
+  // (a single precision key cannot be rotated)
+  const int32_t capacity =
+      bk->bkFFT->all_samples[0].a_float32
+          ? 0
+          : min<int64_t>(nb_pairs, max_bytes / entry_bytes);
+
+  TGswSampleFFT *slots = 0;
+  LweRotatedKeyCache *cache = 0;
+  if (capacity > 0) {
+    slots = new_TGswSampleFFT_array(capacity, bk_params);
+    cache = new LweRotatedKeyCache(nb_pairs, capacity, N);
+  }
+  new (obj) LweRotatedKeyFFT(bk_params, bk->bkFFT, n, capacity, slots, cache);
+}
+
+// destroys the LweRotatedKeyFFT structure
+//(equivalent of the C++ destructor)
+EXPORT void destroy_LweRotatedKeyFFT(LweRotatedKeyFFT *obj) {
+  if (obj->capacity > 0) {
+    delete obj->cache;
+    delete_TGswSampleFFT_array(obj->capacity, obj->slots);
+  }
+  obj->~LweRotatedKeyFFT();
+}
+
+EXPORT LweRotatedKeyFFT *alloc_LweRotatedKeyFFT() {
+  return (LweRotatedKeyFFT *)malloc(sizeof(LweRotatedKeyFFT));
+}
+
+EXPORT void free_LweRotatedKeyFFT(LweRotatedKeyFFT *ptr) { free(ptr); }
+
+EXPORT LweRotatedKeyFFT *new_LweRotatedKeyFFT(const LweBootstrappingKeyFFT *bk,
+                                              const int64_t max_bytes) {
+  LweRotatedKeyFFT *obj = alloc_LweRotatedKeyFFT();
+  init_LweRotatedKeyFFT(obj, bk, max_bytes);
+  return obj;
+}
+
+EXPORT void delete_LweRotatedKeyFFT(LweRotatedKeyFFT *obj) {
+  destroy_LweRotatedKeyFFT(obj);
+  free_LweRotatedKeyFFT(obj);
+}
+
+EXPORT void tfhe_setRotatedKeyFFT(LweBootstrappingKeyFFT *bk,
+                                  const LweRotatedKeyFFT *rotated) {
+  assert(rotated == 0 || rotated->bkFFT == bk->bkFFT);
+  bk->rotated = rotated;
+}
+
+EXPORT const TGswSampleFFT *
+tfhe_acquireRotatedKeyFFT(const LweRotatedKeyFFT *rotated, const int32_t i,
+                          const int32_t a) {
+  if (rotated->capacity == 0)
+    return 0;
+  LweRotatedKeyCache *c = rotated->cache;
+  const int32_t e = i * 2 * rotated->bk_params->tlwe_params->N + a;
+
+  // hit: pin the slot, then check that it still holds the pair
+  int32_t s = c->slot_of[e];
+  if (s >= 0) {
+    c->pins[s]++;
+    if (c->key[s] == e) {
+      c->referenced[s].store(1, memory_order_relaxed);
+      c->nb_hits.fetch_add(1, memory_order_relaxed);
+      return rotated->slots + s;
+    }
+    c->pins[s]--;
+  }
+  c->nb_misses.fetch_add(1, memory_order_relaxed);
+  if (c->counts[e].load(memory_order_relaxed) + 1 < ROTATED_KEY_ADMISSION) {
+    c->counts[e].fetch_add(1, memory_order_relaxed);
+    return 0;
+  }
+
+  // admission, unless another thread is admitting: the others never wait
+  unique_lock<mutex> lk(c->admission, try_to_lock);
+  if (!lk.owns_lock() || c->slot_of[e] >= 0)
+    return 0;
+  const int32_t capacity = rotated->capacity;
+  s = -1;
+  for (int32_t step = 0; step < 2 * capacity && s < 0; step++) {
+    const int32_t victim = c->hand;
+    c->hand = (c->hand + 1) % capacity;
+    const int32_t old = c->key[victim];
+    if (old < 0) {
+      s = victim;
+      break;
+    }
+    if (c->referenced[victim].exchange(0, memory_order_relaxed))
+      continue;
+    // unpublish, then check the readers
+    c->key[victim] = -1;
+    if (c->pins[victim] != 0) {
+      c->key[victim] = old;
+      continue;
+    }
+    c->slot_of[old] = -1;
+    c->counts[old].store(0, memory_order_relaxed);
+    s = victim;
+  }
+  if (s < 0)
+    return 0;
+  tGswFFTMulByXaiMinusOne(rotated->slots + s, a, rotated->bkFFT + i,
+                          rotated->bk_params, c->xaim1);
+  c->pins[s]++;
+  c->referenced[s].store(1, memory_order_relaxed);
+  c->key[s] = e;
+  c->slot_of[e] = s;
+  return rotated->slots + s;
+}
+
+EXPORT void tfhe_releaseRotatedKeyFFT(const LweRotatedKeyFFT *rotated,
+                                      const TGswSampleFFT *product) {
+  rotated->cache->pins[product - rotated->slots]--;
+}
+
+EXPORT void tfhe_rotatedKeyFFTStats(const LweRotatedKeyFFT *rotated,
+                                    int64_t *nb_hits, int64_t *nb_misses) {
+  *nb_hits = rotated->capacity > 0 ? rotated->cache->nb_hits.load() : 0;
+  *nb_misses = rotated->capacity > 0 ? rotated->cache->nb_misses.load() : 0;
+}
+
+EXPORT void tfhe_setAccumRecompositionFFT(LweBootstrappingKeyFFT *bk,
+                                          int32_t enable) {
+  bk->recompose_accum = enable;
+}
+
+EXPORT void tfhe_flattenKeySwitchKeyFFT(LweBootstrappingKeyFFT *bk) {
+  lweFlattenKeySwitchKey((LweKeySwitchKey *)bk->ks);
+}
+
+EXPORT void tfhe_bootstrappingKeyFFTToFloat32(LweBootstrappingKeyFFT *bk) {
+  // the polynomials of a mapped key are views on the mapping, which
+  // tLweFFTToFloat32 cannot release
+  if (bk->mapped)
+    die_dramatically("A mapped bootstrapping key cannot be converted to single precision");
+  assert(bk->rotated == 0);
+  const int32_t n = bk->in_out_params->n;
+  const int32_t kpl = bk->bk_params->kpl;
+  TGswSampleFFT *bkFFT = (TGswSampleFFT *)bk->bkFFT;
+  for (int32_t i = 0; i < n; i++)
+    for (int32_t p = 0; p < kpl; p++)
+      tLweFFTToFloat32(bkFFT[i].all_samples + p, bk->accum_params);
+}
+
+// u has the extracted parameters (kN coefficients); the input buffers also
+// fit the input samples of the bootstrapping, whose dimension n may exceed kN
+LweBootstrappingWorkspace::LweBootstrappingWorkspace(
+    const TGswParams *bk_params, int32_t n)
+    : N(bk_params->tlwe_params->N), k(bk_params->tlwe_params->k),
+      l(bk_params->l), Bgbit(bk_params->Bgbit), xaim1_table(0),
+      nmax(max(n, bk_params->tlwe_params->k * bk_params->tlwe_params->N)),
+      rotated(0),
+      recompose_accum(0), team(0), batch_capacity(0), batch_temp(0),
+      batch_acc(0), batch_bara(0), batch_u(0) {
+  const TLweParams *accum_params = bk_params->tlwe_params;
+  const LweParams *extract_params = &accum_params->extracted_lweparams;
+  const int32_t kpl = bk_params->kpl;
+
+  temp = new_TLweSample(accum_params);
+  xaim1 = new_LagrangeHalfCPolynomial(N);
+  decaFFT = new_LagrangeHalfCPolynomial_array(kpl, N);
+  gadget = new_LagrangeHalfCPolynomial_array(l, N);
+  for (int32_t j = 0; j < l; j++)
+    LagrangeHalfCPolynomialSetTorusConstant(gadget + j, bk_params->h[j]);
+  tmpa = new_TLweSampleFFT(accum_params);
+  tmpb = new_TLweSampleFFT(accum_params);
+  testvect = new_TorusPolynomial(N);
+  testvectbis = new_TorusPolynomial(N);
+  acc = new_TLweSample(accum_params);
+  bara = new int32_t[nmax];
+  u = new_LweSample(extract_params);
+  // (an LweSample only takes the dimension of its parameters)
+  const LweParams input_params(nmax, extract_params->alpha_min,
+                               extract_params->alpha_max);
+  for (int32_t i = 0; i < 4; i++)
+    gate_temp[i] = new_LweSample(&input_params);
+}
+
+LweBootstrappingWorkspace::~LweBootstrappingWorkspace() {
+  const int32_t kpl = (k + 1) * l;
+
+  if (batch_capacity > 0) {
+    delete_LweSample_array(batch_capacity, batch_u);
+    delete[] batch_bara;
+    delete_TLweSample_array(batch_capacity, batch_acc);
+    delete_TLweSample_array(batch_capacity, batch_temp);
+  }
+  for (int32_t i = 0; i < 4; i++)
+    delete_LweSample(gate_temp[i]);
+  delete_LweSample(u);
+  delete[] bara;
+  delete_TLweSample(acc);
+  delete_TorusPolynomial(testvectbis);
+  delete_TorusPolynomial(testvect);
+  delete_TLweSampleFFT(tmpb);
+  delete_TLweSampleFFT(tmpa);
+  delete_LagrangeHalfCPolynomial_array(l, gadget);
+  delete_LagrangeHalfCPolynomial_array(kpl, decaFFT);
+  delete_LagrangeHalfCPolynomial(xaim1);
+  delete_TLweSample(temp);
+}
+
+// initialize the LweBootstrappingWorkspace structure
+//(equivalent of the C++ constructor)
+EXPORT void init_LweBootstrappingWorkspace(LweBootstrappingWorkspace *obj,
+                                           const TGswParams *bk_params) {
+  new (obj) LweBootstrappingWorkspace(bk_params);
+}
+
+// destroys the LweBootstrappingWorkspace structure
+//(equivalent of the C++ destructor)
+EXPORT void destroy_LweBootstrappingWorkspace(LweBootstrappingWorkspace *obj) {
+  obj->~LweBootstrappingWorkspace();
+}
+
+USE_DEFAULT_CONSTRUCTOR_DESTRUCTOR_IMPLEMENTATIONS1(LweBootstrappingWorkspace,
+                                                    TGswParams);
+
+EXPORT void tfhe_reserveBatchWorkspace(LweBootstrappingWorkspace *ws,
+                                       const int32_t nbSamples,
+                                       const TLweParams *accum_params) {
+  assert(accum_params->N == ws->N && accum_params->k == ws->k);
+  if (nbSamples <= ws->batch_capacity)
+    return;
+  if (ws->batch_capacity > 0) {
+    delete_LweSample_array(ws->batch_capacity, ws->batch_u);
+    delete[] ws->batch_bara;
+    delete_TLweSample_array(ws->batch_capacity, ws->batch_acc);
+    delete_TLweSample_array(ws->batch_capacity, ws->batch_temp);
+  }
+  // (the same sizes as the buffers of one sample, see the constructor)
+  ws->batch_temp = new_TLweSample_array(nbSamples, accum_params);
+  ws->batch_acc = new_TLweSample_array(nbSamples, accum_params);
+  ws->batch_bara = new int32_t[int64_t(nbSamples) * ws->nmax];
+  ws->batch_u =
+      new_LweSample_array(nbSamples, &accum_params->extracted_lweparams);
+  ws->batch_capacity = nbSamples;
+}
+
+namespace {
+// the workspaces of a thread, one per dimensions, released when the thread
+// exits
+struct ThreadBootstrappingWorkspace {
+  vector<LweBootstrappingWorkspace *> ws;
+
+  ~ThreadBootstrappingWorkspace() {
+    for (LweBootstrappingWorkspace *w : ws)
+      delete_LweBootstrappingWorkspace(w);
+  }
+};
+
+thread_local ThreadBootstrappingWorkspace thread_workspace;
+
+// the bootstrap team of the thread, if any
+thread_local TFheBootstrapTeam *thread_team = 0;
+
+atomic<int32_t> use_xaim1_tables(0);
+
+// the X^a-1 tables, indexed by N
+struct XaiMinusOneTables {
+  mutex lock;
+  map<int32_t, LagrangeHalfCPolynomial *> tables;
+
+  ~XaiMinusOneTables() {
+    for (auto &it : tables)
+      delete_LagrangeHalfCPolynomial_array(2 * it.first, it.second);
+  }
+};
+
+XaiMinusOneTables xaim1_tables;
+} // namespace
+
+EXPORT LweBootstrappingWorkspace *
+tfhe_threadBootstrappingWorkspace(const TGswParams *bk_params,
+                                  const int32_t n) {
+  // the parameter pointers may be recycled: compare the dimensions instead.
+  // A workspace is never freed before the thread exits, so that the callers
+  // can keep it while the thread uses other parameters: a larger n gets a
+  // new workspace rather than growing the input buffers of a used one.
+  LweBootstrappingWorkspace *ws = 0;
+  for (LweBootstrappingWorkspace *w : thread_workspace.ws)
+    if (w->N == bk_params->tlwe_params->N && w->k == bk_params->tlwe_params->k &&
+        w->l == bk_params->l && w->Bgbit == bk_params->Bgbit && n <= w->nmax) {
+      ws = w;
+      break;
+    }
+  if (ws == 0) {
+    ws = alloc_LweBootstrappingWorkspace();
+    new (ws) LweBootstrappingWorkspace(bk_params, n);
+    thread_workspace.ws.push_back(ws);
+  }
+  if (use_xaim1_tables) {
+    if (ws->xaim1_table == 0)
+      ws->xaim1_table = tfhe_xaiMinusOneTable(ws->N);
+  } else
+    ws->xaim1_table = 0;
+  ws->team = thread_team;
+  return ws;
+}
+
+EXPORT const LagrangeHalfCPolynomial *tfhe_xaiMinusOneTable(const int32_t N) {
+  unique_lock<mutex> lk(xaim1_tables.lock);
+  LagrangeHalfCPolynomial *&table = xaim1_tables.tables[N];
+  if (table == 0) {
+    table = new_LagrangeHalfCPolynomial_array(2 * N, N);
+    for (int32_t a = 0; a < 2 * N; a++)
+      LagrangeHalfCPolynomialSetXaiMinusOne(table + a, a);
+  }
+  return table;
+}
+
+EXPORT void tfhe_useXaiMinusOneTables(const int32_t use) {
+  use_xaim1_tables = use;
+}
+
+EXPORT void tfhe_useBootstrapTeam(TFheBootstrapTeam *team) {
+  thread_team = team;
+}
@@ -1,4 +1,10 @@
 #include "lwekeyswitch.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 LweKeySwitchKey::LweKeySwitchKey(int32_t n, int32_t t, int32_t basebit, const LweParams* out_params, LweSample* ks0_raw){
     this->basebit=basebit;
@@ -9,6 +15,9 @@ LweKeySwitchKey::LweKeySwitchKey(int32_t n, int32_t t, int32_t basebit, const Lw
     this->ks0_raw = ks0_raw;
     ks1_raw = new LweSample*[n*t];
     ks = new LweSample**[n];
+    ks_flat = 0;
+    flat_stride = 0;
+    seed = TfheMaskSeed();
 
    
     for (int32_t p = 0; p < n*t; ++p)
@@ -20,5 +29,285 @@ LweKeySwitchKey::LweKeySwitchKey(int32_t n, int32_t t, int32_t basebit, const Lw
 LweKeySwitchKey::~LweKeySwitchKey() {
     delete[] ks1_raw;
     delete[] ks;
+    free(ks_flat);
 }
 
+EXPORT void lweFlattenKeySwitchKey(LweKeySwitchKey* ks) {
+    if (ks->ks_flat) return;
+    const int32_t n_out = ks->out_params->n;
+    const int32_t stride = (n_out + 15) & ~15;
+    const int64_t nb_elts = int64_t(ks->n) * ks->t * ks->base;
+
+    Torus32* flat = (Torus32*) aligned_alloc(64, nb_elts * stride * sizeof(Torus32));
+    for (int64_t p = 0; p < nb_elts; ++p) {
+        LweSample* sample = ks->ks0_raw + p;
+        Torus32* row = flat + p * stride;
+        memcpy(row, sample->a, n_out * sizeof(Torus32));
+        memset(row + n_out, 0, (stride - n_out) * sizeof(Torus32));
+        delete[] sample->a;
+        sample->a = row;
+    }
+    ks->flat_stride = stride;
+    ks->ks_flat = flat;
+}
+
+namespace {
+    // number of rows gathered before each sweep over the output
+    const int32_t KS_ROWS_BATCH = 256;
+    // how many rows ahead the accumulation prefetches
+    const int32_t KS_PREFETCH = 4;
+    // blocks of 16 coefficients kept in registers during a sweep
+    const int32_t KS_BLOCKS = 4;
+    // samples of a batched keyswitch that share each pass over the key
+    const int32_t KS_SAMPLES_BATCH = 64;
+
+#if defined(__AVX512F__)
+    // 16 coefficients
+    typedef __m512i KsBlock;
+
+    inline KsBlock ksLoad(const Torus32* p) { return _mm512_loadu_si512(p); }
+
+    inline void ksStore(Torus32* p, const KsBlock x) { _mm512_storeu_si512(p, x); }
+
+    // the rows of ks_flat are 64-byte aligned
+    inline KsBlock ksAdd(const KsBlock x, const Torus32* row) {
+        return _mm512_add_epi32(x, _mm512_load_si512(row));
+    }
+
+    inline KsBlock ksSub(const KsBlock x, const Torus32* row) {
+        return _mm512_sub_epi32(x, _mm512_load_si512(row));
+    }
+#elif defined(__AVX2__)
+    struct KsBlock { __m256i lo, hi; };
+
+    inline KsBlock ksLoad(const Torus32* p) {
+        KsBlock x;
+        x.lo = _mm256_loadu_si256((const __m256i*) p);
+        x.hi = _mm256_loadu_si256((const __m256i*) (p + 8));
+        return x;
+    }
+
+    inline void ksStore(Torus32* p, const KsBlock x) {
+        _mm256_storeu_si256((__m256i*) p, x.lo);
+        _mm256_storeu_si256((__m256i*) (p + 8), x.hi);
+    }
+
+    inline KsBlock ksAdd(const KsBlock x, const Torus32* row) {
+        KsBlock r;
+        r.lo = _mm256_add_epi32(x.lo, _mm256_load_si256((const __m256i*) row));
+        r.hi = _mm256_add_epi32(x.hi, _mm256_load_si256((const __m256i*) (row + 8)));
+        return r;
+    }
+
+    inline KsBlock ksSub(const KsBlock x, const Torus32* row) {
+        KsBlock r;
+        r.lo = _mm256_sub_epi32(x.lo, _mm256_load_si256((const __m256i*) row));
+        r.hi = _mm256_sub_epi32(x.hi, _mm256_load_si256((const __m256i*) (row + 8)));
+        return r;
+    }
+#else
+    struct KsBlock { uint32_t c[16]; };
+
+    inline KsBlock ksLoad(const Torus32* p) {
+        KsBlock x;
+        memcpy(x.c, p, sizeof(x.c));
+        return x;
+    }
+
+    inline void ksStore(Torus32* p, const KsBlock x) { memcpy(p, x.c, sizeof(x.c)); }
+
+    inline KsBlock ksAdd(KsBlock x, const Torus32* row) {
+        for (int32_t i = 0; i < 16; i++) x.c[i] += row[i];
+        return x;
+    }
+
+    inline KsBlock ksSub(KsBlock x, const Torus32* row) {
+        for (int32_t i = 0; i < 16; i++) x.c[i] -= row[i];
+        return x;
+    }
+#endif
+
+    /**
+     * out[0..16V[ -= the sum of the sub rows and += the sum of the add rows
+     * (taken at offset off), out being kept in registers
+     */
+    template<int32_t V>
+    void ksAccumulate(Torus32* out,
+                      const Torus32* const* sub, const int32_t nb_sub,
+                      const Torus32* const* add, const int32_t nb_add,
+                      const int32_t off) {
+        KsBlock acc[V];
+        for (int32_t v = 0; v < V; v++) acc[v] = ksLoad(out + 16 * v);
+        for (int32_t s = 0; s < nb_sub; s++) {
+            if (s + KS_PREFETCH < nb_sub)
+                for (int32_t v = 0; v < V; v++) __builtin_prefetch(sub[s + KS_PREFETCH] + off + 16 * v);
+            const Torus32* row = sub[s] + off;
+            for (int32_t v = 0; v < V; v++) acc[v] = ksSub(acc[v], row + 16 * v);
+        }
+        for (int32_t s = 0; s < nb_add; s++) {
+            if (s + KS_PREFETCH < nb_add)
+                for (int32_t v = 0; v < V; v++) __builtin_prefetch(add[s + KS_PREFETCH] + off + 16 * v);
+            const Torus32* row = add[s] + off;
+            for (int32_t v = 0; v < V; v++) acc[v] = ksAdd(acc[v], row + 16 * v);
+        }
+        for (int32_t v = 0; v < V; v++) ksStore(out + 16 * v, acc[v]);
+    }
+
+    // applies the gathered rows to the mask of result, block by block
+    void ksFlush(LweSample* result, const int32_t n_out,
+                 const Torus32* const* sub, const int32_t nb_sub,
+                 const Torus32* const* add, const int32_t nb_add) {
+        Torus32* ra = result->a;
+        int32_t off = 0;
+        for (; off + 16 * KS_BLOCKS <= n_out; off += 16 * KS_BLOCKS)
+            ksAccumulate<KS_BLOCKS>(ra + off, sub, nb_sub, add, nb_add, off);
+        for (; off + 16 <= n_out; off += 16)
+            ksAccumulate<1>(ra + off, sub, nb_sub, add, nb_add, off);
+        if (off < n_out) {
+            // the rows are zero-padded up to flat_stride
+            Torus32 tail[16] = {0};
+            memcpy(tail, ra + off, (n_out - off) * sizeof(Torus32));
+            ksAccumulate<1>(tail, sub, nb_sub, add, nb_add, off);
+            memcpy(ra + off, tail, (n_out - off) * sizeof(Torus32));
+        }
+    }
+}
+
+EXPORT void lweKeySwitchTranslate_fromFlat(LweSample* result, const LweKeySwitchKey* ks, const Torus32* ai) {
+    const int32_t n = ks->n;
+    const int32_t t = ks->t;
+    const int32_t basebit = ks->basebit;
+    const int32_t base = ks->base;
+    const int32_t n_out = ks->out_params->n;
+    const int32_t prec_offset = 1 << (32 - (1 + basebit * t)); //precision
+    const int32_t mask = base - 1;
+
+    const Torus32* sub[KS_ROWS_BATCH];
+    int32_t nb_sub = 0;
+    for (int32_t i = 0; i < n; i++) {
+        const uint32_t aibar = ai[i] + prec_offset;
+        for (int32_t j = 0; j < t; j++) {
+            const uint32_t aij = (aibar >> (32 - (j + 1) * basebit)) & mask;
+            if (aij == 0) continue;
+            const int64_t index = int64_t(i * t + j) * base + aij;
+            const LweSample* sample = ks->ks0_raw + index;
+            result->b -= sample->b;
+            result->current_variance += sample->current_variance;
+            sub[nb_sub++] = ks->ks_flat + index * ks->flat_stride;
+            if (nb_sub == KS_ROWS_BATCH) {
+                ksFlush(result, n_out, sub, nb_sub, 0, 0);
+                nb_sub = 0;
+            }
+        }
+    }
+    if (nb_sub > 0) ksFlush(result, n_out, sub, nb_sub, 0, 0);
+}
+
+EXPORT void lweSparseKeySwitchTranslate_fromFlat(LweSample* result, const LweKeySwitchKey* ks, const Torus32* ai) {
+    const int32_t n = ks->n;
+    const int32_t t = ks->t;
+    const int32_t basebit = ks->basebit;
+    const int32_t base = ks->base;
+    const int32_t n_out = ks->out_params->n;
+    const int32_t prec_offset = 1 << (32 - (1 + basebit * t)); //precision
+    const int32_t mask = base - 1;
+
+    const Torus32* sub[KS_ROWS_BATCH];
+    const Torus32* add[KS_ROWS_BATCH];
+    int32_t nb_sub = 0;
+    int32_t nb_add = 0;
+    for (int32_t i = n_out; i < n; i++) {
+        const uint32_t aibar = ai[i] + prec_offset;
+        uint32_t carry = 0;
+        for (int32_t j = t - 1; j >= 0; j--) {
+            const uint32_t aij = ((aibar >> (32 - (j + 1) * basebit)) & mask) + carry;
+            if (aij == 0) {
+                carry = 0;
+                continue;
+            }
+            const int64_t row0 = int64_t(i * t + j) * base;
+            if (aij < (uint32_t) base / 2) {
+                const LweSample* sample = ks->ks0_raw + row0 + aij;
+                result->b -= sample->b;
+                result->current_variance += sample->current_variance;
+                sub[nb_sub++] = ks->ks_flat + (row0 + aij) * ks->flat_stride;
+                carry = 0;
+            } else {
+                const LweSample* sample = ks->ks0_raw + row0 + base - aij;
+                result->b += sample->b;
+                result->current_variance += sample->current_variance;
+                add[nb_add++] = ks->ks_flat + (row0 + base - aij) * ks->flat_stride;
+                carry = 1;
+            }
+            if (nb_sub == KS_ROWS_BATCH || nb_add == KS_ROWS_BATCH) {
+                ksFlush(result, n_out, sub, nb_sub, add, nb_add);
+                nb_sub = 0;
+                nb_add = 0;
+            }
+        }
+    }
+    if (nb_sub + nb_add > 0) ksFlush(result, n_out, sub, nb_sub, add, nb_add);
+}
+
+EXPORT void lweSparseKeySwitchTranslateBatch_fromFlat(LweSample* results, const LweKeySwitchKey* ks,
+                                                      const LweSample* samples, const int32_t nbSamples) {
+    const int32_t n = ks->n;
+    const int32_t t = ks->t;
+    const int32_t basebit = ks->basebit;
+    const int32_t base = ks->base;
+    const int32_t n_out = ks->out_params->n;
+    const uint32_t prec_offset = 1 << (32 - (1 + basebit * t)); //precision
+    const uint32_t mask = base - 1;
+    const uint32_t halfbase = base / 2;
+
+    uint32_t aibar[KS_SAMPLES_BATCH];
+    uint32_t carry[KS_SAMPLES_BATCH];
+    uint32_t digit[KS_SAMPLES_BATCH];
+    // the rows of the current coefficient i, for each sample (t <= 32)
+    const Torus32* sub[KS_SAMPLES_BATCH][32];
+    const Torus32* add[KS_SAMPLES_BATCH][32];
+    int32_t nb_sub[KS_SAMPLES_BATCH];
+    int32_t nb_add[KS_SAMPLES_BATCH];
+    for (int32_t s0 = 0; s0 < nbSamples; s0 += KS_SAMPLES_BATCH) {
+        const int32_t nb = std::min(KS_SAMPLES_BATCH, nbSamples - s0);
+        LweSample* res = results + s0;
+        const LweSample* in = samples + s0;
+        // the t.base rows of each coefficient i are read once for the whole
+        // batch, and stay in cache while they are applied to each sample
+        for (int32_t i = n_out; i < n; i++) {
+            for (int32_t s = 0; s < nb; s++) {
+                aibar[s] = in[s].a[i] + prec_offset;
+                carry[s] = 0;
+                nb_sub[s] = 0;
+                nb_add[s] = 0;
+            }
+            for (int32_t j = t - 1; j >= 0; j--) {
+                // the signed digits of the whole batch: a digit >= base/2 is
+                // replaced by digit-base, with a carry to the next digit
+                const int32_t shift = 32 - (j + 1) * basebit;
+                for (int32_t s = 0; s < nb; s++) {
+                    digit[s] = ((aibar[s] >> shift) & mask) + carry[s];
+                    carry[s] = digit[s] >= halfbase;
+                }
+                const int64_t row0 = int64_t(i * t + j) * base;
+                for (int32_t s = 0; s < nb; s++) {
+                    if (digit[s] == 0) continue;
+                    if (digit[s] < halfbase) {
+                        const LweSample* sample = ks->ks0_raw + row0 + digit[s];
+                        res[s].b -= sample->b;
+                        res[s].current_variance += sample->current_variance;
+                        sub[s][nb_sub[s]++] = ks->ks_flat + (row0 + digit[s]) * ks->flat_stride;
+                    } else {
+                        const LweSample* sample = ks->ks0_raw + row0 + base - digit[s];
+                        res[s].b += sample->b;
+                        res[s].current_variance += sample->current_variance;
+                        add[s][nb_add[s]++] = ks->ks_flat + (row0 + base - digit[s]) * ks->flat_stride;
+                    }
+                }
+            }
+            for (int32_t s = 0; s < nb; s++)
+                if (nb_sub[s] + nb_add[s] > 0)
+                    ksFlush(res + s, n_out, sub[s], nb_sub[s], add[s], nb_add[s]);
+        }
+    }
+}
@@ -2,14 +2,32 @@
 #include <iostream>
 #include <random>
 #include <cassert>
+#include <atomic>
+#include <thread>
+#include <vector>
 #include <limits.h>
 #include <tfhe_core.h>
 #include <numeric_functions.h>
 
 using namespace std;
 
-default_random_engine generator;
-uniform_int_distribution<Torus32> uniformTorus32_distrib(INT32_MIN, INT32_MAX);
+namespace {
+atomic<int32_t> nb_generators(0);
+atomic<int32_t> key_generation_threads(0);
+
+// the first generator keeps the default seed, so that the single-threaded
+// programs stay reproducible; the other threads must not share its stream
+default_random_engine new_thread_generator() {
+    if (nb_generators++ == 0)
+        return default_random_engine();
+    random_device device;
+    seed_seq seeds{device(), device(), device(), device()};
+    return default_random_engine(seeds);
+}
+}
+
+thread_local default_random_engine generator = new_thread_generator();
+thread_local uniform_int_distribution<Torus32> uniformTorus32_distrib(INT32_MIN, INT32_MAX);
 uniform_int_distribution<int32_t> uniformInt_distrib(INT_MIN, INT_MAX);
 
 /** sets the seed of the random number generator to the given values */
@@ -28,6 +46,115 @@ EXPORT Torus32 gaussian32(Torus32 message, double sigma){
 
 
 
+namespace {
+inline uint32_t rotl32(const uint32_t x, const int32_t c) {
+    return (x << c) | (x >> (32 - c));
+}
+
+inline void chacha_quarter_round(uint32_t *x, int32_t a, int32_t b, int32_t c, int32_t d) {
+    x[a] += x[b]; x[d] = rotl32(x[d] ^ x[a], 16);
+    x[c] += x[d]; x[b] = rotl32(x[b] ^ x[c], 12);
+    x[a] += x[b]; x[d] = rotl32(x[d] ^ x[a], 8);
+    x[c] += x[d]; x[b] = rotl32(x[b] ^ x[c], 7);
+}
+
+// the ChaCha20 block of the given key, 64-bit nonce and 64-bit block counter
+// (the original layout of Bernstein, the rounds are those of RFC 8439)
+void chacha20_block(uint32_t *out, const uint32_t *key, const uint64_t nonce, const uint64_t counter) {
+    const uint32_t state[16] = {
+            0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+            key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+            uint32_t(counter), uint32_t(counter >> 32), uint32_t(nonce), uint32_t(nonce >> 32)};
+    for (int32_t i = 0; i < 16; i++) out[i] = state[i];
+    for (int32_t r = 0; r < 10; r++) {
+        chacha_quarter_round(out, 0, 4, 8, 12);
+        chacha_quarter_round(out, 1, 5, 9, 13);
+        chacha_quarter_round(out, 2, 6, 10, 14);
+        chacha_quarter_round(out, 3, 7, 11, 15);
+        chacha_quarter_round(out, 0, 5, 10, 15);
+        chacha_quarter_round(out, 1, 6, 11, 12);
+        chacha_quarter_round(out, 2, 7, 8, 13);
+        chacha_quarter_round(out, 3, 4, 9, 14);
+    }
+    for (int32_t i = 0; i < 16; i++) out[i] += state[i];
+}
+}
+
+EXPORT void tfhe_seededUniformTorus32(Torus32 *result, const int32_t n,
+                                      const TfheMaskSeed *seed, const uint64_t row) {
+    uint32_t block[16];
+    for (int32_t i = 0; i < n; i += 16) {
+        chacha20_block(block, seed->key, row, uint64_t(i / 16));
+        const int32_t end = (n - i < 16) ? n - i : 16;
+        for (int32_t j = 0; j < end; j++)
+            result[i + j] = Torus32(block[j]);
+    }
+}
+
+EXPORT TfheMaskSeed tfhe_newMaskSeed() {
+    random_device device;
+    TfheMaskSeed seed;
+    do {
+        for (int32_t i = 0; i < 8; i++)
+            seed.key[i] = device();
+    } while (tfhe_isNullMaskSeed(&seed));
+    return seed;
+}
+
+EXPORT int32_t tfhe_isNullMaskSeed(const TfheMaskSeed *seed) {
+    for (int32_t i = 0; i < 8; i++)
+        if (seed->key[i] != 0) return 0;
+    return 1;
+}
+
+EXPORT void tfhe_setKeyGenerationThreads(const int32_t nb_threads) {
+    key_generation_threads = nb_threads;
+}
+
+void tfhe_keyGenerationParallelFor(const int32_t nbelts,
+                                   const bool seed_generators,
+                                   const function<void(int32_t, int32_t)> &job) {
+    // the split in chunks does not depend on the number of threads
+    static const int32_t MAX_CHUNKS = 64;
+    const int32_t nb_chunks = nbelts < MAX_CHUNKS ? nbelts : MAX_CHUNKS;
+    if (nb_chunks <= 0)
+        return;
+    int32_t nb_threads = key_generation_threads;
+    if (nb_threads <= 0)
+        nb_threads = thread::hardware_concurrency();
+    if (nb_threads > nb_chunks)
+        nb_threads = nb_chunks;
+    if (nb_threads < 1)
+        nb_threads = 1;
+    // the seeds of the chunks are drawn before the threads start: the stream
+    // of a chunk only depends on the state of the caller and on its index
+    vector<vector<uint32_t> > seeds(nb_chunks);
+    if (seed_generators)
+        for (int32_t c = 0; c < nb_chunks; c++)
+            for (int32_t i = 0; i < 8; i++)
+                seeds[c].push_back(uint32_t(generator()));
+    const default_random_engine caller_generator = generator;
+    atomic<int32_t> next_chunk(0);
+    auto worker = [&] {
+        for (int32_t c = next_chunk++; c < nb_chunks; c = next_chunk++) {
+            if (seed_generators) {
+                seed_seq seq(seeds[c].begin(), seeds[c].end());
+                generator.seed(seq);
+            }
+            job(int64_t(nbelts) * c / nb_chunks, int64_t(nbelts) * (c + 1) / nb_chunks);
+        }
+    };
+    vector<thread> helpers;
+    for (int32_t w = 1; w < nb_threads; w++)
+        helpers.push_back(thread(worker));
+    worker();
+    for (thread &t : helpers)
+        t.join();
+    // the caller continues its own stream after the seeds it gave away
+    if (seed_generators)
+        generator = caller_generator;
+}
+
 // from double to Torus32
 EXPORT Torus32 dtot32(double d) {
     return int32_t(int64_t((d - int64_t(d))*_two32));
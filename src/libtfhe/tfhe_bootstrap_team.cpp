@@ -0,0 +1,140 @@
+#include "tfhe_bootstrap_team.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// the barriers of a bootstrapping are a few microseconds apart: spin first,
+// then yield, so that a team larger than the number of cores still progresses
+const int32_t TEAM_SPIN = 1 << 12;
+// an idle helper blocks on the condition variable after that many yields
+const int32_t TEAM_IDLE_YIELDS = 1 << 10;
+
+template <class Done> void spinWait(Done done) {
+  for (int32_t i = 0; !done(); i++)
+    if (i >= TEAM_SPIN)
+      this_thread::yield();
+}
+
+} // namespace
+
+struct TFheBootstrapTeam {
+  int32_t nb_threads;
+  vector<thread> helpers;
+
+  // the current job
+  TFheBootstrapTeamJob job;
+  void *arg;
+  atomic<int32_t> generation; // incremented by each run
+  atomic<int32_t> nb_done;    // helpers done with the current job
+  atomic<bool> stop;
+
+  // helpers that went to sleep between two runs
+  mutex lock;
+  condition_variable job_available;
+
+  // sense-reversing barrier
+  atomic<int32_t> barrier_count;
+  atomic<int32_t> barrier_generation;
+
+  TFheBootstrapTeam(int32_t nb_threads);
+  ~TFheBootstrapTeam();
+
+  void helperLoop(int32_t member);
+  void run(TFheBootstrapTeamJob job, void *arg);
+  void barrier();
+
+  TFheBootstrapTeam(const TFheBootstrapTeam &) = delete;
+  void operator=(const TFheBootstrapTeam &) = delete;
+};
+
+TFheBootstrapTeam::TFheBootstrapTeam(int32_t nb_threads)
+    : nb_threads(nb_threads), job(0), arg(0), generation(0), nb_done(0),
+      stop(false), barrier_count(0), barrier_generation(0) {
+  if (this->nb_threads <= 0)
+    this->nb_threads = thread::hardware_concurrency();
+  if (this->nb_threads <= 0)
+    this->nb_threads = 1;
+  if (this->nb_threads > TFHE_BOOTSTRAP_TEAM_MAX_THREADS)
+    this->nb_threads = TFHE_BOOTSTRAP_TEAM_MAX_THREADS;
+  for (int32_t i = 1; i < this->nb_threads; i++)
+    helpers.push_back(thread(&TFheBootstrapTeam::helperLoop, this, i));
+}
+
+TFheBootstrapTeam::~TFheBootstrapTeam() {
+  {
+    unique_lock<mutex> lk(lock);
+    stop = true;
+  }
+  job_available.notify_all();
+  for (thread &t : helpers)
+    t.join();
+}
+
+void TFheBootstrapTeam::helperLoop(int32_t member) {
+  int32_t seen = 0;
+  while (true) {
+    // spin while the bootstrappings come in quick succession, then sleep
+    for (int32_t i = 0; generation == seen && !stop; i++) {
+      if (i < TEAM_SPIN)
+        continue;
+      if (i < TEAM_SPIN + TEAM_IDLE_YIELDS) {
+        this_thread::yield();
+        continue;
+      }
+      unique_lock<mutex> lk(lock);
+      job_available.wait(lk, [&] { return stop || generation != seen; });
+    }
+    if (stop)
+      return;
+    seen = generation;
+    job(member, arg);
+    nb_done++;
+  }
+}
+
+void TFheBootstrapTeam::run(TFheBootstrapTeamJob job, void *arg) {
+  this->job = job;
+  this->arg = arg;
+  nb_done = 0;
+  {
+    unique_lock<mutex> lk(lock);
+    generation++;
+  }
+  job_available.notify_all();
+  job(0, arg);
+  spinWait([this] { return nb_done == nb_threads - 1; });
+}
+
+void TFheBootstrapTeam::barrier() {
+  const int32_t gen = barrier_generation;
+  if (barrier_count.fetch_add(1) == nb_threads - 1) {
+    barrier_count = 0;
+    barrier_generation++;
+  } else
+    spinWait([this, gen] { return barrier_generation != gen; });
+}
+
+EXPORT TFheBootstrapTeam *new_bootstrap_team(int32_t nb_threads) {
+  return new TFheBootstrapTeam(nb_threads);
+}
+
+EXPORT void delete_bootstrap_team(TFheBootstrapTeam *team) { delete team; }
+
+EXPORT int32_t tfhe_bootstrapTeamNbThreads(const TFheBootstrapTeam *team) {
+  return team->nb_threads;
+}
+
+EXPORT void tfhe_bootstrapTeamRun(TFheBootstrapTeam *team,
+                                  TFheBootstrapTeamJob job, void *arg) {
+  team->run(job, arg);
+}
+
+EXPORT void tfhe_bootstrapTeamBarrier(TFheBootstrapTeam *team) {
+  team->barrier();
+}
@@ -141,41 +141,74 @@ EXPORT void delete_gate_bootstrapping_parameters(
   delete params;
 }
 
-/** generate a gate bootstrapping secret key */
-EXPORT TFheGateBootstrappingSecretKeySet *
-new_random_gate_bootstrapping_secret_keyset(
-    const TFheGateBootstrappingParameterSet *params) {
+namespace {
+// the bootstrapping key of the keys lwe_key and tgsw_key (its masks are
+// expanded from seeds if seeded), and the keyset of all of them
+TFheGateBootstrappingSecretKeySet *
+new_keyset(const TFheGateBootstrappingParameterSet *params, LweKey *lwe_key,
+           TGswKey *tgsw_key, const bool seeded, const int32_t sparse) {
+  LweBootstrappingKey *bk =
+      new_LweBootstrappingKey(params->ks_t, params->ks_basebit,
+                              params->in_out_params, params->tgsw_params);
+  if (seeded)
+    tfhe_createSeededLweBootstrappingKey(bk, lwe_key, tgsw_key);
+  else
+    tfhe_createLweBootstrappingKey(bk, lwe_key, tgsw_key);
+  LweBootstrappingKeyFFT *bkFFT = new_LweBootstrappingKeyFFT(bk);
+  tfhe_flattenKeySwitchKeyFFT(bkFFT);
+  return new TFheGateBootstrappingSecretKeySet(params, bk, bkFFT, lwe_key,
+                                               tgsw_key, sparse);
+}
+
+TFheGateBootstrappingSecretKeySet *
+new_random_keyset(const TFheGateBootstrappingParameterSet *params,
+                  const bool seeded) {
   LweKey *lwe_key = new_LweKey(params->in_out_params);
   lweKeyGen(lwe_key);
 
   TGswKey *tgsw_key = new_TGswKey(params->tgsw_params);
   tGswKeyGen(tgsw_key);
 
-  LweBootstrappingKey *bk =
-      new_LweBootstrappingKey(params->ks_t, params->ks_basebit,
-                              params->in_out_params, params->tgsw_params);
-  tfhe_createLweBootstrappingKey(bk, lwe_key, tgsw_key);
-  LweBootstrappingKeyFFT *bkFFT = new_LweBootstrappingKeyFFT(bk);
-  return new TFheGateBootstrappingSecretKeySet(params, bk, bkFFT, lwe_key,
-                                               tgsw_key);
+  return new_keyset(params, lwe_key, tgsw_key, seeded, 0);
 }
 
-EXPORT TFheGateBootstrappingSecretKeySet *
-new_random_sparse_bootstrapping_secret_keyset(
-    const TFheGateBootstrappingParameterSet *params) {
+TFheGateBootstrappingSecretKeySet *
+new_random_sparse_keyset(const TFheGateBootstrappingParameterSet *params,
+                         const bool seeded) {
   LweKey *lwe_key = new_LweKey(params->in_out_params);
   lweSparseKeyGen(lwe_key, params->hw);
 
   TGswKey *tgsw_key = new_TGswKey(params->tgsw_params);
   tGswSparseKeyGen(tgsw_key, lwe_key);
 
-  LweBootstrappingKey *bk =
-      new_LweBootstrappingKey(params->ks_t, params->ks_basebit,
-                              params->in_out_params, params->tgsw_params);
-  tfhe_createLweBootstrappingKey(bk, lwe_key, tgsw_key);
-  LweBootstrappingKeyFFT *bkFFT = new_LweBootstrappingKeyFFT(bk);
-  return new TFheGateBootstrappingSecretKeySet(params, bk, bkFFT, lwe_key,
-                                               tgsw_key);
+  // the cloud key is flagged, so that all the boots* gates use the sparse path
+  return new_keyset(params, lwe_key, tgsw_key, seeded, 1);
+}
+} // namespace
+
+/** generate a gate bootstrapping secret key */
+EXPORT TFheGateBootstrappingSecretKeySet *
+new_random_gate_bootstrapping_secret_keyset(
+    const TFheGateBootstrappingParameterSet *params) {
+  return new_random_keyset(params, false);
+}
+
+EXPORT TFheGateBootstrappingSecretKeySet *
+new_random_sparse_bootstrapping_secret_keyset(
+    const TFheGateBootstrappingParameterSet *params) {
+  return new_random_sparse_keyset(params, false);
+}
+
+EXPORT TFheGateBootstrappingSecretKeySet *
+new_random_seeded_gate_bootstrapping_secret_keyset(
+    const TFheGateBootstrappingParameterSet *params) {
+  return new_random_keyset(params, true);
+}
+
+EXPORT TFheGateBootstrappingSecretKeySet *
+new_random_seeded_sparse_bootstrapping_secret_keyset(
+    const TFheGateBootstrappingParameterSet *params) {
+  return new_random_sparse_keyset(params, true);
 }
 
 /** deletes a gate bootstrapping secret key */
@@ -238,6 +271,33 @@ EXPORT void bootsSymEncrypt(LweSample *result, int32_t message,
   lweSymEncrypt(result, mu, alpha, key->lwe_key);
 }
 
+/** generate a new unititialized seeded ciphertext array of length nbelems */
+EXPORT TFheGateBootstrappingSeededCiphertextArray *
+new_gate_bootstrapping_seeded_ciphertext_array(
+    int32_t nbelems, const TFheGateBootstrappingParameterSet *params) {
+  return new TFheGateBootstrappingSeededCiphertextArray(
+      nbelems, new_LweSample_array(nbelems, params->in_out_params));
+}
+
+/** deletes a seeded ciphertext array */
+EXPORT void delete_gate_bootstrapping_seeded_ciphertext_array(
+    TFheGateBootstrappingSeededCiphertextArray *results) {
+  delete_LweSample_array(results->nbelems, results->samples);
+  delete results;
+}
+
+/** encrypts an array of booleans, with the masks expanded from a new seed */
+EXPORT void bootsSymEncryptSeeded(TFheGateBootstrappingSeededCiphertextArray *results,
+                                  const int32_t *messages,
+                                  const TFheGateBootstrappingSecretKeySet *key) {
+  Torus32 _1s8 = modSwitchToTorus32(1, 8);
+  double alpha = key->params->in_out_params->alpha_min;
+  results->seed = tfhe_newMaskSeed();
+  for (int32_t i = 0; i < results->nbelems; i++)
+    lweSymEncryptSeeded(results->samples + i, messages[i] ? _1s8 : -_1s8,
+                        alpha, key->lwe_key, &results->seed, i);
+}
+
 /** decrypts a boolean */
 EXPORT int32_t bootsSymDecrypt(const LweSample *sample,
                                const TFheGateBootstrappingSecretKeySet *key) {
@@ -21,7 +21,13 @@ TFheGateBootstrappingCloudKeySet::TFheGateBootstrappingCloudKeySet(
     const TFheGateBootstrappingParameterSet *const params,
     const LweBootstrappingKey *const bk,
     const LweBootstrappingKeyFFT *const bkFFT)
-    : params(params), bk(bk), bkFFT(bkFFT) {}
+    : params(params), bk(bk), bkFFT(bkFFT), sparse(0) {}
+
+TFheGateBootstrappingCloudKeySet::TFheGateBootstrappingCloudKeySet(
+    const TFheGateBootstrappingParameterSet *const params,
+    const LweBootstrappingKey *const bk,
+    const LweBootstrappingKeyFFT *const bkFFT, const int32_t sparse)
+    : params(params), bk(bk), bkFFT(bkFFT), sparse(sparse) {}
 
 TFheGateBootstrappingSecretKeySet::TFheGateBootstrappingSecretKeySet(
     const TFheGateBootstrappingParameterSet *const params,
@@ -30,3 +36,16 @@ TFheGateBootstrappingSecretKeySet::TFheGateBootstrappingSecretKeySet(
     const TGswKey *tgsw_key)
     : params(params), lwe_key(lwe_key), tgsw_key(tgsw_key),
       cloud(params, bk, bkFFT) {}
+
+TFheGateBootstrappingSecretKeySet::TFheGateBootstrappingSecretKeySet(
+    const TFheGateBootstrappingParameterSet *const params,
+    const LweBootstrappingKey *const bk,
+    const LweBootstrappingKeyFFT *const bkFFT, const LweKey *lwe_key,
+    const TGswKey *tgsw_key, const int32_t sparse)
+    : params(params), lwe_key(lwe_key), tgsw_key(tgsw_key),
+      cloud(params, bk, bkFFT, sparse) {}
+
+TFheGateBootstrappingSeededCiphertextArray::
+    TFheGateBootstrappingSeededCiphertextArray(const int32_t nbelems,
+                                               LweSample *const samples)
+    : nbelems(nbelems), samples(samples), seed() {}
@@ -0,0 +1,283 @@
+#include "tfhe_gate_executor.h"
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+/** one gate of the graph */
+struct GateNode {
+  int32_t arity;
+  TFheUnaryGate gate1;
+  TFheBinaryGate gate2;
+  TFheTernaryGate gate3;
+  LweSample *result;
+  const LweSample *in[3];
+  const TFheGateBootstrappingCloudKeySet *bk;
+
+  atomic<int32_t> pending; // number of predecessors not yet evaluated
+  vector<GateNode *> successors;
+
+  GateNode() : arity(0), gate1(0), gate2(0), gate3(0), result(0), bk(0),
+               pending(0) {
+    in[0] = in[1] = in[2] = 0;
+  }
+
+  void evaluate() const {
+    switch (arity) {
+    case 1:
+      gate1(result, in[0], bk);
+      break;
+    case 2:
+      gate2(result, in[0], in[1], bk);
+      break;
+    case 3:
+      gate3(result, in[0], in[1], in[2], bk);
+      break;
+    default:
+      assert(false);
+    }
+  }
+};
+
+/** last writer and readers of a sample, in submission order */
+struct SampleHistory {
+  GateNode *writer;
+  vector<GateNode *> readers;
+
+  SampleHistory() : writer(0) {}
+};
+
+/** the ready gates of one worker: the owner works at the back, thieves at the front */
+struct WorkerQueue {
+  mutex lock;
+  deque<GateNode *> nodes;
+};
+
+} // namespace
+
+struct TFheGateExecutor {
+  int32_t nb_threads;
+  vector<thread> workers;
+  WorkerQueue *queues;
+
+  // the graph being built
+  vector<GateNode *> nodes;
+  unordered_map<const LweSample *, SampleHistory> history;
+
+  // synchronization between run and the workers
+  mutex lock;
+  condition_variable work_available;
+  condition_variable all_done;
+  atomic<int32_t> nb_queued;    // gates waiting in the queues
+  atomic<int32_t> nb_remaining; // gates of the current run not yet evaluated
+  bool stop;
+
+  TFheGateExecutor(int32_t nb_threads);
+  ~TFheGateExecutor();
+
+  void depends(GateNode *node, GateNode *predecessor);
+  void addNode(GateNode *node);
+  void push(int32_t id, GateNode *node);
+  GateNode *pop(int32_t id);
+  void workerLoop(int32_t id);
+  void run();
+
+  TFheGateExecutor(const TFheGateExecutor &) = delete;
+  void operator=(const TFheGateExecutor &) = delete;
+};
+
+TFheGateExecutor::TFheGateExecutor(int32_t nb_threads)
+    : nb_threads(nb_threads), nb_queued(0), nb_remaining(0), stop(false) {
+  if (this->nb_threads <= 0)
+    this->nb_threads = thread::hardware_concurrency();
+  if (this->nb_threads <= 0)
+    this->nb_threads = 1;
+  queues = new WorkerQueue[this->nb_threads];
+  for (int32_t i = 0; i < this->nb_threads; i++)
+    workers.push_back(thread(&TFheGateExecutor::workerLoop, this, i));
+}
+
+TFheGateExecutor::~TFheGateExecutor() {
+  {
+    unique_lock<mutex> lk(lock);
+    stop = true;
+  }
+  work_available.notify_all();
+  for (thread &t : workers)
+    t.join();
+  for (GateNode *node : nodes)
+    delete node;
+  delete[] queues;
+}
+
+/** adds the edge predecessor -> node (once) */
+void TFheGateExecutor::depends(GateNode *node, GateNode *predecessor) {
+  if (predecessor == 0 || predecessor == node)
+    return;
+  vector<GateNode *> &succ = predecessor->successors;
+  if (!succ.empty() && succ.back() == node)
+    return;
+  succ.push_back(node);
+  node->pending++;
+}
+
+void TFheGateExecutor::addNode(GateNode *node) {
+  // read after write: wait for the last writer of each input
+  for (int32_t i = 0; i < node->arity; i++)
+    depends(node, history[node->in[i]].writer);
+  // write after read and write after write on the output
+  SampleHistory &out = history[node->result];
+  depends(node, out.writer);
+  for (GateNode *reader : out.readers)
+    depends(node, reader);
+  // the inputs are read by this node (unless it also overwrites them)
+  for (int32_t i = 0; i < node->arity; i++)
+    if (node->in[i] != node->result)
+      history[node->in[i]].readers.push_back(node);
+  out.writer = node;
+  out.readers.clear();
+  nodes.push_back(node);
+}
+
+void TFheGateExecutor::push(int32_t id, GateNode *node) {
+  {
+    unique_lock<mutex> lk(queues[id].lock);
+    queues[id].nodes.push_back(node);
+  }
+  nb_queued++;
+  {
+    unique_lock<mutex> lk(lock);
+  }
+  work_available.notify_one();
+}
+
+/** takes a gate from the own queue of the worker, or steals one from another */
+GateNode *TFheGateExecutor::pop(int32_t id) {
+  for (int32_t j = 0; j < nb_threads; j++) {
+    WorkerQueue &q = queues[(id + j) % nb_threads];
+    unique_lock<mutex> lk(q.lock);
+    if (q.nodes.empty())
+      continue;
+    GateNode *node;
+    if (j == 0) {
+      node = q.nodes.back();
+      q.nodes.pop_back();
+    } else {
+      node = q.nodes.front();
+      q.nodes.pop_front();
+    }
+    nb_queued--;
+    return node;
+  }
+  return 0;
+}
+
+void TFheGateExecutor::workerLoop(int32_t id) {
+  while (true) {
+    GateNode *node = pop(id);
+    if (node == 0) {
+      unique_lock<mutex> lk(lock);
+      work_available.wait(lk, [this] { return stop || nb_queued > 0; });
+      if (stop)
+        return;
+      continue;
+    }
+    node->evaluate();
+    for (GateNode *succ : node->successors)
+      if (--succ->pending == 0)
+        push(id, succ);
+    if (--nb_remaining == 0) {
+      unique_lock<mutex> lk(lock);
+      all_done.notify_all();
+    }
+  }
+}
+
+void TFheGateExecutor::run() {
+  if (nodes.empty())
+    return;
+  nb_remaining = nodes.size();
+  // the ready gates must be listed before the workers start decrementing
+  // the pending counters, otherwise a gate could be queued twice
+  vector<GateNode *> ready;
+  for (GateNode *node : nodes)
+    if (node->pending == 0)
+      ready.push_back(node);
+  // distribute them among the workers
+  for (size_t i = 0; i < ready.size(); i++)
+    push(i % nb_threads, ready[i]);
+  {
+    unique_lock<mutex> lk(lock);
+    all_done.wait(lk, [this] { return nb_remaining == 0; });
+  }
+  for (GateNode *node : nodes)
+    delete node;
+  nodes.clear();
+  history.clear();
+}
+
+EXPORT TFheGateExecutor *new_gate_executor(int32_t nb_threads) {
+  return new TFheGateExecutor(nb_threads);
+}
+
+EXPORT void delete_gate_executor(TFheGateExecutor *executor) {
+  delete executor;
+}
+
+EXPORT int32_t tfhe_gateExecutorNbThreads(const TFheGateExecutor *executor) {
+  return executor->nb_threads;
+}
+
+EXPORT void tfhe_gateExecutorAddUnary(TFheGateExecutor *executor,
+                                      TFheUnaryGate gate, LweSample *result,
+                                      const LweSample *ca,
+                                      const TFheGateBootstrappingCloudKeySet *bk) {
+  GateNode *node = new GateNode();
+  node->arity = 1;
+  node->gate1 = gate;
+  node->result = result;
+  node->in[0] = ca;
+  node->bk = bk;
+  executor->addNode(node);
+}
+
+EXPORT void tfhe_gateExecutorAddBinary(
+    TFheGateExecutor *executor, TFheBinaryGate gate, LweSample *result,
+    const LweSample *ca, const LweSample *cb,
+    const TFheGateBootstrappingCloudKeySet *bk) {
+  GateNode *node = new GateNode();
+  node->arity = 2;
+  node->gate2 = gate;
+  node->result = result;
+  node->in[0] = ca;
+  node->in[1] = cb;
+  node->bk = bk;
+  executor->addNode(node);
+}
+
+EXPORT void tfhe_gateExecutorAddTernary(
+    TFheGateExecutor *executor, TFheTernaryGate gate, LweSample *result,
+    const LweSample *ca, const LweSample *cb, const LweSample *cc,
+    const TFheGateBootstrappingCloudKeySet *bk) {
+  GateNode *node = new GateNode();
+  node->arity = 3;
+  node->gate3 = gate;
+  node->result = result;
+  node->in[0] = ca;
+  node->in[1] = cb;
+  node->in[2] = cc;
+  node->bk = bk;
+  executor->addNode(node);
+}
+
+EXPORT void tfhe_gateExecutorRun(TFheGateExecutor *executor) {
+  executor->run();
+}
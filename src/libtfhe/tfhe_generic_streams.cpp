@@ -27,6 +27,10 @@ public:
         return data.at(name);
     }
 
+    virtual bool hasProperty(const std::string &name) const {
+        return data.count(name) != 0;
+    }
+
     virtual void setTypeTitle(const std::string &title) {
         this->title = title;
     }
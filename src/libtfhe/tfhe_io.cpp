@@ -8,6 +8,7 @@
 #include "tfhe_garbage_collector.h"
 #include "lwe-functions.h"
 #include "lwekeyswitch.h"
+#include "numeric_functions.h"
 #include "tlwe_functions.h"
 #include "tgsw_functions.h"
 #include "polynomials_arithmetic.h"
@@ -107,6 +108,46 @@ void write_lweSample(const Ostream &F, const LweSample *sample, const LweParams
 }
 
 
+/**
+ * Writes an array of samples whose masks are expanded from seed (the sample i
+ * from the row i): only the seed and the b parts are written
+ */
+void write_lweSampleArray_seeded(const Ostream &F, const LweSample *samples, int32_t nbelems, const TfheMaskSeed *seed) {
+    double max_variance = -1;
+    for (int32_t i = 0; i < nbelems; i++)
+        if (samples[i].current_variance > max_variance)
+            max_variance = samples[i].current_variance;
+    F.fwrite(&LWE_SEEDED_SAMPLE_ARRAY_TYPE_UID, sizeof(int32_t));
+    F.fwrite(&nbelems, sizeof(int32_t));
+    F.fwrite(&max_variance, sizeof(double));
+    F.fwrite(seed, sizeof(TfheMaskSeed));
+    for (int32_t i = 0; i < nbelems; i++)
+        F.fwrite(&samples[i].b, sizeof(Torus32));
+}
+
+/**
+ * Reads an array of seed-compressed samples, and expands their masks
+ */
+void read_lweSampleArray_seeded(const Istream &F, LweSample *samples, int32_t nbelems, const LweParams *params) {
+    const int32_t n = params->n;
+    int32_t type_uid, nb;
+    double max_variance;
+    TfheMaskSeed seed;
+    F.fread(&type_uid, sizeof(int32_t));
+    if (type_uid != LWE_SEEDED_SAMPLE_ARRAY_TYPE_UID)
+        die_dramatically("Trying to read something that is not a compressed LWE array!");
+    F.fread(&nb, sizeof(int32_t));
+    if (nb != nbelems)
+        die_dramatically("Wrong number of samples in the compressed LWE array");
+    F.fread(&max_variance, sizeof(double));
+    F.fread(&seed, sizeof(TfheMaskSeed));
+    for (int32_t i = 0; i < nbelems; i++) {
+        F.fread(&samples[i].b, sizeof(Torus32));
+        tfhe_seededUniformTorus32(samples[i].a, n, &seed, i);
+        samples[i].current_variance = max_variance;
+    }
+}
+
 /**
  * This function prints the lwe sample to a file
  */
@@ -784,8 +825,38 @@ void write_LweKeySwitchKey_content(const Ostream &F, const LweKeySwitchKey *ks)
             }
 }
 
+/**
+ * This function prints the keyswitch coefficients in seed-compressed form:
+ * only the seed of the masks and the b parts are written
+ */
+void write_LweKeySwitchKey_seeded_content(const Ostream &F, const LweKeySwitchKey *ks) {
+    const int32_t N = ks->n;
+    const int32_t t = ks->t;
+    const int32_t base = ks->base;
+    double current_variance = -1;
+
+    if (tfhe_isNullMaskSeed(&ks->seed))
+        die_dramatically("The keyswitch key was not created from a seed!");
+    for (int32_t i = 0; i < N; i++)
+        for (int32_t j = 0; j < t; j++)
+            for (int32_t k = 0; k < base; k++) {
+                const LweSample &sample = ks->ks[i][j][k];
+                if (sample.current_variance > current_variance)
+                    current_variance = sample.current_variance;
+            }
+    F.fwrite(&LWE_SEEDED_KEYSWITCH_KEY_TYPE_UID, sizeof(int32_t));
+    F.fwrite(&current_variance, sizeof(double));
+    F.fwrite(&ks->seed, sizeof(TfheMaskSeed));
+    //the terms h=0 are trivial encryptions of 0: they are not written
+    for (int32_t i = 0; i < N; i++)
+        for (int32_t j = 0; j < t; j++)
+            for (int32_t k = 1; k < base; k++)
+                F.fwrite(&ks->ks[i][j][k].b, 1 * sizeof(Torus32));
+}
+
 /**
  * This function reads the keyswitch coefficients
+ * (in full or seed-compressed form)
  */
 void read_lweKeySwitchKey_content(const Istream &F, LweKeySwitchKey *ks) {
     const LweParams *out_params = ks->out_params;
@@ -797,6 +868,22 @@ void read_lweKeySwitchKey_content(const Istream &F, LweKeySwitchKey *ks) {
 
     int32_t type_uid = -1;
     F.fread(&type_uid, sizeof(int32_t));
+    if (type_uid == LWE_SEEDED_KEYSWITCH_KEY_TYPE_UID) {
+        F.fread(&current_variance, sizeof(double));
+        F.fread(&ks->seed, sizeof(TfheMaskSeed));
+        //expand the masks, and read the b parts
+        for (int32_t i = 0; i < N; i++)
+            for (int32_t j = 0; j < t; j++) {
+                lweNoiselessTrivial(&ks->ks[i][j][0], 0, out_params);
+                for (int32_t k = 1; k < base; k++) {
+                    LweSample &sample = ks->ks[i][j][k];
+                    tfhe_seededUniformTorus32(sample.a, n, &ks->seed, uint64_t(i * t + j) * base + k);
+                    F.fread(&sample.b, 1 * sizeof(Torus32));
+                    sample.current_variance = current_variance;
+                }
+            }
+        return;
+    }
     if (type_uid != LWE_KEYSWITCH_KEY_TYPE_UID)
         die_dramatically("Trying to read something that is not a LWE Keyswitch!");
     //reads the variance only once in the end
@@ -905,8 +992,34 @@ void write_LweBootstrappingKey_content(const Ostream &F, const LweBootstrappingK
         }
 }
 
+/**
+ * This function prints the bootstrapping coefficients in seed-compressed form:
+ * only the seed of the masks and the body polynomials are written
+ */
+void write_LweBootstrappingKey_seeded_content(const Ostream &F, const LweBootstrappingKey *bk) {
+    const int32_t n = bk->in_out_params->n;
+    const int32_t kpl = bk->bk_params->kpl;
+    const int32_t N = bk->bk_params->tlwe_params->N;
+    double max_variance = -1;
+    if (tfhe_isNullMaskSeed(&bk->seed))
+        die_dramatically("The bootstrapping key was not created from a seed!");
+    for (int32_t i = 0; i < n; i++)
+        for (int32_t j = 0; j < kpl; j++) {
+            TLweSample &sample = bk->bk[i].all_sample[j];
+            if (sample.current_variance > max_variance)
+                max_variance = sample.current_variance;
+        }
+    F.fwrite(&LWE_SEEDED_BOOTSTRAPPING_KEY_TYPE_UID, sizeof(int32_t));
+    F.fwrite(&max_variance, sizeof(double));
+    F.fwrite(&bk->seed, sizeof(TfheMaskSeed));
+    for (int32_t i = 0; i < n; i++)
+        for (int32_t j = 0; j < kpl; j++)
+            F.fwrite(bk->bk[i].all_sample[j].b->coefsT, N * sizeof(Torus32));
+}
+
 /**
  * This function reads the bootstrapping the coefficients (tgsw array section only)
+ * (in full or seed-compressed form)
  */
 void read_LweBootstrappingKey_content(const Istream &F, LweBootstrappingKey *bk) {
     const int32_t n = bk->in_out_params->n;
@@ -916,6 +1029,20 @@ void read_LweBootstrappingKey_content(const Istream &F, LweBootstrappingKey *bk)
     double max_variance = -1;
     int32_t type_uid = -1;
     F.fread(&type_uid, sizeof(int32_t));
+    if (type_uid == LWE_SEEDED_BOOTSTRAPPING_KEY_TYPE_UID) {
+        F.fread(&max_variance, sizeof(double));
+        F.fread(&bk->seed, sizeof(TfheMaskSeed));
+        //the line j of bk[i] has the seed rows (i.kpl+j).k+l (see tGswSymEncryptIntSeeded)
+        for (int32_t i = 0; i < n; i++)
+            for (int32_t j = 0; j < kpl; j++) {
+                TLweSample &sample = bk->bk[i].all_sample[j];
+                for (int32_t l = 0; l < k; l++)
+                    tfhe_seededUniformTorus32(sample.a[l].coefsT, N, &bk->seed, (uint64_t(i) * kpl + j) * k + l);
+                F.fread(sample.b->coefsT, N * sizeof(Torus32));
+                sample.current_variance = max_variance;
+            }
+        return;
+    }
     if (type_uid != LWE_BOOTSTRAPPING_KEY_TYPE_UID)
         die_dramatically("Trying to read something that is not a BK content");
     F.fread(&max_variance, sizeof(double));
@@ -933,14 +1060,20 @@ void read_LweBootstrappingKey_content(const Istream &F, LweBootstrappingKey *bk)
 /**
  * This function prints the bootstrapping parameters to a generic stream
  * It only prints the parameters section, not the coefficients
+ * (if compressed, the coefficients are written in seed-compressed form)
  */
 void write_lweBootstrappingKey(const Ostream &F, const LweBootstrappingKey *bk, bool write_inout_params = true,
-                               bool write_bk_params = true) {
+                               bool write_bk_params = true, bool compressed = false) {
     if (write_inout_params) write_lweParams(F, bk->in_out_params);
     if (write_bk_params) write_tGswParams(F, bk->bk_params);
     write_LweKeySwitchParameters_section(F, bk->ks);
-    write_LweKeySwitchKey_content(F, bk->ks);
-    write_LweBootstrappingKey_content(F, bk);
+    if (compressed) {
+        write_LweKeySwitchKey_seeded_content(F, bk->ks);
+        write_LweBootstrappingKey_seeded_content(F, bk);
+    } else {
+        write_LweKeySwitchKey_content(F, bk->ks);
+        write_LweBootstrappingKey_content(F, bk);
+    }
 }
 
 /**
@@ -1010,38 +1143,59 @@ EXPORT LweBootstrappingKey *new_lweBootstrappingKey_fromStream(std::istream &F)
  **************************** */
 
 
+/**
+ * This function prints the gate bootstrapping proper parameters section.
+ * When the section is part of a cloud or secret keyset, sparse is the flag
+ * of the keyset (it is omitted for a standalone parameter set: sparse<0)
+ */
 void
-write_tfheGateBootstrappingProperParameters_section(const Ostream &F, const TFheGateBootstrappingParameterSet *params) {
+write_tfheGateBootstrappingProperParameters_section(const Ostream &F, const TFheGateBootstrappingParameterSet *params,
+                                                    int32_t sparse = -1) {
     TextModeProperties *props = new_TextModeProperties_blank();
     props->setTypeTitle("GATEBOOTSPARAMS");
     props->setProperty_int64_t("ks_t", params->ks_t);
     props->setProperty_int64_t("ks_basebit", params->ks_basebit);
+    if (params->hw != 0) props->setProperty_int64_t("hw", params->hw);
+    if (sparse >= 0) props->setProperty_int64_t("sparse", sparse);
     print_TextModeProperties_toOStream(F, props);
     delete_TextModeProperties(props);
 }
 
-void read_tfheGateBootstrappingProperParameters_section(const Istream &F, int32_t &ks_t, int32_t &ks_basebit) {
+/**
+ * This function reads the gate bootstrapping proper parameters section.
+ * hw and sparse are optional (they are set to 0 if absent)
+ */
+void read_tfheGateBootstrappingProperParameters_section(const Istream &F, int32_t &ks_t, int32_t &ks_basebit,
+                                                        int32_t &hw, int32_t &sparse) {
     TextModeProperties *props = new_TextModeProperties_fromIstream(F);
     if (props->getTypeTitle() != string("GATEBOOTSPARAMS")) abort();
     ks_t = props->getProperty_int64_t("ks_t");
     ks_basebit = props->getProperty_double("ks_basebit");
+    hw = props->hasProperty("hw") ? props->getProperty_int64_t("hw") : 0;
+    sparse = props->hasProperty("sparse") ? props->getProperty_int64_t("sparse") : 0;
     delete_TextModeProperties(props);
 }
 
-void write_tfheGateBootstrappingParameters(const Ostream &F, const TFheGateBootstrappingParameterSet *params) {
-    write_tfheGateBootstrappingProperParameters_section(F, params);
+void write_tfheGateBootstrappingParameters(const Ostream &F, const TFheGateBootstrappingParameterSet *params,
+                                           int32_t sparse = -1) {
+    write_tfheGateBootstrappingProperParameters_section(F, params, sparse);
     write_lweParams(F, params->in_out_params);
     write_tGswParams(F, params->tgsw_params);
 }
 
-TFheGateBootstrappingParameterSet *read_new_tfheGateBootstrappingParameters(const Istream &F) {
-    int32_t ks_t, ks_basebit;
-    read_tfheGateBootstrappingProperParameters_section(F, ks_t, ks_basebit);
+/**
+ * Reads a gate bootstrapping parameter set. If sparse is not null, it receives
+ * the sparse flag of the enclosing keyset
+ */
+TFheGateBootstrappingParameterSet *read_new_tfheGateBootstrappingParameters(const Istream &F, int32_t *sparse = 0) {
+    int32_t ks_t, ks_basebit, hw, sparse_flag;
+    read_tfheGateBootstrappingProperParameters_section(F, ks_t, ks_basebit, hw, sparse_flag);
     LweParams *in_out_params = read_new_lweParams(F);
     TGswParams *bk_params = read_new_tGswParams(F);
     TfheGarbageCollector::register_param(in_out_params);
     TfheGarbageCollector::register_param(bk_params);
-    return new TFheGateBootstrappingParameterSet(ks_t, ks_basebit, in_out_params, bk_params);
+    if (sparse != 0) *sparse = sparse_flag;
+    return new TFheGateBootstrappingParameterSet(ks_t, ks_basebit, hw, in_out_params, bk_params);
 }
 
 /**
@@ -1086,20 +1240,22 @@ EXPORT TFheGateBootstrappingParameterSet *new_tfheGateBootstrappingParameterSet_
 
 TFheGateBootstrappingCloudKeySet *
 read_new_tfheGateBootstrappingCloudKeySet(const Istream &F, const TFheGateBootstrappingParameterSet *params = 0) {
+    int32_t sparse = 0;
     if (params == 0) {
-        TFheGateBootstrappingParameterSet *tmp = read_new_tfheGateBootstrappingParameters(F);
+        TFheGateBootstrappingParameterSet *tmp = read_new_tfheGateBootstrappingParameters(F, &sparse);
         TfheGarbageCollector::register_param(tmp);
         params = tmp;
     }
     LweBootstrappingKey *bk = read_new_lweBootstrappingKey(F, params->in_out_params, params->tgsw_params);
     LweBootstrappingKeyFFT *bkFFT = new_LweBootstrappingKeyFFT(bk);
-    return new TFheGateBootstrappingCloudKeySet(params, bk, bkFFT);
+    tfhe_flattenKeySwitchKeyFFT(bkFFT);
+    return new TFheGateBootstrappingCloudKeySet(params, bk, bkFFT, sparse);
 }
 
 void write_tfheGateBootstrappingCloudKeySet(const Ostream &F, const TFheGateBootstrappingCloudKeySet *key,
-                                            bool output_gbparams = true) {
-    if (output_gbparams) write_tfheGateBootstrappingParameters(F, key->params);
-    write_lweBootstrappingKey(F, key->bk, false, false);
+                                            bool output_gbparams = true, bool compressed = false) {
+    if (output_gbparams) write_tfheGateBootstrappingParameters(F, key->params, key->sparse);
+    write_lweBootstrappingKey(F, key->bk, false, false, compressed);
 }
 
 
@@ -1118,6 +1274,16 @@ EXPORT TFheGateBootstrappingCloudKeySet *new_tfheGateBootstrappingCloudKeySet_fr
     return read_new_tfheGateBootstrappingCloudKeySet(to_Istream(F));
 }
 
+/**
+ * This function prints the tfhe gate bootstrapping cloud key to a file, in
+ * seed-compressed form (the keyset must have been created from seeds). It is
+ * read back with new_tfheGateBootstrappingCloudKeySet_fromFile
+ */
+EXPORT void export_tfheGateBootstrappingCloudKeySet_compressed_toFile(FILE *F,
+                                                                      const TFheGateBootstrappingCloudKeySet *keyset) {
+    write_tfheGateBootstrappingCloudKeySet(to_Ostream(F), keyset, true, true);
+}
+
 #ifdef __cplusplus
 
 /**
@@ -1136,6 +1302,16 @@ EXPORT TFheGateBootstrappingCloudKeySet *new_tfheGateBootstrappingCloudKeySet_fr
     return read_new_tfheGateBootstrappingCloudKeySet(to_Istream(F));
 }
 
+/**
+ * This function prints the tfhe gate bootstrapping cloud key to a stream, in
+ * seed-compressed form (the keyset must have been created from seeds). It is
+ * read back with new_tfheGateBootstrappingCloudKeySet_fromStream
+ */
+EXPORT void export_tfheGateBootstrappingCloudKeySet_compressed_toStream(std::ostream &F,
+                                                                        const TFheGateBootstrappingCloudKeySet *keyset) {
+    write_tfheGateBootstrappingCloudKeySet(to_Ostream(F), keyset, true, true);
+}
+
 #endif
 
 /* ****************************
@@ -1145,8 +1321,9 @@ EXPORT TFheGateBootstrappingCloudKeySet *new_tfheGateBootstrappingCloudKeySet_fr
 
 TFheGateBootstrappingSecretKeySet *
 read_new_tfheGateBootstrappingSecretKeySet(const Istream &F, const TFheGateBootstrappingParameterSet *params = 0) {
+    int32_t sparse = 0;
     if (params == 0) {
-        TFheGateBootstrappingParameterSet *tmp = read_new_tfheGateBootstrappingParameters(F);
+        TFheGateBootstrappingParameterSet *tmp = read_new_tfheGateBootstrappingParameters(F, &sparse);
         TfheGarbageCollector::register_param(tmp);
         params = tmp;
     }
@@ -1154,12 +1331,13 @@ read_new_tfheGateBootstrappingSecretKeySet(const Istream &F, const TFheGateBoots
     LweKey *lwe_key = read_new_lweKey(F, params->in_out_params);
     TGswKey *tgsw_key = read_new_tGswKey(F, params->tgsw_params);
     LweBootstrappingKeyFFT *bkFFT = new_LweBootstrappingKeyFFT(bk);
-    return new TFheGateBootstrappingSecretKeySet(params, bk, bkFFT, lwe_key, tgsw_key);
+    tfhe_flattenKeySwitchKeyFFT(bkFFT);
+    return new TFheGateBootstrappingSecretKeySet(params, bk, bkFFT, lwe_key, tgsw_key, sparse);
 }
 
 void write_tfheGateBootstrappingSecretKeySet(const Ostream &F, const TFheGateBootstrappingSecretKeySet *key,
                                              bool output_gbparams = true) {
-    if (output_gbparams) write_tfheGateBootstrappingParameters(F, key->params);
+    if (output_gbparams) write_tfheGateBootstrappingParameters(F, key->params, key->cloud.sparse);
     write_lweBootstrappingKey(F, key->cloud.bk, false, false);
     write_lweKey(F, key->lwe_key, false);
     write_tGswKey(F, key->tgsw_key, false);
@@ -1225,6 +1403,26 @@ EXPORT void import_gate_bootstrapping_ciphertext_fromFile(FILE *F, LweSample *sa
     import_lweSample_fromFile(F, sample, params->in_out_params);
 }
 
+/**
+ * This function prints an array of ciphertexts encrypted with bootsSymEncryptSeeded
+ * to a file, in compressed form (seed and b parts only)
+ */
+EXPORT void export_gate_bootstrapping_ciphertext_array_compressed_toFile(FILE *F,
+                                                                         const TFheGateBootstrappingSeededCiphertextArray *samples,
+                                                                         const TFheGateBootstrappingParameterSet *) {
+    write_lweSampleArray_seeded(to_Ostream(F), samples->samples, samples->nbelems, &samples->seed);
+}
+
+/**
+ * This function reads an array of nbelems compressed ciphertexts from a File,
+ * and expands their masks
+ */
+EXPORT void import_gate_bootstrapping_ciphertext_array_compressed_fromFile(FILE *F, LweSample *samples,
+                                                                           int32_t nbelems,
+                                                                           const TFheGateBootstrappingParameterSet *params) {
+    read_lweSampleArray_seeded(to_Istream(F), samples, nbelems, params->in_out_params);
+}
+
 #ifdef __cplusplus
 
 /**
@@ -1245,6 +1443,26 @@ EXPORT void import_gate_bootstrapping_ciphertext_fromStream(std::istream &F, Lwe
     import_lweSample_fromStream(F, sample, params->in_out_params);
 }
 
+/**
+ * This function prints an array of ciphertexts encrypted with bootsSymEncryptSeeded
+ * to a stream, in compressed form (seed and b parts only)
+ */
+EXPORT void export_gate_bootstrapping_ciphertext_array_compressed_toStream(std::ostream &F,
+                                                                           const TFheGateBootstrappingSeededCiphertextArray *samples,
+                                                                           const TFheGateBootstrappingParameterSet *) {
+    write_lweSampleArray_seeded(to_Ostream(F), samples->samples, samples->nbelems, &samples->seed);
+}
+
+/**
+ * This function reads an array of nbelems compressed ciphertexts from a stream,
+ * and expands their masks
+ */
+EXPORT void import_gate_bootstrapping_ciphertext_array_compressed_fromStream(std::istream &F, LweSample *samples,
+                                                                             int32_t nbelems,
+                                                                             const TFheGateBootstrappingParameterSet *params) {
+    read_lweSampleArray_seeded(to_Istream(F), samples, nbelems, params->in_out_params);
+}
+
 #endif
 
 
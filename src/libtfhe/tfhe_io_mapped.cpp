@@ -0,0 +1,283 @@
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "tfhe.h"
+#include "tfhe_garbage_collector.h"
+
+using namespace std;
+
+/* ****************************
+ * Mapped cloud keyset
+ **************************** */
+
+/*
+ * File layout (native endianness, version 1):
+ * - the header below, padded to MAPPED_KEY_ALIGN bytes
+ * - at bk_offset: the n.kpl.(k+1) polynomials of bkFFT, N doubles each, in
+ *   the layout of the fft processor that wrote them
+ * - at ks_offset: the N.t.base rows of the flattened keyswitch key,
+ *   flat_stride Torus32 each, followed by their N.t.base b parts
+ * All the sections start on a page boundary, so that the mapped
+ * coefficients are as aligned as the ones of a key in memory.
+ */
+
+namespace {
+
+const char MAPPED_KEY_MAGIC[8] = {'T', 'F', 'H', 'E', 'M', 'A', 'P', 'K'};
+const int32_t MAPPED_KEY_VERSION = 1;
+const int64_t MAPPED_KEY_ALIGN = 4096;
+
+struct MappedKeyHeader {
+    char magic[8];
+    int32_t version;
+    int32_t header_size;
+    char fft_layout[16];
+    // gate bootstrapping parameters
+    int32_t ks_t;
+    int32_t ks_basebit;
+    int32_t hw;
+    int32_t sparse;
+    int32_t n;
+    int32_t N;
+    int32_t k;
+    int32_t l;
+    int32_t Bgbit;
+    int32_t flat_stride;
+    double lwe_alpha_min;
+    double lwe_alpha_max;
+    double tlwe_alpha_min;
+    double tlwe_alpha_max;
+    double bk_variance;
+    double ks_variance;
+    // sections
+    int64_t bk_offset;
+    int64_t ks_offset;
+    int64_t file_size;
+};
+
+int64_t alignUp(int64_t x) { return (x + MAPPED_KEY_ALIGN - 1) & ~(MAPPED_KEY_ALIGN - 1); }
+
+void writePadding(FILE *F, int64_t size) {
+    static const char zeros[MAPPED_KEY_ALIGN] = {0};
+    while (size > 0) {
+        const int64_t len = size < MAPPED_KEY_ALIGN ? size : MAPPED_KEY_ALIGN;
+        fwrite(zeros, 1, len, F);
+        size -= len;
+    }
+}
+
+/**
+ * checks that the dimensions and the sections of the header h describe a
+ * file of h.file_size bytes, before any view is built on the mapping
+ */
+void checkMappedKeyHeader(const MappedKeyHeader &h) {
+    // (the bounds keep the sizes below in 64-bit range)
+    if (h.n <= 0 || h.n > (1 << 20) || h.N <= 0 || h.N > (1 << 16) || (h.N & (h.N - 1)) != 0 || h.k <= 0 ||
+        h.k > 8 || h.l <= 0 || h.Bgbit <= 0 || h.l * h.Bgbit > 32 || h.ks_t <= 0 || h.ks_basebit <= 0 ||
+        h.ks_t * h.ks_basebit > 32)
+        die_dramatically("Corrupt mapped cloud key file (dimensions)");
+    const int64_t kpl = int64_t(h.k + 1) * h.l;
+    const int64_t bk_size = int64_t(h.n) * kpl * (h.k + 1) * h.N * sizeof(double);
+    if (h.bk_offset < int64_t(sizeof(MappedKeyHeader)) || h.bk_offset % MAPPED_KEY_ALIGN != 0 ||
+        h.bk_offset > h.file_size || h.bk_offset + bk_size > h.ks_offset)
+        die_dramatically("Corrupt mapped cloud key file (bootstrapping key section)");
+    if (h.flat_stride < h.n || h.flat_stride >= h.n + 16 || h.flat_stride % 16 != 0)
+        die_dramatically("Corrupt mapped cloud key file (keyswitch key stride)");
+    const int64_t nb_ks = int64_t(h.k) * h.N * h.ks_t * (1 << h.ks_basebit);
+    if (h.ks_offset > h.file_size || h.ks_offset + nb_ks * (h.flat_stride + 1) * int64_t(sizeof(Torus32)) != h.file_size)
+        die_dramatically("Corrupt mapped cloud key file (keyswitch key section)");
+}
+
+/**
+ * a cloud keyset whose FFT key and keyswitch key are read-only views on a
+ * mapped file: the structures around them are the only allocations
+ */
+struct MappedCloudKeySet {
+    TFheGateBootstrappingCloudKeySet cloud; // must stay the first member
+    void *map;
+    size_t map_size;
+    LagrangeHalfCPolynomial *polys;
+    TLweSampleFFT *tlwe_samples;
+    TGswSampleFFT *tgsw_samples;
+    LweSample *ks_samples;
+
+    MappedCloudKeySet(const TFheGateBootstrappingParameterSet *params, const LweBootstrappingKeyFFT *bkFFT,
+                      int32_t sparse, void *map, size_t map_size, LagrangeHalfCPolynomial *polys,
+                      TLweSampleFFT *tlwe_samples, TGswSampleFFT *tgsw_samples, LweSample *ks_samples)
+            : cloud(params, 0, bkFFT, sparse), map(map), map_size(map_size), polys(polys),
+              tlwe_samples(tlwe_samples), tgsw_samples(tgsw_samples), ks_samples(ks_samples) {}
+};
+
+} // namespace
+
+EXPORT void export_tfheGateBootstrappingCloudKeySet_mapped_toFile(FILE *F,
+                                                                  const TFheGateBootstrappingCloudKeySet *keyset) {
+    const TFheGateBootstrappingParameterSet *params = keyset->params;
+    const LweBootstrappingKeyFFT *bkFFT = keyset->bkFFT;
+    const LweKeySwitchKey *ks = bkFFT->ks;
+    const int32_t n = params->in_out_params->n;
+    const int32_t N = params->tgsw_params->tlwe_params->N;
+    const int32_t k = params->tgsw_params->tlwe_params->k;
+    const int32_t kpl = params->tgsw_params->kpl;
+    const int32_t n_out = ks->out_params->n;
+    const int32_t flat_stride = (n_out + 15) & ~15;
+    const int64_t nb_ks = int64_t(ks->n) * ks->t * ks->base;
+    if (bkFFT->bkFFT->all_samples[0].a_float32)
+        die_dramatically("A single precision cloud key cannot be exported in mapped form");
+
+    MappedKeyHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MAPPED_KEY_MAGIC, sizeof(h.magic));
+    h.version = MAPPED_KEY_VERSION;
+    h.header_size = sizeof(MappedKeyHeader);
+    strncpy(h.fft_layout, LagrangeHalfCPolynomial_layout(), sizeof(h.fft_layout) - 1);
+    h.ks_t = params->ks_t;
+    h.ks_basebit = params->ks_basebit;
+    h.hw = params->hw;
+    h.sparse = keyset->sparse;
+    h.n = n;
+    h.N = N;
+    h.k = k;
+    h.l = params->tgsw_params->l;
+    h.Bgbit = params->tgsw_params->Bgbit;
+    h.flat_stride = flat_stride;
+    h.lwe_alpha_min = params->in_out_params->alpha_min;
+    h.lwe_alpha_max = params->in_out_params->alpha_max;
+    h.tlwe_alpha_min = params->tgsw_params->tlwe_params->alpha_min;
+    h.tlwe_alpha_max = params->tgsw_params->tlwe_params->alpha_max;
+    h.bk_variance = -1;
+    for (int32_t i = 0; i < n; i++)
+        for (int32_t p = 0; p < kpl; p++)
+            if (bkFFT->bkFFT[i].all_samples[p].current_variance > h.bk_variance)
+                h.bk_variance = bkFFT->bkFFT[i].all_samples[p].current_variance;
+    h.ks_variance = -1;
+    for (int64_t p = 0; p < nb_ks; p++)
+        if (ks->ks0_raw[p].current_variance > h.ks_variance)
+            h.ks_variance = ks->ks0_raw[p].current_variance;
+    h.bk_offset = MAPPED_KEY_ALIGN;
+    h.ks_offset = alignUp(h.bk_offset + int64_t(n) * kpl * (k + 1) * N * sizeof(double));
+    h.file_size = h.ks_offset + nb_ks * (flat_stride + 1) * sizeof(Torus32);
+
+    fwrite(&h, sizeof(h), 1, F);
+    writePadding(F, h.bk_offset - sizeof(h));
+    for (int32_t i = 0; i < n; i++)
+        for (int32_t p = 0; p < kpl; p++)
+            for (int32_t q = 0; q <= k; q++)
+                fwrite(LagrangeHalfCPolynomial_coefs(bkFFT->bkFFT[i].all_samples[p].a + q), sizeof(double), N, F);
+    writePadding(F, h.ks_offset - (h.bk_offset + int64_t(n) * kpl * (k + 1) * N * sizeof(double)));
+    for (int64_t p = 0; p < nb_ks; p++) {
+        fwrite(ks->ks0_raw[p].a, sizeof(Torus32), n_out, F);
+        writePadding(F, (flat_stride - n_out) * sizeof(Torus32));
+    }
+    for (int64_t p = 0; p < nb_ks; p++)
+        fwrite(&ks->ks0_raw[p].b, sizeof(Torus32), 1, F);
+}
+
+EXPORT TFheGateBootstrappingCloudKeySet *new_tfheGateBootstrappingCloudKeySet_mapFile(const char *filename) {
+    const int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        die_dramatically("Cannot open the mapped cloud key file");
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(MappedKeyHeader))
+        die_dramatically("Cannot read the mapped cloud key file");
+    const size_t map_size = st.st_size;
+    // read-only shared mapping: the processes that map the same file share its pages
+    void *map = mmap(0, map_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        die_dramatically("Cannot map the cloud key file");
+
+    const MappedKeyHeader &h = *(const MappedKeyHeader *) map;
+    if (memcmp(h.magic, MAPPED_KEY_MAGIC, sizeof(h.magic)) != 0)
+        die_dramatically("Trying to map something that is not a mapped cloud key");
+    if (h.version != MAPPED_KEY_VERSION || h.header_size != sizeof(MappedKeyHeader))
+        die_dramatically("Unsupported version of the mapped cloud key format");
+    if (strncmp(h.fft_layout, LagrangeHalfCPolynomial_layout(), sizeof(h.fft_layout)) != 0)
+        die_dramatically("The mapped cloud key was written by another fft processor");
+    if (h.file_size != int64_t(map_size))
+        die_dramatically("Truncated mapped cloud key file");
+    checkMappedKeyHeader(h);
+
+    // parameters
+    LweParams *in_out_params = new_LweParams(h.n, h.lwe_alpha_min, h.lwe_alpha_max);
+    TLweParams *tlwe_params = new_TLweParams(h.N, h.k, h.tlwe_alpha_min, h.tlwe_alpha_max);
+    TGswParams *tgsw_params = new_TGswParams(h.l, h.Bgbit, tlwe_params);
+    TFheGateBootstrappingParameterSet *params =
+            new TFheGateBootstrappingParameterSet(h.ks_t, h.ks_basebit, h.hw, in_out_params, tgsw_params);
+    TfheGarbageCollector::register_param(in_out_params);
+    TfheGarbageCollector::register_param(tlwe_params);
+    TfheGarbageCollector::register_param(tgsw_params);
+    TfheGarbageCollector::register_param(params);
+
+    // the FFT key: views on the mapped coefficients
+    const int32_t n = h.n;
+    const int32_t N = h.N;
+    const int32_t k = h.k;
+    const int32_t kpl = tgsw_params->kpl;
+    double *bk_coefs = (double *) ((char *) map + h.bk_offset);
+    LagrangeHalfCPolynomial *polys = alloc_LagrangeHalfCPolynomial_array(n * kpl * (k + 1));
+    TLweSampleFFT *tlwe_samples = (TLweSampleFFT *) malloc(n * kpl * sizeof(TLweSampleFFT));
+    TGswSampleFFT *tgsw_samples = (TGswSampleFFT *) malloc(n * sizeof(TGswSampleFFT));
+    for (int32_t i = 0; i < n * kpl * (k + 1); i++)
+        init_LagrangeHalfCPolynomial_view(polys + i, N, bk_coefs + int64_t(i) * N);
+    for (int32_t i = 0; i < n * kpl; i++) {
+        new(tlwe_samples + i) TLweSampleFFT(tlwe_params, polys + i * (k + 1), h.bk_variance);
+        tlwe_samples[i].current_variance = h.bk_variance;
+    }
+    for (int32_t i = 0; i < n; i++)
+        new(tgsw_samples + i) TGswSampleFFT(tgsw_params, tlwe_samples + i * kpl);
+
+    // the flattened keyswitch key: the masks stay in the mapping
+    const LweParams *extract_params = &tlwe_params->extracted_lweparams;
+    const int32_t ks_n = extract_params->n;
+    const int32_t nb_ks = ks_n * h.ks_t * (1 << h.ks_basebit);
+    Torus32 *ks_flat = (Torus32 *) ((char *) map + h.ks_offset);
+    const Torus32 *ks_b = ks_flat + int64_t(nb_ks) * h.flat_stride;
+    LweSample *ks_samples = alloc_LweSample_array(nb_ks);
+    for (int32_t p = 0; p < nb_ks; p++) {
+        ks_samples[p].a = ks_flat + int64_t(p) * h.flat_stride;
+        ks_samples[p].b = ks_b[p];
+        ks_samples[p].current_variance = h.ks_variance;
+    }
+    LweKeySwitchKey *ks = alloc_LweKeySwitchKey();
+    new(ks) LweKeySwitchKey(ks_n, h.ks_t, h.ks_basebit, in_out_params, ks_samples);
+    ks->ks_flat = ks_flat;
+    ks->flat_stride = h.flat_stride;
+
+    LweBootstrappingKeyFFT *bkFFT = alloc_LweBootstrappingKeyFFT();
+    new(bkFFT) LweBootstrappingKeyFFT(in_out_params, tgsw_params, tlwe_params, extract_params, tgsw_samples, ks);
+    bkFFT->mapped = 1;
+
+    MappedCloudKeySet *reps = new MappedCloudKeySet(params, bkFFT, h.sparse, map, map_size, polys, tlwe_samples,
+                                                    tgsw_samples, ks_samples);
+    return &reps->cloud;
+}
+
+EXPORT void delete_mapped_gate_bootstrapping_cloud_keyset(TFheGateBootstrappingCloudKeySet *keyset) {
+    MappedCloudKeySet *obj = (MappedCloudKeySet *) keyset;
+    LweBootstrappingKeyFFT *bkFFT = (LweBootstrappingKeyFFT *) keyset->bkFFT;
+    LweKeySwitchKey *ks = (LweKeySwitchKey *) bkFFT->ks;
+    const int32_t n = bkFFT->in_out_params->n;
+    const int32_t kpl = bkFFT->bk_params->kpl;
+    const int32_t k = bkFFT->accum_params->k;
+
+    // nothing that points into the mapping is freed
+    free_LweSample_array(ks->n * ks->t * ks->base, obj->ks_samples);
+    ks->ks_flat = 0;
+    ks->~LweKeySwitchKey();
+    free_LweKeySwitchKey(ks);
+    for (int32_t i = 0; i < n; i++)
+        obj->tgsw_samples[i].~TGswSampleFFT();
+    for (int32_t i = 0; i < n * kpl; i++)
+        obj->tlwe_samples[i].~TLweSampleFFT();
+    free(obj->tgsw_samples);
+    free(obj->tlwe_samples);
+    free_LagrangeHalfCPolynomial_array(n * kpl * (k + 1), obj->polys);
+    bkFFT->~LweBootstrappingKeyFFT();
+    free_LweBootstrappingKeyFFT(bkFFT);
+    munmap(obj->map, obj->map_size);
+    delete obj;
+}
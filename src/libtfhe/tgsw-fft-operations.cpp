@@ -116,69 +116,130 @@ EXPORT void tGswFFTExternMulToTLwe(TLweSample *accum, const TGswSampleFFT *gsw,
   delete_IntPolynomial_array(kpl, deca);
 }
 
-// External product (*): accum = gsw (*) accum
-EXPORT void tGswFFTExternMulToTLweHoisting(TLweSample *accum,
-                                           const TGswSampleFFT *gsw,
-                                           const int32_t *bara, const int32_t d,
-                                           const TGswParams *params) {
+// result = fft of the l polynomials of the gadget decomposition of sample
+// (decomposed and transformed in one pass, without the integer polynomials)
+EXPORT void tGswTorus32PolynomialDecompHFFT(LagrangeHalfCPolynomial *result,
+                                            const TorusPolynomial *sample,
+                                            const TGswParams *params) {
+  TorusPolynomial_decompH_ifft(result, sample, params->l, params->Bgbit,
+                               params->offset);
+}
+
+// acc += sum of (X^bara[i]-1) * (gsw_i (*) decaFFT), for the entries
+// i = first, first+step, ... < d (one share of the hoisted external product)
+EXPORT void tGswFFTExternMulHoistingShare(TLweSampleFFT *acc,
+                                          const TGswSampleFFT *gsw,
+                                          const int32_t *bara, const int32_t d,
+                                          const int32_t first,
+                                          const int32_t step,
+                                          const LagrangeHalfCPolynomial *decaFFT,
+                                          const TGswParams *params,
+                                          LweBootstrappingWorkspace *ws) {
   const TLweParams *tlwe_params = params->tlwe_params;
-  const int32_t k = tlwe_params->k;
-  const int32_t l = params->l;
   const int32_t kpl = params->kpl;
-  const int32_t N = tlwe_params->N;
-  // TODO attention, improve these new/delete...
-  IntPolynomial *deca =
-      new_IntPolynomial_array(kpl, N); // decomposed accumulator
-  LagrangeHalfCPolynomial *decaFFT =
-      new_LagrangeHalfCPolynomial_array(kpl, N); // fft version
-  TLweSampleFFT *temp_fft1 = new_TLweSampleFFT(tlwe_params);
-  TLweSampleFFT *temp_fft2 = new_TLweSampleFFT(tlwe_params);
+  TLweSampleFFT *temp_fft2 = ws->tmpb;
+  // cache of pre-rotated elements of the key, if any
+  const LweRotatedKeyFFT *rk = ws->rotated;
 
-  // TLweSample *temp2 = new_TLweSample(tlwe_params);
-
-  for (int32_t i = 0; i <= k; i++)
-    tGswTorus32PolynomialDecompH(deca + i * l, accum->a + i, params);
-  for (int32_t p = 0; p < kpl; p++)
-    IntPolynomial_ifft(decaFFT + p, deca + p);
-
-  tLweFFTClear(temp_fft1, tlwe_params);
-  for (int32_t i = 0; i < d; i++) {
+  for (int32_t i = first; i < d; i += step) {
 
     if (bara[i] == 0) {
       continue;
     }
 
+    const TGswSampleFFT *rotated =
+        rk ? tfhe_acquireRotatedKeyFFT(rk, gsw + i - rk->bkFFT, bara[i]) : 0;
+    if (rotated) {
+      // one product-sum with (X^bara-1)*gsw_i
+      for (int32_t p = 0; p < kpl; p++)
+        tLweFFTAddMulRTo(acc, decaFFT + p, rotated->all_samples + p,
+                         tlwe_params);
+      tfhe_releaseRotatedKeyFFT(rk, rotated);
+      continue;
+    }
+
     tLweFFTClear(temp_fft2, tlwe_params);
     for (int32_t p = 0; p < kpl; p++) {
       tLweFFTAddMulRTo(temp_fft2, decaFFT + p, (gsw + i)->all_samples + p,
                        tlwe_params);
     }
-    tLweFFTAddMulByXaiMinusOne(temp_fft1, bara[i], temp_fft2, tlwe_params);
+    if (ws->xaim1_table)
+      tLweFFTAddMulByXaiMinusOneTable(acc, bara[i], temp_fft2, tlwe_params,
+                                      ws->xaim1_table);
+    else
+      tLweFFTAddMulByXaiMinusOne(acc, bara[i], temp_fft2, tlwe_params,
+                                 ws->xaim1);
   }
+}
+
+// External product (*): accum = gsw (*) accum
+EXPORT void tGswFFTExternMulToTLweHoisting(TLweSample *accum,
+                                           const TGswSampleFFT *gsw,
+                                           const int32_t *bara, const int32_t d,
+                                           const TGswParams *params,
+                                           LweBootstrappingWorkspace *ws) {
+  const TLweParams *tlwe_params = params->tlwe_params;
+  const int32_t k = tlwe_params->k;
+  const int32_t l = params->l;
+  // all the scratch comes from the workspace
+  LagrangeHalfCPolynomial *decaFFT = ws->decaFFT; // decomposed accumulator
+  TLweSampleFFT *temp_fft1 = ws->tmpa;
+
+  for (int32_t i = 0; i <= k; i++)
+    tGswTorus32PolynomialDecompHFFT(decaFFT + i * l, accum->a + i, params);
+
+  tLweFFTClear(temp_fft1, tlwe_params);
+  tGswFFTExternMulHoistingShare(temp_fft1, gsw, bara, d, 0, 1, decaFFT, params,
+                                ws);
 
   tLweFromFFTConvert(accum, temp_fft1, tlwe_params);
+}
 
-  delete_TLweSampleFFT(temp_fft1);
-  delete_TLweSampleFFT(temp_fft2);
-  delete_LagrangeHalfCPolynomial_array(kpl, decaFFT);
-  delete_IntPolynomial_array(kpl, deca);
+// result = accum + gsw (*) accum, where the addition of accum is done in the
+// FFT domain: accum is recomposed from its decomposition, H.deca, which
+// spares the copy and the addition in the coefficient domain (up to the
+// rounding of the decomposition, 1/2Bg^l)
+EXPORT void tGswFFTExternMulToTLweHoistingAddTo(TLweSample *result,
+                                                const TLweSample *accum,
+                                                const TGswSampleFFT *gsw,
+                                                const int32_t *bara,
+                                                const int32_t d,
+                                                const TGswParams *params,
+                                                LweBootstrappingWorkspace *ws) {
+  const TLweParams *tlwe_params = params->tlwe_params;
+  const int32_t k = tlwe_params->k;
+  const int32_t l = params->l;
+  LagrangeHalfCPolynomial *decaFFT = ws->decaFFT;
+  TLweSampleFFT *temp_fft1 = ws->tmpa;
+
+  for (int32_t i = 0; i <= k; i++)
+    tGswTorus32PolynomialDecompHFFT(decaFFT + i * l, accum->a + i, params);
+
+  tLweFFTClear(temp_fft1, tlwe_params);
+  tGswFFTExternMulHoistingShare(temp_fft1, gsw, bara, d, 0, 1, decaFFT, params,
+                                ws);
+  // + H.deca
+  for (int32_t i = 0; i <= k; i++)
+    for (int32_t j = 0; j < l; j++)
+      LagrangeHalfCPolynomialAddMul(temp_fft1->a + i, decaFFT + i * l + j,
+                                    ws->gadget + j);
+
+  // temp_fft1 is scratch: the k+1 ffts can be done in place
+  TorusPolynomial_fft_batch(result->a, temp_fft1->a, k + 1);
+  result->current_variance = accum->current_variance;
 }
 
 // result = (X^ai-1)*bki
-// This function is not used, but may become handy in a future release
-//
+// (fills the cache of pre-rotated elements, see tfhe_acquireRotatedKeyFFT)
 EXPORT void tGswFFTMulByXaiMinusOne(TGswSampleFFT *result, const int32_t ai,
                                     const TGswSampleFFT *bki,
-                                    const TGswParams *params) {
+                                    const TGswParams *params,
+                                    LagrangeHalfCPolynomial *xaim1) {
   const TLweParams *tlwe_params = params->tlwe_params;
   const int32_t k = tlwe_params->k;
   // const int32_t l = params->l;
   const int32_t kpl = params->kpl;
-  const int32_t N = tlwe_params->N;
   // on calcule x^ai-1 en fft
-  // TODO attention, this prevents parallelization...
-  // TODO: parallelization
-  static LagrangeHalfCPolynomial *xaim1 = new_LagrangeHalfCPolynomial(N);
   LagrangeHalfCPolynomialSetXaiMinusOne(xaim1, ai);
   for (int32_t p = 0; p < kpl; p++) {
     const LagrangeHalfCPolynomial *in_s = bki->all_samples[p].a;
@@ -213,6 +213,36 @@ EXPORT void tGswSymEncryptInt(TGswSample *result, const int32_t message,
 }
 #endif
 
+#if defined INCLUDE_ALL || defined INCLUDE_TGSW_SYM_ENCRYPT_INT_SEEDED
+#undef INCLUDE_TGSW_SYM_ENCRYPT_INT_SEEDED
+EXPORT void tGswSymEncryptIntSeeded(TGswSample *result, const int32_t message,
+                                    double alpha, const TGswKey *key,
+                                    const TfheMaskSeed *seed, uint64_t row) {
+  const TGswParams *params = key->params;
+  const int32_t N = params->tlwe_params->N;
+  const int32_t k = params->tlwe_params->k;
+  const int32_t l = params->l;
+  const int32_t kpl = params->kpl;
+  const Torus32 *h = params->h;
+
+  for (int32_t p = 0; p < kpl; ++p)
+    tLweSymEncryptZeroSeeded(&result->all_sample[p], alpha, &key->tlwe_key,
+                             seed, row * kpl + p);
+  // compute result += H, with (a+mu.h_j, b) replaced by (a, b-mu.h_j.s_bloc)
+  for (int32_t bloc = 0; bloc < k; ++bloc) {
+    const int32_t *s = key->tlwe_key.key[bloc].coefs;
+    for (int32_t j = 0; j < l; j++) {
+      Torus32 *b = result->bloc_sample[bloc][j].b->coefsT;
+      const Torus32 muh = message * h[j];
+      for (int32_t c = 0; c < N; c++)
+        b[c] -= muh * s[c];
+    }
+  }
+  for (int32_t j = 0; j < l; j++)
+    result->bloc_sample[k][j].b->coefsT[0] += message * h[j];
+}
+#endif
+
 #if defined INCLUDE_ALL || defined INCLUDE_TGSW_ENCRYPT_B
 #undef INCLUDE_TGSW_ENCRYPT_B
 /**
@@ -321,7 +351,9 @@ EXPORT void tGswTorus32PolynomialDecompH(IntPolynomial *result,
   const int32_t N = params->tlwe_params->N;
   const int32_t l = params->l;
   const int32_t Bgbit = params->Bgbit;
-  uint32_t *buf = (uint32_t *)sample->coefsT;
+  // the sample is only read (the offset is added on the fly), so that
+  // several threads can decompose the same polynomial at once
+  const uint32_t *buf = (const uint32_t *)sample->coefsT;
 //#define __AVX2__ //(to test)
 #ifndef __AVX2__
   const uint32_t maskMod = params->maskMod;
@@ -331,40 +363,15 @@ EXPORT void tGswTorus32PolynomialDecompH(IntPolynomial *result,
   const uint32_t *maskMod_addr = &params->maskMod;
   const int32_t *halfBg_addr = &params->halfBg;
   const uint32_t *offset_addr = &params->offset;
-  // const uint32_t offset = params->offset;
-  // const uint32_t maskMod = params->maskMod;
-  // const int32_t halfBg = params->halfBg;
 #endif
 
-  // First, add offset to everyone
-#ifndef __AVX2__
-  for (int32_t j = 0; j < N; ++j)
-    buf[j] += offset;
-#else
-  {
-    const uint32_t *sit = buf;
-    const uint32_t *send = buf + N;
-    __asm__ __volatile__("vpbroadcastd (%2),%%ymm0\n"
-                         "0:\n"
-                         "vmovdqu (%0),%%ymm3\n"
-                         "vpaddd %%ymm0,%%ymm3,%%ymm3\n" // add offset
-                         "vmovdqu %%ymm3,(%0)\n"
-                         "addq $32,%0\n"
-                         "cmpq %1,%0\n"
-                         "jb 0b\n"
-                         : "=r"(sit), "=r"(send), "=r"(offset_addr)
-                         : "0"(sit), "1"(send), "2"(offset_addr)
-                         : "%ymm0", "%ymm3", "memory");
-  }
-#endif
-
-  // then, do the decomposition (in parallel)
+  // do the decomposition of sample+offset (in parallel)
   for (int32_t p = 0; p < l; ++p) {
     const int32_t decal = (32 - (p + 1) * Bgbit);
 #ifndef __AVX2__
     int32_t *res_p = result[p].coefs;
     for (int32_t j = 0; j < N; ++j) {
-      uint32_t temp1 = (buf[j] >> decal) & maskMod;
+      uint32_t temp1 = ((buf[j] + offset) >> decal) & maskMod;
       res_p[j] = temp1 - halfBg;
     }
 #else
@@ -375,8 +382,10 @@ EXPORT void tGswTorus32PolynomialDecompH(IntPolynomial *result,
     __asm__ __volatile__("vpbroadcastd (%4),%%ymm0\n"
                          "vpbroadcastd (%5),%%ymm1\n"
                          "vmovd (%3),%%xmm2\n"
+                         "vpbroadcastd (%6),%%ymm4\n"
                          "1:\n"
                          "vmovdqu (%1),%%ymm3\n"
+                         "vpaddd %%ymm4,%%ymm3,%%ymm3\n" // add offset
                          "VPSRLD %%xmm2,%%ymm3,%%ymm3\n" // shift by decal
                          "VPAND %%ymm1,%%ymm3,%%ymm3\n"  // and maskMod
                          "VPSUBD %%ymm0,%%ymm3,%%ymm3\n" // sub halfBg
@@ -386,46 +395,17 @@ EXPORT void tGswTorus32PolynomialDecompH(IntPolynomial *result,
                          "cmpq %2,%1\n"
                          "jb 1b\n"
                          : "=r"(dst), "=r"(sit), "=r"(send), "=r"(decal_addr),
-                           "=r"(halfBg_addr), "=r"(maskMod_addr)
+                           "=r"(halfBg_addr), "=r"(maskMod_addr),
+                           "=r"(offset_addr)
                          : "0"(dst), "1"(sit), "2"(send), "3"(decal_addr),
-                           "4"(halfBg_addr), "5"(maskMod_addr)
-                         : "%ymm0", "%ymm1", "%ymm2", "%ymm3", "memory");
-    /* // verify that the assembly block was ok
-    int32_t* res_p = result[p].coefs;
-    for (int32_t j = 0; j < N; ++j)
-    {
-        uint32_t temp1 = (buf[j] >> decal) & maskMod;
-        if (res_p[j] != int32_t(temp1 - halfBg)) {
-        fprintf(stderr,
-    "j=%d,buf[j]=%u,decal=%u,mask=%u,halfbg=%d,res_p[j]=%d\n",j,buf[j],decal,maskMod,halfBg,res_p[j]);
-        abort();
-        }
-    }*/
-
+                           "4"(halfBg_addr), "5"(maskMod_addr),
+                           "6"(offset_addr)
+                         : "%ymm0", "%ymm1", "%ymm2", "%ymm3", "%ymm4",
+                           "memory");
 #endif
   }
-
-  // finally, remove offset to everyone
-#ifndef __AVX2__
-  for (int32_t j = 0; j < N; ++j)
-    buf[j] -= offset;
-#else
-  {
-    const uint32_t *sit = buf;
-    const uint32_t *send = buf + N;
-    __asm__ __volatile__("vpbroadcastd (%2),%%ymm0\n"
-                         "2:\n"
-                         "vmovdqu (%0),%%ymm3\n"
-                         "vpsubd %%ymm0,%%ymm3,%%ymm3\n" // add offset
-                         "vmovdqu %%ymm3,(%0)\n"
-                         "addq $32,%0\n"
-                         "cmpq %1,%0\n"
-                         "jb 2b\n"
-                         "vzeroall\n"
-                         : "=r"(sit), "=r"(send), "=r"(offset_addr)
-                         : "0"(sit), "1"(send), "2"(offset_addr)
-                         : "%ymm0", "%ymm3", "memory");
-  }
+#ifdef __AVX2__
+  __asm__ __volatile__("vzeroupper\n");
 #endif
 }
 #endif
@@ -14,6 +14,7 @@
 #include "tgsw_functions.h"
 #include "tlwe_functions.h"
 #include <cassert>
+#include <cstdlib>
 #include <random>
 
 using namespace std;
@@ -40,7 +41,10 @@ EXPORT void init_TLweSampleFFT(TLweSampleFFT *obj, const TLweParams *params) {
 #undef INCLUDE_DESTROY_TLWESAMPLE_FFT
 EXPORT void destroy_TLweSampleFFT(TLweSampleFFT *obj) {
   const int32_t k = obj->k;
-  delete_LagrangeHalfCPolynomial_array(k + 1, obj->a);
+  if (obj->a_float32)
+    free(obj->a_float32);
+  else
+    delete_LagrangeHalfCPolynomial_array(k + 1, obj->a);
   obj->~TLweSampleFFT();
 }
 #endif
@@ -93,6 +97,13 @@ EXPORT void tLweFFTAddMulRTo(TLweSampleFFT *result,
                              const TLweParams *params) {
   const int32_t k = params->k;
 
+  if (sample->a_float32) {
+    const int32_t N = params->N;
+    for (int32_t i = 0; i <= k; i++)
+      LagrangeHalfCPolynomialAddMulFloat32(result->a + i, p,
+                                           sample->a_float32 + i * N);
+    return;
+  }
   for (int32_t i = 0; i <= k; i++)
     LagrangeHalfCPolynomialAddMul(result->a + i, p, sample->a + i);
   // result->current_variance += sample->current_variance;
@@ -100,13 +111,30 @@ EXPORT void tLweFFTAddMulRTo(TLweSampleFFT *result,
 }
 #endif
 
+#if defined INCLUDE_ALL || defined INCLUDE_TLWE_FFT_TO_FLOAT32
+#undef INCLUDE_TLWE_FFT_TO_FLOAT32
+// the k+1 polynomials are rounded to floats, and the doubles are released
+EXPORT void tLweFFTToFloat32(TLweSampleFFT *sample, const TLweParams *params) {
+  const int32_t k = params->k;
+  const int32_t N = params->N;
+  if (sample->a_float32)
+    return;
+  float *a_float32 = (float *)malloc((k + 1) * N * sizeof(float));
+  for (int32_t i = 0; i <= k; i++)
+    LagrangeHalfCPolynomial_toFloat32(a_float32 + i * N, sample->a + i);
+  delete_LagrangeHalfCPolynomial_array(k + 1, sample->a);
+  sample->a = 0;
+  sample->b = 0;
+  sample->a_float32 = a_float32;
+}
+#endif
+
 EXPORT void tLweFFTAddMulByXaiMinusOne(TLweSampleFFT *result, int32_t ai,
                                        const TLweSampleFFT *sample,
-                                       const TLweParams *params) {
+                                       const TLweParams *params,
+                                       LagrangeHalfCPolynomial *xaim1) {
   const int32_t k = params->k;
-  const int32_t N = params->N;
 
-  static LagrangeHalfCPolynomial *xaim1 = new_LagrangeHalfCPolynomial(N);
   LagrangeHalfCPolynomialSetXaiMinusOne(xaim1, ai);
 
   for (int32_t i = 0; i <= k; i++)
@@ -115,6 +143,17 @@ EXPORT void tLweFFTAddMulByXaiMinusOne(TLweSampleFFT *result, int32_t ai,
   // TODO: how to compute the variance correctly?
 }
 
+// same as above, but X^ai-1 is read from the precomputed table (no gather)
+EXPORT void tLweFFTAddMulByXaiMinusOneTable(
+    TLweSampleFFT *result, int32_t ai, const TLweSampleFFT *sample,
+    const TLweParams *params, const LagrangeHalfCPolynomial *xaim1_table) {
+  const int32_t k = params->k;
+  const LagrangeHalfCPolynomial *xaim1 = xaim1_table + ai;
+
+  for (int32_t i = 0; i <= k; i++)
+    LagrangeHalfCPolynomialAddMul(result->a + i, xaim1, sample->a + i);
+}
+
 EXPORT void tLweFFTAddTo(TLweSampleFFT *result, const TLweSampleFFT *sample,
                          const TLweParams *params) {
   const int32_t k = params->k;
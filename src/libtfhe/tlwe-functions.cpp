@@ -56,6 +56,23 @@ EXPORT void tLweSymEncryptZero(TLweSample *result, double alpha,
   result->current_variance = alpha * alpha;
 }
 
+EXPORT void tLweSymEncryptZeroSeeded(TLweSample *result, double alpha,
+                                     const TLweKey *key,
+                                     const TfheMaskSeed *seed, uint64_t row) {
+  const int32_t N = key->params->N;
+  const int32_t k = key->params->k;
+
+  for (int32_t j = 0; j < N; ++j)
+    result->b->coefsT[j] = gaussian32(0, alpha);
+
+  for (int32_t i = 0; i < k; ++i) {
+    tfhe_seededUniformTorus32(result->a[i].coefsT, N, seed, row * k + i);
+    torusPolynomialAddMulR(result->b, &key->key[i], &result->a[i]);
+  }
+
+  result->current_variance = alpha * alpha;
+}
+
 EXPORT void tLweSymEncrypt(TLweSample *result, TorusPolynomial *message,
                            double alpha, const TLweKey *key) {
   const int32_t N = key->params->N;
@@ -60,6 +60,7 @@ TLweSampleFFT::TLweSampleFFT(const TLweParams *params, LagrangeHalfCPolynomial *
     //a is a table of k+1 polynomials, b is an alias for &a[k]
     a = arr;
     b = a + k;
+    a_float32 = 0;
     current_variance = 0;
 }
 
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <numeric_functions.h>
+#include <vector>
 
 using namespace std;  
 
@@ -85,5 +86,66 @@ namespace {
 	}
     }
 
+    // the seeded masks are the ChaCha20 keystream of the seed: the all-zero
+    // key and nonce give the first test vector of Bernstein's reference
+    TEST_F (ArithmeticTest,seededUniformTorus32) {
+	static const uint32_t KEYSTREAM[8] = {
+	    0xade0b876, 0x903df1a0, 0xe56a5d40, 0x28bd8653,
+	    0xb819d2bd, 0x1aed8da0, 0xccef36a8, 0xc70d778b};
+	const TfheMaskSeed zero = TfheMaskSeed();
+	ASSERT_TRUE(tfhe_isNullMaskSeed(&zero));
+	Torus32 result[37];
+	tfhe_seededUniformTorus32(result, 37, &zero, 0);
+	for (int32_t i=0; i<8; i++) ASSERT_EQ(Torus32(KEYSTREAM[i]), result[i]);
+
+	// the expansion of a shorter row is a prefix, the other rows differ
+	const TfheMaskSeed seed = tfhe_newMaskSeed();
+	ASSERT_FALSE(tfhe_isNullMaskSeed(&seed));
+	Torus32 row1[37], prefix[21], row2[37];
+	tfhe_seededUniformTorus32(row1, 37, &seed, 1);
+	tfhe_seededUniformTorus32(prefix, 21, &seed, 1);
+	tfhe_seededUniformTorus32(row2, 37, &seed, 2);
+	for (int32_t i=0; i<21; i++) ASSERT_EQ(row1[i], prefix[i]);
+	int32_t nb_equal = 0;
+	for (int32_t i=0; i<37; i++) if (row1[i]==row2[i]) nb_equal++;
+	ASSERT_LE(nb_equal, 1);
+    }
+
+    // the key generation threads cover [0,nbelts[ exactly once, and their
+    // generators only depend on the state of the caller, not on the number
+    // of threads
+    TEST_F (ArithmeticTest,keyGenerationParallelFor) {
+	static const int32_t NB = 1000;
+	tfhe_setKeyGenerationThreads(4);
+	vector<int32_t> count(NB, 0);
+	tfhe_keyGenerationParallelFor(NB, false, [&](int32_t begin, int32_t end) {
+	    for (int32_t i=begin; i<end; i++) count[i]++;
+	});
+	for (int32_t i=0; i<NB; i++) ASSERT_EQ(1,count[i]);
+
+	vector<Torus32> draws1(NB), draws2(NB);
+	generator.seed(42);
+	tfhe_keyGenerationParallelFor(NB, true, [&](int32_t begin, int32_t end) {
+	    for (int32_t i=begin; i<end; i++) draws1[i] = uniformTorus32_distrib(generator);
+	});
+	generator.seed(42);
+	tfhe_keyGenerationParallelFor(NB, true, [&](int32_t begin, int32_t end) {
+	    for (int32_t i=begin; i<end; i++) draws2[i] = uniformTorus32_distrib(generator);
+	});
+	for (int32_t i=0; i<NB; i++) ASSERT_EQ(draws1[i],draws2[i]);
+	// the helpers do not replay the stream of the caller
+	ASSERT_NE(draws1[0],draws1[NB/2]);
+
+	for (int32_t nb_threads: {1, 3}) {
+	    tfhe_setKeyGenerationThreads(nb_threads);
+	    generator.seed(42);
+	    tfhe_keyGenerationParallelFor(NB, true, [&](int32_t begin, int32_t end) {
+		for (int32_t i=begin; i<end; i++) draws2[i] = uniformTorus32_distrib(generator);
+	    });
+	    for (int32_t i=0; i<NB; i++) ASSERT_EQ(draws1[i],draws2[i]);
+	}
+	tfhe_setKeyGenerationThreads(0);
+    }
+
 }  // namespace
 
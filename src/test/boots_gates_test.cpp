@@ -24,10 +24,20 @@ namespace {
         return new TFheGateBootstrappingSecretKeySet(params, bk, bkFFT, lwe_key, tgsw_key);
     }
 
+    /** same fake secret key, flagged for the sparse bootstrapping */
+    EXPORT TFheGateBootstrappingSecretKeySet *new_zero_sparse_keyset(const TFheGateBootstrappingParameterSet *params) {
+        LweKeySwitchKey *ks = (LweKeySwitchKey *) new FakeLweKeySwitchKey(1024, 15, 1);
+        LweBootstrappingKeyFFT *bkFFT = new LweBootstrappingKeyFFT(0, 0, 0, 0, 0, ks);
+        return new TFheGateBootstrappingSecretKeySet(params, 0x0, bkFFT, 0x0, 0x0, 1);
+    }
+
 
     const TFheGateBootstrappingParameterSet *params = new_default_gate_bootstrapping_parameters(100);
     const TFheGateBootstrappingSecretKeySet *SECRET_KEY = new_zero_keyset(params);
     const TFheGateBootstrappingCloudKeySet *CLOUD_KEY = &SECRET_KEY->cloud;
+    const TFheGateBootstrappingSecretKeySet *SPARSE_SECRET_KEY = new_zero_sparse_keyset(params);
+    const TFheGateBootstrappingCloudKeySet *SPARSE_CLOUD_KEY = &SPARSE_SECRET_KEY->cloud;
+    int32_t nb_sparse_bootstraps = 0; // number of calls to the sparse fakes
     const LweParams *LWE_PARAMS = 0x0;
     const Torus32 ENC_TRUE = modSwitchToTorus32(1, 8);
     const Torus32 ENC_FALSE = modSwitchToTorus32(-1, 8);
@@ -48,6 +58,25 @@ namespace {
         USE_FAKE_lweKeySwitch;
         USE_FAKE_tfhe_bootstrap_woKS_FFT;
         USE_FAKE_tfhe_bootstrap_FFT;
+        USE_FAKE_lweSparseKeySwitch;
+        USE_FAKE_tfhe_threadBootstrappingWorkspace;
+
+        // the sparse fakes also count the sparse bootstrappings
+        static inline void tfhe_sparseBootstrap_woKS_FFT(LweSample *result, const int32_t hw,
+                                                         const LweBootstrappingKeyFFT *bkFFT, Torus32 mu,
+                                                         const LweSample *x) {
+            ASSERT_EQ(hw, params->hw);
+            ++nb_sparse_bootstraps;
+            fake_tfhe_sparseBootstrap_woKS_FFT(result, hw, bkFFT, mu, x);
+        }
+
+        static inline void tfhe_sparseBootstrap_FFT(LweSample *result, const int32_t hw,
+                                                    const LweBootstrappingKeyFFT *bkFFT, Torus32 mu,
+                                                    const LweSample *x) {
+            ASSERT_EQ(hw, params->hw);
+            ++nb_sparse_bootstraps;
+            fake_tfhe_sparseBootstrap_FFT(result, hw, bkFFT, mu, x);
+        }
 
 #include "../libtfhe/boot-gates.cpp"
 
@@ -59,7 +88,8 @@ namespace {
         void binary_gate_test(
                 bool (*model_gate)(bool, bool), //the ideal gate
                 void (*boots_gate)(LweSample *, const LweSample *, const LweSample *,
-                                   const TFheGateBootstrappingCloudKeySet *)
+                                   const TFheGateBootstrappingCloudKeySet *),
+                const TFheGateBootstrappingCloudKeySet *cloud_key = CLOUD_KEY
         ) {
             LweSample *a = fake_new_LweSample(LWE_PARAMS);
             LweSample *b = fake_new_LweSample(LWE_PARAMS);
@@ -78,7 +108,7 @@ namespace {
                 fa->current_variance = 0.01;
                 fb->current_variance = 0.01;
 
-                boots_gate(c, a, b, CLOUD_KEY); //bootstrapped
+                boots_gate(c, a, b, cloud_key); //bootstrapped
                 bool bc = model_gate(ba, bb);  //model
 
                 ASSERT_EQ(fc->message, bc ? ENC_TRUE : ENC_FALSE);
@@ -124,7 +154,8 @@ namespace {
         void ternary_gate_test(
                 bool (*model_gate)(bool, bool, bool), //the ideal gate
                 void (*boots_gate)(LweSample *, const LweSample *, const LweSample *, const LweSample *,
-                                   const TFheGateBootstrappingCloudKeySet *)
+                                   const TFheGateBootstrappingCloudKeySet *),
+                const TFheGateBootstrappingCloudKeySet *cloud_key = CLOUD_KEY
         ) {
             LweSample *res = fake_new_LweSample(LWE_PARAMS);
             LweSample *a = fake_new_LweSample(LWE_PARAMS);
@@ -148,7 +179,7 @@ namespace {
                 fb->current_variance = 0.01;
                 fc->current_variance = 0.01;
 
-                boots_gate(res, a, b, c, CLOUD_KEY); //bootstrapped
+                boots_gate(res, a, b, c, cloud_key); //bootstrapped
                 bool bres = model_gate(ba, bb, bc);  //model
 
                 ASSERT_EQ(fres->message, bres ? ENC_TRUE : ENC_FALSE);
@@ -190,6 +221,10 @@ namespace {
 
     bool bool_mux(bool a, bool b, bool c) { return a ? b : c; }
 
+    bool bool_maj3(bool a, bool b, bool c) { return (a + b + c) >= 2; }
+
+    bool bool_xor3(bool a, bool b, bool c) { return a ^ b ^ c; }
+
     TEST_F(BootsGateTest, NandTest) { binary_gate_test(bool_nand, bootsNAND); }
 
     TEST_F(BootsGateTest, AndTest) { binary_gate_test(bool_and, bootsAND); }
@@ -215,4 +250,48 @@ namespace {
     TEST_F(BootsGateTest, CopyTest) { unary_gate_test(bool_copy, bootsCOPY); }
 
     TEST_F(BootsGateTest, MuxTest) { ternary_gate_test(bool_mux, bootsMUX); }
+
+    TEST_F(BootsGateTest, Maj3Test) { ternary_gate_test(bool_maj3, bootsMAJ3); }
+
+    TEST_F(BootsGateTest, Xor3Test) { ternary_gate_test(bool_xor3, bootsXOR3); }
+
+    TEST_F(BootsGateTest, DenseKeyDoesNotUseSparseBootstrapping) {
+        nb_sparse_bootstraps = 0;
+        binary_gate_test(bool_xor, bootsXOR);
+        ternary_gate_test(bool_mux, bootsMUX);
+        ASSERT_EQ(nb_sparse_bootstraps, 0);
+    }
+
+    TEST_F(BootsGateTest, SparseGatesTest) {
+        nb_sparse_bootstraps = 0;
+        binary_gate_test(bool_nand, bootsNAND, SPARSE_CLOUD_KEY);
+        binary_gate_test(bool_and, bootsAND, SPARSE_CLOUD_KEY);
+        binary_gate_test(bool_andny, bootsANDNY, SPARSE_CLOUD_KEY);
+        binary_gate_test(bool_andyn, bootsANDYN, SPARSE_CLOUD_KEY);
+        binary_gate_test(bool_nor, bootsNOR, SPARSE_CLOUD_KEY);
+        binary_gate_test(bool_or, bootsOR, SPARSE_CLOUD_KEY);
+        binary_gate_test(bool_orny, bootsORNY, SPARSE_CLOUD_KEY);
+        binary_gate_test(bool_oryn, bootsORYN, SPARSE_CLOUD_KEY);
+        binary_gate_test(bool_xor, bootsXOR, SPARSE_CLOUD_KEY);
+        binary_gate_test(bool_xnor, bootsXNOR, SPARSE_CLOUD_KEY);
+        // 10 gates x 4 inputs, one bootstrapping each
+        ASSERT_EQ(nb_sparse_bootstraps, 40);
+        binary_gate_test(bool_nand, bootsSparseNAND, CLOUD_KEY);
+        ASSERT_EQ(nb_sparse_bootstraps, 44);
+    }
+
+    TEST_F(BootsGateTest, SparseMuxTest) {
+        nb_sparse_bootstraps = 0;
+        ternary_gate_test(bool_mux, bootsMUX, SPARSE_CLOUD_KEY);
+        // 8 inputs, two bootstrappings each
+        ASSERT_EQ(nb_sparse_bootstraps, 16);
+    }
+
+    TEST_F(BootsGateTest, SparseTernaryGatesTest) {
+        nb_sparse_bootstraps = 0;
+        ternary_gate_test(bool_maj3, bootsMAJ3, SPARSE_CLOUD_KEY);
+        ternary_gate_test(bool_xor3, bootsXOR3, SPARSE_CLOUD_KEY);
+        // 2 gates x 8 inputs, a single bootstrapping each
+        ASSERT_EQ(nb_sparse_bootstraps, 16);
+    }
 }
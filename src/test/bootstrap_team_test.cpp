@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include "tfhe.h"
+
+using namespace std;
+
+namespace {
+
+    // each member writes its step number in its own slot, then checks after
+    // the barrier that all the other members reached the same step
+    struct BarrierJob {
+        TFheBootstrapTeam *team;
+        int32_t nb_steps;
+        atomic<int32_t> steps[TFHE_BOOTSTRAP_TEAM_MAX_THREADS];
+        atomic<int32_t> nb_errors;
+        atomic<int32_t> nb_calls;
+    };
+
+    void barrier_job(int32_t member, void *arg) {
+        BarrierJob *job = (BarrierJob *) arg;
+        const int32_t nb_threads = tfhe_bootstrapTeamNbThreads(job->team);
+        job->nb_calls++;
+        for (int32_t s = 1; s <= job->nb_steps; s++) {
+            job->steps[member] = s;
+            tfhe_bootstrapTeamBarrier(job->team);
+            for (int32_t j = 0; j < nb_threads; j++)
+                if (job->steps[j] != s) job->nb_errors++;
+            tfhe_bootstrapTeamBarrier(job->team);
+        }
+    }
+
+    TEST(BootstrapTeamTest, runAndBarrier) {
+        for (int32_t nb_threads: {1, 2, 3, 5}) {
+            TFheBootstrapTeam *team = new_bootstrap_team(nb_threads);
+            ASSERT_EQ(nb_threads, tfhe_bootstrapTeamNbThreads(team));
+            BarrierJob job;
+            job.team = team;
+            job.nb_steps = 50;
+            job.nb_errors = 0;
+            job.nb_calls = 0;
+            for (int32_t j = 0; j < nb_threads; j++) job.steps[j] = 0;
+            // the team is reused from one run to the next
+            for (int32_t run = 0; run < 3; run++)
+                tfhe_bootstrapTeamRun(team, barrier_job, &job);
+            ASSERT_EQ(3 * nb_threads, job.nb_calls);
+            ASSERT_EQ(0, job.nb_errors);
+            delete_bootstrap_team(team);
+        }
+    }
+
+}
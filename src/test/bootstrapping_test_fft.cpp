@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <thread>
 #include "tfhe.h"
 #include "fakes/tgsw.h"
 #include "fakes/tgsw-fft.h"
@@ -501,5 +502,101 @@ namespace {
     }
 
 
-}
+    // each thread has its own workspace, reused from one call to the next
+    TEST(LweBootstrappingWorkspaceTest, threadWorkspace) {
+        LweBootstrappingWorkspace *ws = tfhe_threadBootstrappingWorkspace(bk_params, n);
+        ASSERT_EQ(ws->N, N);
+        ASSERT_EQ(ws->k, k);
+        ASSERT_EQ(ws->l, l_bk);
+        ASSERT_EQ(ws, tfhe_threadBootstrappingWorkspace(bk_params, n));
+
+        LweBootstrappingWorkspace *other_ws = 0;
+        thread t([&other_ws] { other_ws = tfhe_threadBootstrappingWorkspace(bk_params, n); });
+        t.join();
+        ASSERT_NE(ws, other_ws);
+
+        // other dimensions: another workspace, and the first one is kept
+        TLweParams *accum_params512 = new_TLweParams(512, k, alpha_bk, 1. / 16.);
+        TGswParams *bk_params512 = new_TGswParams(l_bk, Bgbit_bk, accum_params512);
+        LweBootstrappingWorkspace *ws512 = tfhe_threadBootstrappingWorkspace(bk_params512, n);
+        ASSERT_EQ(ws512->N, 512);
+        ASSERT_NE(ws, ws512);
+        ASSERT_EQ(ws, tfhe_threadBootstrappingWorkspace(bk_params, n));
+        // and the same parameters with another pointer reuse it
+        TGswParams *bk_params_bis = new_TGswParams(l_bk, Bgbit_bk, accum_params512);
+        ASSERT_EQ(ws512, tfhe_threadBootstrappingWorkspace(bk_params_bis, n));
+        delete_TGswParams(bk_params_bis);
+        delete_TGswParams(bk_params512);
+        delete_TLweParams(accum_params512);
+    }
+
+    // the input buffers fit input samples larger than kN: a larger n gets
+    // another workspace, and the first one is kept
+    TEST(LweBootstrappingWorkspaceTest, largeInputs) {
+        TLweParams *accum_params256 = new_TLweParams(256, k, alpha_bk, 1. / 16.);
+        TGswParams *bk_params256 = new_TGswParams(l_bk, Bgbit_bk, accum_params256);
+        LweBootstrappingWorkspace *ws = tfhe_threadBootstrappingWorkspace(bk_params256, 100);
+        ASSERT_EQ(ws->nmax, 256 * k);
+        LweBootstrappingWorkspace *ws630 = tfhe_threadBootstrappingWorkspace(bk_params256, 630);
+        ASSERT_NE(ws, ws630);
+        ASSERT_EQ(ws630->nmax, 630);
+        for (int32_t i = 0; i < 4; i++) ws630->gate_temp[i]->a[629] = i;
+        ws630->bara[629] = 1;
+        ASSERT_EQ(ws630, tfhe_threadBootstrappingWorkspace(bk_params256, 630));
+        ASSERT_EQ(ws630, tfhe_threadBootstrappingWorkspace(bk_params256, 500));
+        ASSERT_EQ(ws, tfhe_threadBootstrappingWorkspace(bk_params256, 0));
+        tfhe_reserveBatchWorkspace(ws630, 2, accum_params256);
+        ws630->batch_bara[2 * 630 - 1] = 1;
+        delete_TGswParams(bk_params256);
+        delete_TLweParams(accum_params256);
+    }
 
+    // the batch buffers only grow, and are reused for smaller batches
+    TEST(LweBootstrappingWorkspaceTest, batchBuffers) {
+        LweBootstrappingWorkspace *ws = new_LweBootstrappingWorkspace(bk_params);
+        ASSERT_EQ(ws->batch_capacity, 0);
+        tfhe_reserveBatchWorkspace(ws, 8, bk_params->tlwe_params);
+        ASSERT_EQ(ws->batch_capacity, 8);
+        TLweSample *batch_acc = ws->batch_acc;
+        LweSample *batch_u = ws->batch_u;
+        tfhe_reserveBatchWorkspace(ws, 3, bk_params->tlwe_params);
+        tfhe_reserveBatchWorkspace(ws, 8, bk_params->tlwe_params);
+        ASSERT_EQ(ws->batch_capacity, 8);
+        ASSERT_EQ(ws->batch_acc, batch_acc);
+        ASSERT_EQ(ws->batch_u, batch_u);
+        tfhe_reserveBatchWorkspace(ws, 20, bk_params->tlwe_params);
+        ASSERT_EQ(ws->batch_capacity, 20);
+        delete_LweBootstrappingWorkspace(ws);
+    }
+
+    TEST(LweBootstrappingWorkspaceTest, xaiMinusOneTables) {
+        LweBootstrappingWorkspace *ws = tfhe_threadBootstrappingWorkspace(bk_params, n);
+        ASSERT_TRUE(ws->xaim1_table == 0);
+        tfhe_useXaiMinusOneTables(1);
+        ws = tfhe_threadBootstrappingWorkspace(bk_params, n);
+        ASSERT_EQ(ws->xaim1_table, tfhe_xaiMinusOneTable(N));
+        tfhe_useXaiMinusOneTables(0);
+        ws = tfhe_threadBootstrappingWorkspace(bk_params, n);
+        ASSERT_TRUE(ws->xaim1_table == 0);
+    }
+
+    // the coefficient j answers the phase j/2N: each message owns the phases
+    // within a half-box of it, and the negative phases of 0 come from -v
+    TEST(LutTestVectorTest, boxes) {
+        const int32_t msize = 4;
+        const Torus32 outputs[msize] = {11, 22, 33, 44};
+        const int32_t box = N / msize;
+        TorusPolynomial *testvect = new_TorusPolynomial(N);
+        tfhe_lutTestVector(testvect, outputs, msize);
+        for (int32_t m = 0; m < msize; m++) {
+            ASSERT_EQ(testvect->coefsT[m * box], outputs[m]);
+            ASSERT_EQ(testvect->coefsT[m * box + box / 2 - 1], outputs[m]);
+            if (m > 0) {
+                ASSERT_EQ(testvect->coefsT[m * box - box / 2], outputs[m]);
+            }
+        }
+        for (int32_t j = N - box / 2; j < N; j++) ASSERT_EQ(testvect->coefsT[j], -outputs[0]);
+        delete_TorusPolynomial(testvect);
+    }
+
+}
@@ -171,6 +171,26 @@ namespace {
     fake_TorusPolynomial_fft(result, p); \
     }
 
+    inline void fake_IntPolynomial_ifft_batch(LagrangeHalfCPolynomial *results, const IntPolynomial *p, const int32_t count) {
+        for (int32_t j = 0; j < count; j++)
+            fake_IntPolynomial_ifft(results + j, p + j);
+    }
+
+#define USE_FAKE_IntPolynomial_ifft_batch \
+    inline void IntPolynomial_ifft_batch(LagrangeHalfCPolynomial* results, const IntPolynomial* p, const int32_t count) { \
+    fake_IntPolynomial_ifft_batch(results, p, count); \
+    }
+
+    inline void fake_TorusPolynomial_fft_batch(TorusPolynomial *results, LagrangeHalfCPolynomial *p, const int32_t count) {
+        for (int32_t j = 0; j < count; j++)
+            fake_TorusPolynomial_fft(results + j, p + j);
+    }
+
+#define USE_FAKE_TorusPolynomial_fft_batch \
+    inline void TorusPolynomial_fft_batch(TorusPolynomial* results, LagrangeHalfCPolynomial* p, const int32_t count) { \
+    fake_TorusPolynomial_fft_batch(results, p, count); \
+    }
+
 //MISC OPERATIONS
 /** sets to zero */
     inline void fake_LagrangeHalfCPolynomialClear(LagrangeHalfCPolynomial *result) {
@@ -17,8 +17,11 @@ namespace {
         const LweParams *extract_params; ///< params after extraction: key: s'
         TGswSampleFFT *bkFFT; ///< the bootstrapping key FFT (s->s")
         LweKeySwitchKey *ks; ///< the keyswitch key (s'->s)
+        const LweRotatedKeyFFT *rotated; ///< no pre-rotated elements
+        int32_t recompose_accum; ///< exact additions of the accumulator
+        int32_t mapped; ///< not mapped
 
-        FakeLweBootstrappingKeyFFT(const FakeLweBootstrappingKey *fbk) {
+        FakeLweBootstrappingKeyFFT(const FakeLweBootstrappingKey *fbk) : rotated(0), recompose_accum(0), mapped(0) {
             this->in_out_params = fbk->in_out_params;
             this->bk_params = fbk->bk_params;
             this->accum_params = bk_params->tlwe_params;
@@ -231,6 +234,65 @@ inline void fake_tfhe_createLweBootstrappingKeyFFT(LweBootstrappingKeyFFT* bkFFT
     }
 
 
+// a real workspace, whose gate temporaries are fake samples
+    inline LweBootstrappingWorkspace *fake_tfhe_threadBootstrappingWorkspace(const TGswParams *bk_params, const int32_t n) {
+        thread_local LweBootstrappingWorkspace *ws = 0;
+        if (ws == 0) {
+            ws = new_LweBootstrappingWorkspace(bk_params);
+            assert(n <= ws->nmax);
+            for (int32_t i = 0; i < 4; i++) {
+                delete_LweSample(ws->gate_temp[i]);
+                ws->gate_temp[i] = fake_new_LweSample(0);
+            }
+        }
+        return ws;
+    }
+
+#define USE_FAKE_tfhe_threadBootstrappingWorkspace \
+    static inline LweBootstrappingWorkspace *tfhe_threadBootstrappingWorkspace(const TGswParams *bk_params, const int32_t n) {\
+    return fake_tfhe_threadBootstrappingWorkspace(bk_params, n); \
+    }
+
+/**
+ * result = LWE(mu) iff phase(x)>0, LWE(-mu) iff phase(x)<0 (sparse bootstrapping)
+ * @param result The resulting LweSample
+ * @param hw The number of blocks of the sparse key
+ * @param bk The bootstrapping + keyswitch key
+ * @param mu The output message (if phase(x)>0)
+ * @param x The input sample
+ */
+    inline void fake_tfhe_sparseBootstrap_woKS_FFT(LweSample *result, const int32_t hw,
+                                                   const LweBootstrappingKeyFFT *bkFFT,
+                                                   Torus32 mu, const LweSample *x) {
+        fake_tfhe_bootstrap_woKS_FFT(result, bkFFT, mu, x);
+    }
+
+#define USE_FAKE_tfhe_sparseBootstrap_woKS_FFT \
+    static inline void tfhe_sparseBootstrap_woKS_FFT(LweSample *result, const int32_t hw, const LweBootstrappingKeyFFT *bkFFT, Torus32 mu, const LweSample *x) {\
+    fake_tfhe_sparseBootstrap_woKS_FFT(result, hw, bkFFT, mu, x); \
+    }
+
+
+/**
+ * result = LWE(mu) iff phase(x)>0, LWE(-mu) iff phase(x)<0 (sparse bootstrapping)
+ * @param result The resulting LweSample
+ * @param hw The number of blocks of the sparse key
+ * @param bk The bootstrapping + keyswitch key
+ * @param mu The output message (if phase(x)>0)
+ * @param x The input sample
+ */
+    inline void fake_tfhe_sparseBootstrap_FFT(LweSample *result, const int32_t hw,
+                                              const LweBootstrappingKeyFFT *bkFFT,
+                                              Torus32 mu, const LweSample *x) {
+        fake_tfhe_bootstrap_FFT(result, bkFFT, mu, x);
+    }
+
+#define USE_FAKE_tfhe_sparseBootstrap_FFT \
+    static inline void tfhe_sparseBootstrap_FFT(LweSample *result, const int32_t hw, const LweBootstrappingKeyFFT *bkFFT, Torus32 mu, const LweSample *x) {\
+        fake_tfhe_sparseBootstrap_FFT(result, hw, bkFFT, mu, x); \
+    }
+
+
 /**
  * result = LWE(mu) iff phase(x)>0, LWE(-mu) iff phase(x)<0
  * @param result The resulting LweSample
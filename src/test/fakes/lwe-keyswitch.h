@@ -165,6 +165,16 @@ namespace {
     fake_lweKeySwitch(result, ks, sample); \
     }
 
+//sample=(a',b'), only the tail of a' is switched (the message and the noise are the same as lweKeySwitch)
+    inline void fake_lweSparseKeySwitch(LweSample *result, const LweKeySwitchKey *ks, const LweSample *sample) {
+        fake_lweKeySwitch(result, ks, sample);
+    }
+
+#define USE_FAKE_lweSparseKeySwitch \
+    static inline void lweSparseKeySwitch(LweSample *result, const LweKeySwitchKey *ks, const LweSample *sample) {\
+    fake_lweSparseKeySwitch(result, ks, sample); \
+    }
+
 
     inline LweKeySwitchKey *fake_new_LweKeySwitchKey(int32_t n, int32_t t, int32_t basebit, const LweParams *params) {
         FakeLweKeySwitchKey *ks = new FakeLweKeySwitchKey(n, t, basebit);
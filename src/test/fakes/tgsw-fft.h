@@ -207,15 +207,15 @@ namespace {
 
     // result = (X^ai -1)*bki  
     inline void fake_tGswFFTMulByXaiMinusOne(TGswSampleFFT *result, const int32_t ai, const TGswSampleFFT *bki,
-                                             const TGswParams *params) {
+                                             const TGswParams *params, LagrangeHalfCPolynomial *xaim1) {
         FakeTGswFFT *fres = fake(result);
         const FakeTGswFFT *fbki = fake(bki);
         intPolynomialMulByXaiMinusOne(fres->message, ai, fbki->message);
     }
 
 #define USE_FAKE_tGswFFTMulByXaiMinusOne \
-    inline void tGswFFTMulByXaiMinusOne(TGswSampleFFT* result, const int32_t ai, const TGswSampleFFT* bki, const TGswParams* params) { \
-    fake_tGswFFTMulByXaiMinusOne(result, ai, bki, params); \
+    inline void tGswFFTMulByXaiMinusOne(TGswSampleFFT* result, const int32_t ai, const TGswSampleFFT* bki, const TGswParams* params, LagrangeHalfCPolynomial* xaim1) { \
+    fake_tGswFFTMulByXaiMinusOne(result, ai, bki, params, xaim1); \
     }
 
 }
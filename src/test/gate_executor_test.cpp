@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include "tfhe.h"
+#include "lweparams.h"
+#include "lwesamples.h"
+
+using namespace std;
+
+namespace {
+
+    // The executor does not look inside the gates: these fake gates only
+    // combine the b coefficients, in a non-commutative way, so that any
+    // ordering mistake between dependent gates changes the final values.
+    void slow_down() { this_thread::sleep_for(chrono::microseconds(rand() % 200)); }
+
+    void fake_unary(LweSample *result, const LweSample *ca, const TFheGateBootstrappingCloudKeySet *bk) {
+        slow_down();
+        result->b = 5u * ca->b + 1u;
+    }
+
+    void fake_binary(LweSample *result, const LweSample *ca, const LweSample *cb,
+                     const TFheGateBootstrappingCloudKeySet *bk) {
+        slow_down();
+        result->b = 3u * ca->b - cb->b + 7u;
+    }
+
+    void fake_ternary(LweSample *result, const LweSample *ca, const LweSample *cb, const LweSample *cc,
+                      const TFheGateBootstrappingCloudKeySet *bk) {
+        slow_down();
+        result->b = (ca->b & 1) ? 2u * cb->b + 3u : cc->b - 11u;
+    }
+
+    const LweParams *params = new_LweParams(16, 0., 1.);
+
+    class GateExecutorTest : public ::testing::Test {
+    public:
+        static const int32_t nb_samples = 24;
+        LweSample *samples;
+        LweSample *expected;
+
+        void SetUp() {
+            samples = new_LweSample_array(nb_samples, params);
+            expected = new_LweSample_array(nb_samples, params);
+            for (int32_t i = 0; i < nb_samples; i++)
+                samples[i].b = expected[i].b = rand();
+        }
+
+        void TearDown() {
+            delete_LweSample_array(nb_samples, samples);
+            delete_LweSample_array(nb_samples, expected);
+        }
+
+        // submits a random gate to the executor, and evaluates it sequentially on expected
+        void random_gate(TFheGateExecutor *executor) {
+            int32_t r = rand() % nb_samples;
+            int32_t a = rand() % nb_samples;
+            int32_t b = rand() % nb_samples;
+            int32_t c = rand() % nb_samples;
+            switch (rand() % 3) {
+                case 0:
+                    tfhe_gateExecutorAddUnary(executor, fake_unary, samples + r, samples + a, 0);
+                    fake_unary(expected + r, expected + a, 0);
+                    break;
+                case 1:
+                    tfhe_gateExecutorAddBinary(executor, fake_binary, samples + r, samples + a, samples + b, 0);
+                    fake_binary(expected + r, expected + a, expected + b, 0);
+                    break;
+                default:
+                    tfhe_gateExecutorAddTernary(executor, fake_ternary, samples + r, samples + a, samples + b,
+                                                samples + c, 0);
+                    fake_ternary(expected + r, expected + a, expected + b, expected + c, 0);
+            }
+        }
+
+        void assert_all_equal() {
+            for (int32_t i = 0; i < nb_samples; i++)
+                ASSERT_EQ(expected[i].b, samples[i].b);
+        }
+    };
+
+    // random graphs with many read/write hazards (in-place gates, reused outputs)
+    TEST_F(GateExecutorTest, randomGraphs) {
+        for (int32_t nb_threads: {1, 2, 4, 8}) {
+            TFheGateExecutor *executor = new_gate_executor(nb_threads);
+            ASSERT_EQ(nb_threads, tfhe_gateExecutorNbThreads(executor));
+            for (int32_t trial = 0; trial < 3; trial++) {
+                for (int32_t i = 0; i < 200; i++)
+                    random_gate(executor);
+                tfhe_gateExecutorRun(executor);
+                assert_all_equal();
+            }
+            delete_gate_executor(executor);
+        }
+    }
+
+    // the NAND tree of test-gate-bootstrapping: the 12 leaves are the samples 12..23
+    TEST_F(GateExecutorTest, binaryTree) {
+        TFheGateExecutor *executor = new_gate_executor(0);
+        ASSERT_GE(tfhe_gateExecutorNbThreads(executor), 1);
+        for (int32_t i = nb_samples / 2 - 1; i > 0; --i) {
+            tfhe_gateExecutorAddBinary(executor, fake_binary, samples + i, samples + 2 * i, samples + 2 * i + 1, 0);
+            fake_binary(expected + i, expected + 2 * i, expected + 2 * i + 1, 0);
+        }
+        tfhe_gateExecutorRun(executor);
+        assert_all_equal();
+        // an empty run returns immediately
+        tfhe_gateExecutorRun(executor);
+        assert_all_equal();
+        delete_gate_executor(executor);
+    }
+
+}
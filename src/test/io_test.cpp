@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <tfhe.h>
+#include <cstring>
 #include <set>
 #include <tfhe_generic_streams.h>
 #include <tfhe_garbage_collector.h>
@@ -22,7 +23,8 @@ namespace {
     const set<const TGswParams*> allparams_tgsw = { tgswparams1024_1, tgswparams128_2};
 
     const TFheGateBootstrappingParameterSet* gbp1 = new TFheGateBootstrappingParameterSet(6,2,lweparams120,tgswparams128_2);
-    const set<const TFheGateBootstrappingParameterSet*> allgbp = { gbp1 };
+    const TFheGateBootstrappingParameterSet* gbp2 = new TFheGateBootstrappingParameterSet(6,2,40,lweparams120,tgswparams128_2);
+    const set<const TFheGateBootstrappingParameterSet*> allgbp = { gbp1, gbp2 };
 
     //generate a random lwekey
     LweKey* new_random_lwe_key(const LweParams* params) {
@@ -120,9 +122,10 @@ namespace {
     const set<const LweBootstrappingKey*> allbk = { bk1 };
 
     const TFheGateBootstrappingSecretKeySet* gbsk1 = new TFheGateBootstrappingSecretKeySet(gbp1, bk1, 0, lwekey120, tgswkey128_2 );
-    const set<const TFheGateBootstrappingSecretKeySet*> allgbsk = { gbsk1 };
+    const TFheGateBootstrappingSecretKeySet* gbsk2 = new TFheGateBootstrappingSecretKeySet(gbp2, bk1, 0, lwekey120, tgswkey128_2, 1);
+    const set<const TFheGateBootstrappingSecretKeySet*> allgbsk = { gbsk1, gbsk2 };
 
-    const set<const TFheGateBootstrappingCloudKeySet*> allgbck = { &gbsk1->cloud };
+    const set<const TFheGateBootstrappingCloudKeySet*> allgbck = { &gbsk1->cloud, &gbsk2->cloud };
 
 
     //equality test for parameters
@@ -277,12 +280,14 @@ namespace {
     void assert_equals(const TFheGateBootstrappingParameterSet* a, const TFheGateBootstrappingParameterSet* b) {
         ASSERT_EQ(a->ks_t,b->ks_t);
         ASSERT_EQ(a->ks_basebit,b->ks_basebit);
+        ASSERT_EQ(a->hw,b->hw);
         assert_equals(a->in_out_params, b->in_out_params);
         assert_equals(a->tgsw_params, b->tgsw_params);
     }
 
     //equality test for gb cloud key
     void assert_equals(const TFheGateBootstrappingCloudKeySet* a, const TFheGateBootstrappingCloudKeySet* b) {
+        ASSERT_EQ(a->sparse,b->sparse);
         assert_equals(a->params,b->params);
         assert_equals(a->bk,b->bk);
     }
@@ -467,6 +472,117 @@ namespace {
         }	
     }
 
+    TEST(IOTest, GateBootstrappingCiphertextArrayCompressedIO) {
+        const int32_t nbelems = 10;
+        const LweParams* params = gbp1->in_out_params;
+        int32_t messages[nbelems];
+        for (int32_t i=0; i<nbelems; i++) messages[i] = rand()%2;
+        TFheGateBootstrappingSeededCiphertextArray* samples = new_gate_bootstrapping_seeded_ciphertext_array(nbelems, gbp1);
+        LweSample* blah = new_gate_bootstrapping_ciphertext_array(nbelems, gbp1);
+        bootsSymEncryptSeeded(samples, messages, gbsk1);
+        ASSERT_FALSE(tfhe_isNullMaskSeed(&samples->seed));
+        ostringstream oss;
+        export_gate_bootstrapping_ciphertext_array_compressed_toStream(oss, samples, gbp1);
+        string result = oss.str();
+        //one seed and the b parts
+        ASSERT_LE(result.size(), 4*sizeof(int32_t) + sizeof(double) + sizeof(TfheMaskSeed) + nbelems*sizeof(Torus32));
+        istringstream iss(result);
+        import_gate_bootstrapping_ciphertext_array_compressed_fromStream(iss, blah, nbelems, gbp1);
+        for (int32_t i=0; i<nbelems; i++)
+            assert_equals(samples->samples+i, blah+i, params);
+        delete_gate_bootstrapping_ciphertext_array(nbelems, blah);
+        delete_gate_bootstrapping_seeded_ciphertext_array(samples);
+    }
+
+    TEST(IOTest, TFheGateBootstrappingCloudKeySetMappedIO) {
+        LweBootstrappingKey* bk = new_random_bk_key(gbp2->ks_t, gbp2->ks_basebit, lweparams120, tgswparams128_2);
+        LweBootstrappingKeyFFT* bkFFT = new_LweBootstrappingKeyFFT(bk);
+        tfhe_flattenKeySwitchKeyFFT(bkFFT);
+        const TFheGateBootstrappingCloudKeySet* gbck = new TFheGateBootstrappingCloudKeySet(gbp2, bk, bkFFT, 1);
+        char filename[] = "/tmp/tfhe_mapped_keyXXXXXX";
+        int fd = mkstemp(filename);
+        ASSERT_GE(fd, 0);
+        FILE* F = fdopen(fd, "wb");
+        export_tfheGateBootstrappingCloudKeySet_mapped_toFile(F, gbck);
+        fclose(F);
+        TFheGateBootstrappingCloudKeySet* gbck1 = new_tfheGateBootstrappingCloudKeySet_mapFile(filename);
+        remove(filename);
+        assert_equals(gbck->params, gbck1->params);
+        ASSERT_EQ(gbck->sparse, gbck1->sparse);
+        ASSERT_TRUE(gbck1->bk == 0x0);
+        //the FFT key is used as is
+        const TGswParams* bk_params = gbck1->bkFFT->bk_params;
+        const int32_t N = bk_params->tlwe_params->N;
+        const int32_t k = bk_params->tlwe_params->k;
+        for (int32_t i=0; i<lweparams120->n; i++)
+            for (int32_t p=0; p<bk_params->kpl; p++)
+                for (int32_t q=0; q<=k; q++) {
+                    const double* a = LagrangeHalfCPolynomial_coefs(bkFFT->bkFFT[i].all_samples[p].a+q);
+                    const double* b = LagrangeHalfCPolynomial_coefs(gbck1->bkFFT->bkFFT[i].all_samples[p].a+q);
+                    for (int32_t j=0; j<N; j++) ASSERT_EQ(a[j], b[j]);
+                }
+        //and so is the flattened keyswitch key
+        ASSERT_TRUE(gbck1->bkFFT->ks->ks_flat != 0x0);
+        assert_equals(bkFFT->ks, gbck1->bkFFT->ks);
+        //the mapped polynomials cannot be converted to single precision
+        ASSERT_TRUE(gbck1->bkFFT->mapped != 0);
+        ASSERT_DEATH(tfhe_bootstrappingKeyFFTToFloat32((LweBootstrappingKeyFFT*) gbck1->bkFFT), "mapped");
+        delete_mapped_gate_bootstrapping_cloud_keyset(gbck1);
+        delete gbck;
+        delete_LweBootstrappingKeyFFT(bkFFT);
+        delete_LweBootstrappingKey(bk);
+    }
+
+    //a file whose header points outside of it is rejected before any view is built
+    TEST(IOTest, TFheGateBootstrappingCloudKeySetMappedCorrupt) {
+        LweBootstrappingKey* bk = new_random_bk_key(gbp2->ks_t, gbp2->ks_basebit, lweparams120, tgswparams128_2);
+        LweBootstrappingKeyFFT* bkFFT = new_LweBootstrappingKeyFFT(bk);
+        tfhe_flattenKeySwitchKeyFFT(bkFFT);
+        const TFheGateBootstrappingCloudKeySet* gbck = new TFheGateBootstrappingCloudKeySet(gbp2, bk, bkFFT, 1);
+        char filename[] = "/tmp/tfhe_mapped_keyXXXXXX";
+        int fd = mkstemp(filename);
+        ASSERT_GE(fd, 0);
+        FILE* F = fdopen(fd, "wb");
+        export_tfheGateBootstrappingCloudKeySet_mapped_toFile(F, gbck);
+        fclose(F);
+        F = fopen(filename, "rb");
+        string file;
+        char buf[4096];
+        for (size_t len; (len = fread(buf, 1, sizeof(buf), F)) > 0;) file.append(buf, len);
+        fclose(F);
+        //the offsets of n, flat_stride, bk_offset and ks_offset in the version 1 header
+        const size_t n_pos = 48, flat_stride_pos = 68, bk_offset_pos = 120, ks_offset_pos = 128;
+        int32_t flat_stride;
+        int64_t ks_offset;
+        memcpy(&flat_stride, file.data() + flat_stride_pos, sizeof(flat_stride));
+        memcpy(&ks_offset, file.data() + ks_offset_pos, sizeof(ks_offset));
+        const vector<pair<size_t, int64_t>> corruptions = {
+                {n_pos, lweparams120->n + 1},         //the bootstrapping key overlaps the keyswitch key
+                {flat_stride_pos, flat_stride + 1},   //misaligned rows
+                {flat_stride_pos, 0},                 //rows shorter than n
+                {bk_offset_pos, 64},                  //inside the header
+                {bk_offset_pos, 4096 + 8},            //not on a page boundary
+                {ks_offset_pos, ks_offset + 4096},    //the keyswitch key past the end
+        };
+        for (const pair<size_t, int64_t>& c: corruptions) {
+            string corrupt = file;
+            if (c.first == bk_offset_pos || c.first == ks_offset_pos)
+                memcpy(&corrupt[c.first], &c.second, sizeof(int64_t));
+            else {
+                const int32_t v = int32_t(c.second);
+                memcpy(&corrupt[c.first], &v, sizeof(int32_t));
+            }
+            F = fopen(filename, "wb");
+            fwrite(corrupt.data(), 1, corrupt.size(), F);
+            fclose(F);
+            ASSERT_DEATH(new_tfheGateBootstrappingCloudKeySet_mapFile(filename), "Corrupt mapped cloud key");
+        }
+        remove(filename);
+        delete gbck;
+        delete_LweBootstrappingKeyFFT(bkFFT);
+        delete_LweBootstrappingKey(bk);
+    }
+
     TEST(IOTest, TFheGateBootstrappingParameterSetIO) {
         for (const TFheGateBootstrappingParameterSet* gbp: allgbp) {
             {
@@ -488,6 +604,7 @@ namespace {
            //we don't do anything with the FFT section
            LweBootstrappingKeyFFT* new_LweBootstrappingKeyFFT(const LweBootstrappingKey*) { return 0x0; }
            void delete_LweBootstrappingKeyFFT(LweBootstrappingKeyFFT*) {}
+           void tfhe_flattenKeySwitchKeyFFT(LweBootstrappingKeyFFT*) {}
 
 #define TFHE_TESTING_ENVIRONMENT
 #include "../libtfhe/tfhe_io.cpp"
@@ -507,6 +624,26 @@ namespace {
         }	
     }
 
+    TEST_F(IOTest2, TFheGateBootstrappingCloudKeySetCompressedIO) {
+        LweBootstrappingKey* bk = new_LweBootstrappingKey(6, 2, lweparams120, tgswparams128_2);
+        tfhe_createSeededLweBootstrappingKey(bk, lwekey120, tgswkey128_2);
+        const TFheGateBootstrappingSecretKeySet* gbsk = new TFheGateBootstrappingSecretKeySet(gbp1, bk, 0, lwekey120, tgswkey128_2);
+        ostringstream oss, oss_full;
+        export_tfheGateBootstrappingCloudKeySet_compressed_toStream(oss, &gbsk->cloud);
+        export_tfheGateBootstrappingCloudKeySet_toStream(oss_full, &gbsk->cloud);
+        string result = oss.str();
+        ASSERT_LT(2 * result.size(), oss_full.str().size());
+        istringstream iss(result);
+        TFheGateBootstrappingCloudKeySet* gbck1 = new_tfheGateBootstrappingCloudKeySet_fromStream(iss);
+        //the masks are expanded back to the same key
+        assert_equals(&gbsk->cloud, gbck1);
+        ASSERT_EQ(0, memcmp(&bk->seed, &gbck1->bk->seed, sizeof(TfheMaskSeed)));
+        ASSERT_EQ(0, memcmp(&bk->ks->seed, &gbck1->bk->ks->seed, sizeof(TfheMaskSeed)));
+        delete_gate_bootstrapping_cloud_keyset(gbck1);
+        delete gbsk;
+        delete_LweBootstrappingKey(bk);
+    }
+
     TEST_F(IOTest2, TFheGateBootstrappingSecretKeySetIO) {
         for (const TFheGateBootstrappingSecretKeySet* gbsk: allgbsk) {
             {
@@ -36,6 +36,83 @@ TEST(LagrangeHalfcTest, fftIsBijective) {
 }
 
 
+//EXPORT void IntPolynomial_ifft_batch(LagrangeHalfCPolynomial* results, const IntPolynomial* p, const int32_t count);
+//EXPORT void TorusPolynomial_fft_batch(TorusPolynomial* results, LagrangeHalfCPolynomial* p, const int32_t count);
+// the batches give the same results as the single transforms
+TEST(LagrangeHalfcTest, fftBatchIsFftOfEach) {
+    const int32_t N = 1024;
+    const int32_t count = 20; // more than one batch of the kernel
+    IntPolynomial *a = new_IntPolynomial_array(count, N);
+    TorusPolynomial *b = new_TorusPolynomial_array(count, N);
+    TorusPolynomial *bref = new_TorusPolynomial_array(count, N);
+    LagrangeHalfCPolynomial *afft = new_LagrangeHalfCPolynomial_array(count, N);
+    LagrangeHalfCPolynomial *areffft = new_LagrangeHalfCPolynomial(N);
+    for (int32_t j = 0; j < count; ++j)
+        for (int32_t i = 0; i < N; i++) a[j].coefs[i] = uniformTorus32_distrib(generator) % 1000 - 500;
+
+    IntPolynomial_ifft_batch(afft, a, count);
+    for (int32_t j = 0; j < count; ++j) {
+        IntPolynomial_ifft(areffft, a + j);
+        TorusPolynomial_fft(bref + j, areffft);
+        TorusPolynomial_fft(b + j, afft + j);
+        ASSERT_EQ(torusPolynomialNormInftyDist(b + j, bref + j), 0);
+    }
+    TorusPolynomial_fft_batch(b, afft, count);
+    for (int32_t j = 0; j < count; ++j)
+        ASSERT_EQ(torusPolynomialNormInftyDist(b + j, bref + j), 0);
+
+    delete_LagrangeHalfCPolynomial(areffft);
+    delete_LagrangeHalfCPolynomial_array(count, afft);
+    delete_TorusPolynomial_array(count, bref);
+    delete_TorusPolynomial_array(count, b);
+    delete_IntPolynomial_array(count, a);
+}
+
+//EXPORT void TorusPolynomial_decompH_ifft(LagrangeHalfCPolynomial* results, const TorusPolynomial* p, const int32_t l, const int32_t Bgbit, const uint32_t offset);
+// the fused kernel gives the ifft of the gadget decomposition
+TEST(LagrangeHalfcTest, decompHIfftIsIfftOfDecompH) {
+    const int32_t N = 1024;
+    const vector<pair<int32_t, int32_t>> decomps = {{3, 7}, {2, 10}, {4, 6}, {1, 16}};
+    TLweParams *tlwe_params = new_TLweParams(N, 1, 0., 1.);
+    TorusPolynomial *a = new_TorusPolynomial(N);
+    TorusPolynomial *acopy = new_TorusPolynomial(N);
+    TorusPolynomial *b = new_TorusPolynomial(N);
+    TorusPolynomial *bref = new_TorusPolynomial(N);
+    LagrangeHalfCPolynomial *areffft = new_LagrangeHalfCPolynomial(N);
+    for (const pair<int32_t, int32_t> &lBgbit: decomps) {
+        const int32_t l = lBgbit.first;
+        TGswParams *params = new_TGswParams(l, lBgbit.second, tlwe_params);
+        IntPolynomial *deca = new_IntPolynomial_array(l, N);
+        LagrangeHalfCPolynomial *decaFFT = new_LagrangeHalfCPolynomial_array(l, N);
+        torusPolynomialUniform(a);
+        torusPolynomialCopy(acopy, a);
+
+        TorusPolynomial_decompH_ifft(decaFFT, a, l, params->Bgbit, params->offset);
+        ASSERT_EQ(torusPolynomialNormInftyDist(a, acopy), 0);
+        tGswTorus32PolynomialDecompH(deca, a, params);
+        // both decompositions leave their input untouched (several threads
+        // may decompose the same polynomial)
+        ASSERT_EQ(torusPolynomialNormInftyDist(a, acopy), 0);
+        for (int32_t j = 0; j < l; ++j) {
+            IntPolynomial_ifft(areffft, deca + j);
+            TorusPolynomial_fft(bref, areffft);
+            TorusPolynomial_fft(b, decaFFT + j);
+            ASSERT_EQ(torusPolynomialNormInftyDist(b, bref), 0);
+        }
+
+        delete_LagrangeHalfCPolynomial_array(l, decaFFT);
+        delete_IntPolynomial_array(l, deca);
+        delete_TGswParams(params);
+    }
+    delete_LagrangeHalfCPolynomial(areffft);
+    delete_TorusPolynomial(bref);
+    delete_TorusPolynomial(b);
+    delete_TorusPolynomial(acopy);
+    delete_TorusPolynomial(a);
+    delete_TLweParams(tlwe_params);
+}
+
+
 //EXPORT void IntPolynomial_ifft(LagrangeHalfCPolynomial* result, const IntPolynomial* p);
 
 //MISC OPERATIONS
@@ -153,6 +230,114 @@ TEST(LagrangeHalfcTest, torusPolynomialMultFFT) {
     }
 }
 
+// the FFT processors are selected by N: mix the dimensions in the same thread
+TEST(LagrangeHalfcTest, torusPolynomialMultFFTAllDimensions) {
+    const int32_t NBTRIALS = 3;
+    const double toler = 1e-9;
+    const vector<int32_t> dimensions = {512, 1024, 2048, 64};
+    for (int32_t trials = 0; trials < NBTRIALS; ++trials) {
+        for (int32_t N: dimensions) {
+            IntPolynomial *a = new_IntPolynomial(N);
+            TorusPolynomial *b = new_TorusPolynomial(N);
+            TorusPolynomial *aB = new_TorusPolynomial(N);
+            TorusPolynomial *aBref = new_TorusPolynomial(N);
+            TorusPolynomial *c = new_TorusPolynomial(N);
+            LagrangeHalfCPolynomial *bfft = new_LagrangeHalfCPolynomial(N);
+
+            for (int32_t i = 0; i < N; i++) a->coefs[i] = uniformTorus32_distrib(generator) % 1000 - 500;
+            torusPolynomialUniform(b);
+            torusPolynomialMultKaratsuba(aBref, a, b);
+
+            torusPolynomialMultFFT(aB, a, b);
+            ASSERT_LE(torusPolynomialNormInftyDist(aB, aBref), toler);
+
+            TorusPolynomial_ifft(bfft, b);
+            TorusPolynomial_fft(c, bfft);
+            ASSERT_LE(torusPolynomialNormInftyDist(b, c), toler);
+
+            delete_LagrangeHalfCPolynomial(bfft);
+            delete_TorusPolynomial(c);
+            delete_TorusPolynomial(aBref);
+            delete_TorusPolynomial(aB);
+            delete_TorusPolynomial(b);
+            delete_IntPolynomial(a);
+        }
+    }
+}
+
+// the ntt processor computes exact products, even with 16-bit digits
+// accumulated over several products (the floating point ones do not)
+TEST(LagrangeHalfcTest, nttProductsAreExact) {
+    if (string(LagrangeHalfCPolynomial_layout()) != "ntt-crt") return;
+    const int32_t NBTRIALS = 3;
+    const int32_t NBPRODUCTS = 4;
+    // (the vectorized transforms need N >= 16, the smaller N are scalar)
+    for (int32_t N: {8, 16, 1024})
+    for (int32_t trials = 0; trials < NBTRIALS; ++trials) {
+        IntPolynomial *a = new_IntPolynomial(N);
+        TorusPolynomial *b = new_TorusPolynomial(N);
+        TorusPolynomial *aB = new_TorusPolynomial(N);
+        TorusPolynomial *aBref = new_TorusPolynomial(N);
+        LagrangeHalfCPolynomial *tmp = new_LagrangeHalfCPolynomial_array(3, N);
+
+        torusPolynomialClear(aBref);
+        LagrangeHalfCPolynomialClear(tmp + 2);
+        for (int32_t j = 0; j < NBPRODUCTS; j++) {
+            for (int32_t i = 0; i < N; i++) a->coefs[i] = uniformTorus32_distrib(generator) % (1 << 16);
+            torusPolynomialUniform(b);
+            torusPolynomialAddMulRKaratsuba(aBref, a, b);
+            IntPolynomial_ifft(tmp + 0, a);
+            TorusPolynomial_ifft(tmp + 1, b);
+            LagrangeHalfCPolynomialAddMul(tmp + 2, tmp + 0, tmp + 1);
+        }
+        TorusPolynomial_fft(aB, tmp + 2);
+        for (int32_t i = 0; i < N; i++) ASSERT_EQ(aBref->coefsT[i], aB->coefsT[i]);
+
+        delete_LagrangeHalfCPolynomial_array(3, tmp);
+        delete_TorusPolynomial(aBref);
+        delete_TorusPolynomial(aB);
+        delete_TorusPolynomial(b);
+        delete_IntPolynomial(a);
+    }
+}
+
+// the key side of the product rounded to single precision, as in the float32
+// bootstrapping keys (digits of a decomposition with Bg = 1024)
+TEST(LagrangeHalfcTest, LagrangeHalfCPolynomialAddMulFloat32) {
+    if (string(LagrangeHalfCPolynomial_layout()) == "ntt-crt") return;
+    const int32_t NBTRIALS = 10;
+    const double toler = 2e-3;
+    const int32_t N = 1024;
+    for (int32_t trials = 0; trials < NBTRIALS; ++trials) {
+        IntPolynomial *a = new_IntPolynomial(N);
+        TorusPolynomial *b = new_TorusPolynomial(N);
+        TorusPolynomial *aB = new_TorusPolynomial(N);
+        TorusPolynomial *aBref = new_TorusPolynomial(N);
+        LagrangeHalfCPolynomial *tmp = new_LagrangeHalfCPolynomial_array(3, N);
+        float *b32 = new float[N];
+
+        for (int32_t i = 0; i < N; i++) a->coefs[i] = uniformTorus32_distrib(generator) % 1024 - 512;
+        torusPolynomialUniform(b);
+        torusPolynomialClear(aBref);
+        torusPolynomialAddMulRKaratsuba(aBref, a, b);
+
+        IntPolynomial_ifft(tmp + 0, a);
+        TorusPolynomial_ifft(tmp + 1, b);
+        LagrangeHalfCPolynomial_toFloat32(b32, tmp + 1);
+        LagrangeHalfCPolynomialClear(tmp + 2);
+        LagrangeHalfCPolynomialAddMulFloat32(tmp + 2, tmp + 0, b32);
+        TorusPolynomial_fft(aB, tmp + 2);
+        ASSERT_LE(torusPolynomialNormInftyDist(aB, aBref), toler);
+
+        delete[] b32;
+        delete_LagrangeHalfCPolynomial_array(3, tmp);
+        delete_TorusPolynomial(aBref);
+        delete_TorusPolynomial(aB);
+        delete_TorusPolynomial(b);
+        delete_IntPolynomial(a);
+    }
+}
+
 EXPORT void
 torusPolynomialAddMulRFFT(TorusPolynomial *result, const IntPolynomial *poly1, const TorusPolynomial *poly2);
 
@@ -274,3 +459,23 @@ TEST(LagrangeHalfcTest, LagrangeHalfCPolynomialAddTo) {
 //	LagrangeHalfCPolynomial* accum, 
 //	const LagrangeHalfCPolynomial* a, 
 //	const LagrangeHalfCPolynomial* b);
+
+/** table of all the X^a-1 */
+//EXPORT const LagrangeHalfCPolynomial* tfhe_xaiMinusOneTable(const int32_t N);
+TEST(LagrangeHalfcTest, xaiMinusOneTable) {
+    const int32_t N = 1024;
+    const LagrangeHalfCPolynomial *table = tfhe_xaiMinusOneTable(N);
+    ASSERT_EQ(table, tfhe_xaiMinusOneTable(N));
+    TorusPolynomial *a = new_TorusPolynomial(N);
+    TorusPolynomial *b = new_TorusPolynomial(N);
+    LagrangeHalfCPolynomial *xaim1 = new_LagrangeHalfCPolynomial(N);
+    for (int32_t ai = 0; ai < 2 * N; ++ai) {
+        LagrangeHalfCPolynomialSetXaiMinusOne(xaim1, ai);
+        TorusPolynomial_fft(a, xaim1);
+        TorusPolynomial_fft(b, table + ai);
+        ASSERT_EQ(torusPolynomialNormInftyDist(a, b), 0);
+    }
+    delete_LagrangeHalfCPolynomial(xaim1);
+    delete_TorusPolynomial(b);
+    delete_TorusPolynomial(a);
+}
@@ -150,4 +150,113 @@ namespace {
         delete_LweSample(res);
         delete_LweKeySwitchKey(test);
     }
+
+    /**
+     * the flattened key must give exactly the same keyswitches
+     */
+    //EXPORT void lweFlattenKeySwitchKey(LweKeySwitchKey* ks);
+    TEST_F(LweKeySwitchTest, lweFlattenKeySwitchKey) {
+        const LweParams *out_params = new_LweParams(250, 0., 1.);
+        const LweParams *in_params = new_LweParams(600, 0., 1.);
+        LweKeySwitchKey *test = new_LweKeySwitchKey(600, 5, 2, out_params);
+        const int32_t nb_elts = test->n * test->t * test->base;
+        for (int32_t p = 0; p < nb_elts; p++) {
+            LweSample *s = test->ks0_raw + p;
+            for (int32_t i = 0; i < out_params->n; i++) s->a[i] = uniformTorus32_distrib(generator);
+            s->b = uniformTorus32_distrib(generator);
+            s->current_variance = p * 1e-9;
+        }
+        LweSample *in = new_LweSample(in_params);
+        LweSample *res = new_LweSample(out_params);
+        LweSample *res_flat = new_LweSample(out_params);
+        LweSample *res_sparse = new_LweSample(out_params);
+        LweSample *res_sparse_flat = new_LweSample(out_params);
+
+        for (int32_t trial = 0; trial < 10; trial++) {
+            for (int32_t i = 0; i < in_params->n; i++) in->a[i] = uniformTorus32_distrib(generator);
+            in->b = uniformTorus32_distrib(generator);
+            if (trial == 0) {
+                lweKeySwitch(res, test, in);
+                lweSparseKeySwitch(res_sparse, test, in);
+                lweFlattenKeySwitchKey(test);
+                ASSERT_TRUE(test->ks_flat != 0);
+                ASSERT_EQ(test->flat_stride, 256);
+                ASSERT_EQ(uint64_t(test->ks_flat) % 64, 0u);
+            } else {
+                // the key is flattened: go through the original elements
+                lweNoiselessTrivial(res, in->b, out_params);
+                lweKeySwitchTranslate_fromArray(res, (const LweSample ***) test->ks, out_params, in->a,
+                                                test->n, test->t, test->basebit);
+                lweCopy(res_sparse, in, out_params);
+                lweSparseKeySwitchTranslate_fromArray(res_sparse, (const LweSample ***) test->ks, out_params,
+                                                      in->a, test->n, test->t, test->basebit);
+            }
+            lweKeySwitch(res_flat, test, in);
+            lweSparseKeySwitch(res_sparse_flat, test, in);
+            ASSERT_EQ(res_flat->b, res->b);
+            ASSERT_EQ(res_flat->current_variance, res->current_variance);
+            ASSERT_EQ(res_sparse_flat->b, res_sparse->b);
+            ASSERT_EQ(res_sparse_flat->current_variance, res_sparse->current_variance);
+            for (int32_t i = 0; i < out_params->n; i++) {
+                ASSERT_EQ(res_flat->a[i], res->a[i]);
+                ASSERT_EQ(res_sparse_flat->a[i], res_sparse->a[i]);
+            }
+        }
+
+        delete_LweSample(res_sparse_flat);
+        delete_LweSample(res_sparse);
+        delete_LweSample(res_flat);
+        delete_LweSample(res);
+        delete_LweSample(in);
+        delete_LweKeySwitchKey(test);
+        delete_LweParams((LweParams *) in_params);
+        delete_LweParams((LweParams *) out_params);
+    }
+
+    /**
+     * the batched sparse keyswitch gives exactly the keyswitches of the samples
+     */
+    //EXPORT void lweSparseKeySwitchBatch(LweSample *results, const LweKeySwitchKey *ks, const LweSample *samples, const int32_t nbSamples);
+    TEST_F(LweKeySwitchTest, lweSparseKeySwitchBatch) {
+        const int32_t nb_samples = 70; // more than one batch of the flat key
+        const LweParams *out_params = new_LweParams(250, 0., 1.);
+        const LweParams *in_params = new_LweParams(600, 0., 1.);
+        LweKeySwitchKey *test = new_LweKeySwitchKey(600, 5, 2, out_params);
+        const int32_t nb_elts = test->n * test->t * test->base;
+        for (int32_t p = 0; p < nb_elts; p++) {
+            LweSample *s = test->ks0_raw + p;
+            for (int32_t i = 0; i < out_params->n; i++) s->a[i] = uniformTorus32_distrib(generator);
+            s->b = uniformTorus32_distrib(generator);
+            s->current_variance = p * 1e-9;
+        }
+        LweSample *in = new_LweSample_array(nb_samples, in_params);
+        LweSample *res = new_LweSample_array(nb_samples, out_params);
+        LweSample *res_batch = new_LweSample_array(nb_samples, out_params);
+        for (int32_t s = 0; s < nb_samples; s++) {
+            for (int32_t i = 0; i < in_params->n; i++) in[s].a[i] = uniformTorus32_distrib(generator);
+            in[s].b = uniformTorus32_distrib(generator);
+        }
+        // the carries of the signed digits: -1 propagates to all the digits
+        for (int32_t i = 0; i < in_params->n; i++) in[0].a[i] = -1;
+
+        for (int32_t flat = 0; flat < 2; flat++) {
+            if (flat) lweFlattenKeySwitchKey(test);
+            for (int32_t s = 0; s < nb_samples; s++)
+                lweSparseKeySwitch(res + s, test, in + s);
+            lweSparseKeySwitchBatch(res_batch, test, in, nb_samples);
+            for (int32_t s = 0; s < nb_samples; s++) {
+                ASSERT_EQ(res_batch[s].b, res[s].b);
+                ASSERT_EQ(res_batch[s].current_variance, res[s].current_variance);
+                for (int32_t i = 0; i < out_params->n; i++)
+                    ASSERT_EQ(res_batch[s].a[i], res[s].a[i]);
+            }
+        }
+
+        delete_LweSample_array(nb_samples, res_batch);
+        delete_LweSample_array(nb_samples, res);
+        delete_LweSample_array(nb_samples, in);
+        delete_LweKeySwitchKey(test);
+        delete_LweParams((LweParams *) in_params);
+        delete_LweParams((LweParams *) out_params);
+    }
 }
@@ -138,6 +138,190 @@ int32_t main(int32_t argc, char **argv) {
   cout << "time per sparse bootstrapping (microsecs)... "
        << (end - begin) / double(nb_samples) << endl;
 
+  // batched sparse bootstrapping of the same input samples
+  LweSample *test_out_batch = new_LweSample_array(nb_samples, in_out_params);
+  cout << "starting batched sparse bootstrapping..." << endl;
+  begin = clock();
+  tfhe_sparseBatchBootstrap_FFT(test_out_batch, keyset->params->hw,
+                                keyset->cloud.bkFFT, mu_boot, test_in,
+                                nb_samples);
+  end = clock();
+  cout << "finished " << nb_samples << " batched sparse bootstrappings"
+       << endl;
+  cout << "time per batched sparse bootstrapping (microsecs)... "
+       << (end - begin) / double(nb_samples) << endl;
+
+  // the batch must give exactly the same samples
+  for (int32_t i = 0; i < nb_samples; ++i) {
+    if (test_out_batch[i].b != test_out[i].b)
+      dieDramatically("batched sparse bootstrapping differs");
+    for (int32_t j = 0; j < in_out_params->n; ++j)
+      if (test_out_batch[i].a[j] != test_out[i].a[j])
+        dieDramatically("batched sparse bootstrapping differs");
+  }
+
+  // same bootstrappings, with the precomputed X^a-1 tables
+  tfhe_xaiMinusOneTable(keyset->params->tgsw_params->tlwe_params->N);
+  tfhe_useXaiMinusOneTables(1);
+  cout << "starting sparse bootstrapping with X^a-1 tables..." << endl;
+  begin = clock();
+  for (int32_t i = 0; i < nb_samples; ++i) {
+    tfhe_sparseBootstrap_FFT(test_out_batch + i, keyset->params->hw,
+                             keyset->cloud.bkFFT, mu_boot, test_in + i);
+  }
+  end = clock();
+  tfhe_useXaiMinusOneTables(0);
+  cout << "finished " << nb_samples
+       << " sparse bootstrappings with X^a-1 tables" << endl;
+  cout << "time per sparse bootstrapping (microsecs)... "
+       << (end - begin) / double(nb_samples) << endl;
+
+  // the table holds exactly the same polynomials
+  for (int32_t i = 0; i < nb_samples; ++i) {
+    if (test_out_batch[i].b != test_out[i].b)
+      dieDramatically("sparse bootstrapping with X^a-1 tables differs");
+    for (int32_t j = 0; j < in_out_params->n; ++j)
+      if (test_out_batch[i].a[j] != test_out[i].a[j])
+        dieDramatically("sparse bootstrapping with X^a-1 tables differs");
+  }
+
+  // the same input bootstrapped again, with a cache of pre-rotated elements
+  // large enough for its n pairs: the first bootstrapping meets the pairs,
+  // the second one admits them, and the next ones hit them
+  LweBootstrappingKeyFFT *bkFFT = (LweBootstrappingKeyFFT *)keyset->cloud.bkFFT;
+  const int32_t d = in_out_params->n / keyset->params->hw;
+  const TLweParams *accum_params = bkFFT->accum_params;
+  const int64_t entry_bytes = int64_t(bkFFT->bk_params->kpl) *
+                              (accum_params->k + 1) * accum_params->N *
+                              sizeof(double);
+  LweRotatedKeyFFT *rotated =
+      new_LweRotatedKeyFFT(bkFFT, in_out_params->n * entry_bytes);
+  if (rotated->capacity != in_out_params->n)
+    dieDramatically("wrong capacity of the pre-rotated key");
+  tfhe_setRotatedKeyFFT(bkFFT, rotated);
+  static const int32_t nb_repeats = 10;
+  cout << "starting " << nb_repeats
+       << " sparse bootstrappings of one input with a pre-rotated key cache..."
+       << endl;
+  begin = clock();
+  for (int32_t i = 0; i < nb_repeats; ++i) {
+    tfhe_sparseBootstrap_FFT(test_out_batch + i, keyset->params->hw, bkFFT,
+                             mu_boot, test_in);
+  }
+  end = clock();
+  tfhe_setRotatedKeyFFT(bkFFT, 0);
+  int64_t nb_hits, nb_misses;
+  tfhe_rotatedKeyFFTStats(rotated, &nb_hits, &nb_misses);
+  delete_LweRotatedKeyFFT(rotated);
+  cout << "finished " << nb_repeats
+       << " sparse bootstrappings with a pre-rotated key cache" << endl;
+  cout << "time per sparse bootstrapping (microsecs)... "
+       << (end - begin) / double(nb_repeats) << endl;
+  cout << "hits of the cache: " << nb_hits << " out of "
+       << nb_hits + nb_misses << endl;
+  if (nb_hits == 0)
+    dieDramatically("the pre-rotated key cache is never hit");
+
+  // the products are associated differently, so the rounding errors change
+  // the decompositions and the samples: only their phases must be close
+  for (int32_t i = 0; i < nb_repeats; ++i) {
+    const Torus32 phase = lwePhase(test_out, keyset->lwe_key);
+    const Torus32 phase_rotated = lwePhase(test_out_batch + i, keyset->lwe_key);
+    if (abs(int32_t(phase_rotated - phase)) > (1 << 28))
+      dieDramatically("sparse bootstrapping with pre-rotated key differs");
+  }
+
+  // same bootstrappings, each one shared by a team of threads (the team
+  // threads all use the cpu, so the latency is measured on the wall clock)
+  TFheBootstrapTeam *team = new_bootstrap_team(2);
+  tfhe_useBootstrapTeam(team);
+  cout << "starting sparse bootstrapping with a team of "
+       << tfhe_bootstrapTeamNbThreads(team) << " threads..." << endl;
+  timeval wall_begin, wall_end;
+  gettimeofday(&wall_begin, 0);
+  for (int32_t i = 0; i < nb_samples; ++i) {
+    tfhe_sparseBootstrap_FFT(test_out_batch + i, keyset->params->hw, bkFFT,
+                             mu_boot, test_in + i);
+  }
+  gettimeofday(&wall_end, 0);
+  tfhe_useBootstrapTeam(0);
+  delete_bootstrap_team(team);
+  cout << "finished " << nb_samples << " sparse bootstrappings with a team"
+       << endl;
+  cout << "wall time per sparse bootstrapping (microsecs)... "
+       << ((wall_end.tv_sec - wall_begin.tv_sec) * 1e6 +
+           (wall_end.tv_usec - wall_begin.tv_usec)) /
+              double(nb_samples)
+       << endl;
+
+  // the products are summed in a different order
+  for (int32_t i = 0; i < nb_samples; ++i) {
+    const Torus32 phase = lwePhase(test_out + i, keyset->lwe_key);
+    const Torus32 phase_team = lwePhase(test_out_batch + i, keyset->lwe_key);
+    if (abs(int32_t(phase_team - phase)) > (1 << 28))
+      dieDramatically("sparse bootstrapping with a team differs");
+  }
+
+  // opt-in: the accumulator is added back in the FFT domain, recomposed
+  // from its decomposition. Its rounding adds noise, so the signs are
+  // checked on fresh gate inputs
+  LweSample *gate_in = new_LweSample_array(nb_samples, in_out_params);
+  int32_t *bits = new int32_t[nb_samples];
+  for (int32_t i = 0; i < nb_samples; ++i) {
+    bits[i] = rand() % 2;
+    bootsSymEncrypt(gate_in + i, bits[i], keyset);
+  }
+  tfhe_setAccumRecompositionFFT(bkFFT, 1);
+  cout << "starting sparse bootstrapping with the accumulator recomposed "
+          "in the FFT domain..."
+       << endl;
+  begin = clock();
+  for (int32_t i = 0; i < nb_samples; ++i) {
+    tfhe_sparseBootstrap_FFT(test_out_batch + i, keyset->params->hw, bkFFT,
+                             mu_boot, gate_in + i);
+  }
+  end = clock();
+  tfhe_setAccumRecompositionFFT(bkFFT, 0);
+  cout << "time per sparse bootstrapping (microsecs)... "
+       << (end - begin) / double(nb_samples) << endl;
+  for (int32_t i = 0; i < nb_samples; ++i)
+    if (bootsSymDecrypt(test_out_batch + i, keyset) != bits[i])
+      dieDramatically("wrong sparse bootstrapping with the FFT recomposition");
+  delete[] bits;
+  delete_LweSample_array(nb_samples, gate_in);
+
+  // blocks without rotation are skipped: zero the mask of the first
+  // nb_zero_blocks blocks of each input, keeping the same phase
+  const int32_t nb_zero_blocks = 10;
+  for (int32_t i = 0; i < nb_samples; ++i) {
+    for (int32_t j = 0; j < nb_zero_blocks * d; ++j) {
+      test_in[i].b -= test_in[i].a[j] * keyset->lwe_key->key[j];
+      test_in[i].a[j] = 0;
+    }
+  }
+  TFheSparseRotateStats stats;
+  tfhe_resetSparseRotateStats();
+  for (int32_t i = 0; i < nb_samples; ++i) {
+    tfhe_sparseBootstrap_FFT(test_out_batch + i, keyset->params->hw, bkFFT,
+                             mu_boot, test_in + i);
+  }
+  tfhe_sparseRotateStats(&stats);
+  cout << "skipped " << stats.nb_skipped_blocks << " blocks out of "
+       << stats.nb_blocks << ", " << stats.nb_skipped_entries
+       << " entries out of " << stats.nb_entries << endl;
+  if (stats.nb_blocks != nb_samples * keyset->params->hw ||
+      stats.nb_entries != stats.nb_blocks * d ||
+      stats.nb_skipped_blocks < nb_samples * nb_zero_blocks ||
+      stats.nb_skipped_entries < stats.nb_skipped_blocks * d)
+    dieDramatically("wrong sparse blind rotation statistics");
+  for (int32_t i = 0; i < nb_samples; ++i) {
+    const Torus32 phase = lwePhase(test_out + i, keyset->lwe_key);
+    const Torus32 phase_skip = lwePhase(test_out_batch + i, keyset->lwe_key);
+    if (abs(int32_t(phase_skip - phase)) > (1 << 28))
+      dieDramatically("sparse bootstrapping with skipped blocks differs");
+  }
+  delete_LweSample_array(nb_samples, test_out_batch);
+
   delete_LweSample_array(nb_samples, test_in);
 
   /** sparse keyswitch **/
@@ -159,6 +343,24 @@ int32_t main(int32_t argc, char **argv) {
   cout << "time per sparse key-switching (microsecs)... "
        << (end - begin) / double(nb_samples) << endl;
 
+  test_out_batch = new_LweSample_array(nb_samples, in_out_params);
+  cout << "starting batched sparse key-switching..." << endl;
+  begin = clock();
+  lweSparseKeySwitchBatch(test_out_batch, keyset->cloud.bkFFT->ks, test_in,
+                          nb_samples);
+  end = clock();
+  cout << "finished " << nb_samples << " batched sparse key-switching" << endl;
+  cout << "time per batched sparse key-switching (microsecs)... "
+       << (end - begin) / double(nb_samples) << endl;
+  for (int32_t i = 0; i < nb_samples; ++i) {
+    if (test_out_batch[i].b != test_out[i].b)
+      dieDramatically("batched sparse key-switching differs");
+    for (int32_t j = 0; j < in_out_params->n; ++j)
+      if (test_out_batch[i].a[j] != test_out[i].a[j])
+        dieDramatically("batched sparse key-switching differs");
+  }
+  delete_LweSample_array(nb_samples, test_out_batch);
+
   delete_LweSample_array(nb_samples, test_out);
   delete_LweSample_array(nb_samples, test_in);
 
@@ -0,0 +1,128 @@
+#include "lwekey.h"
+#include "lweparams.h"
+#include "lwesamples.h"
+#include "polynomials.h"
+#include "tfhe.h"
+#include "tgsw.h"
+#include "tlwe.h"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/time.h>
+
+using namespace std;
+
+// **********************************************************************************
+// ********************************* MAIN
+// *******************************************
+// **********************************************************************************
+
+void dieDramatically(string message) {
+  cerr << message << endl;
+  abort();
+}
+
+double get_time_in_microsecs() {
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+/** noise and decryptions of a chain of NAND gates */
+struct NandChainStats {
+  double variance;      ///< variance of the phase of the gate outputs
+  int32_t nb_failures;  ///< number of wrong decryptions
+  double time_per_gate; ///< microseconds
+};
+
+// s[t+1] = NAND(s[t], s[t-1]): from the third gate on, both inputs of a gate
+// are bootstrapped outputs, as in a real circuit
+NandChainStats nand_chain(const int32_t nb_gates,
+                          const TFheGateBootstrappingSecretKeySet *keyset) {
+  static const Torus32 MU = modSwitchToTorus32(1, 8);
+  const LweParams *in_out_params = keyset->params->in_out_params;
+  LweSample *s = new_LweSample_array(3, in_out_params);
+  int32_t plain[3] = {rand() % 2, rand() % 2, 0};
+  bootsSymEncrypt(s + 0, plain[0], keyset);
+  bootsSymEncrypt(s + 1, plain[1], keyset);
+
+  NandChainStats stats = {0, 0, 0};
+  const double begin = get_time_in_microsecs();
+  for (int32_t t = 0; t < nb_gates; t++) {
+    LweSample *x = s + t % 3;
+    LweSample *y = s + (t + 1) % 3;
+    LweSample *r = s + (t + 2) % 3;
+    const int32_t expected = 1 - (plain[t % 3] & plain[(t + 1) % 3]);
+    bootsNAND(r, x, y, &keyset->cloud);
+    plain[(t + 2) % 3] = expected;
+
+    const Torus32 phase = lwePhase(r, keyset->lwe_key);
+    const double err = t32tod(phase - (expected ? MU : -MU));
+    stats.variance += err * err;
+    if (bootsSymDecrypt(r, keyset) != expected)
+      stats.nb_failures++;
+  }
+  stats.time_per_gate = (get_time_in_microsecs() - begin) / nb_gates;
+  stats.variance /= nb_gates;
+  delete_LweSample_array(3, s);
+  return stats;
+}
+
+// the input phase of a gate is 1/8 -/+ two outputs: it fails when their
+// noise exceeds 1/8
+double failure_rate(const NandChainStats &stats) {
+  return erfc(1. / (16. * sqrt(stats.variance)));
+}
+
+void print_stats(const string &name, const NandChainStats &stats) {
+  cout << "  " << name << ": stdev " << sqrt(stats.variance)
+       << ", estimated failure rate " << failure_rate(stats) << ", "
+       << stats.nb_failures
+       << " wrong decryptions, " << stats.time_per_gate
+       << " microsecs per gate" << endl;
+}
+
+int32_t main(int32_t argc, char **argv) {
+#ifndef NDEBUG
+  cout << "DEBUG MODE!" << endl;
+#endif
+  const int32_t nb_gates = 1000;
+  if (string(LagrangeHalfCPolynomial_layout()) == "ntt-crt") {
+    cout << "no single precision key with the ntt processor" << endl;
+    return 0;
+  }
+
+  for (int32_t sparse = 0; sparse < 2; sparse++) {
+    TFheGateBootstrappingParameterSet *params =
+        sparse ? new_sparse_gate_bootstrapping_parameters()
+               : new_default_gate_bootstrapping_parameters(110);
+    TFheGateBootstrappingSecretKeySet *keyset =
+        sparse ? new_random_sparse_bootstrapping_secret_keyset(params)
+               : new_random_gate_bootstrapping_secret_keyset(params);
+    cout << (sparse ? "sparse" : "default") << " gate parameters, "
+         << nb_gates << " NAND gates" << endl;
+
+    const NandChainStats stats64 = nand_chain(nb_gates, keyset);
+    print_stats("double key ", stats64);
+    tfhe_bootstrappingKeyFFTToFloat32(
+        (LweBootstrappingKeyFFT *)keyset->cloud.bkFFT);
+    const NandChainStats stats32 = nand_chain(nb_gates, keyset);
+    print_stats("float32 key", stats32);
+
+    if (stats64.nb_failures != 0 || stats32.nb_failures != 0)
+      dieDramatically("ERROR: wrong decryptions");
+    // the rounding of the key dominates the output noise (see
+    // tfhe_bootstrappingKeyFFTToFloat32): the default parameters measure
+    // 2^-38 against a bound of 2^-26.8, the sparse ones reach their bound
+    // (2^-24.8), so that their limit only leaves 10% of variance
+    const double max_failure_rate = sparse ? pow(2., -23) : pow(2., -30);
+    if (failure_rate(stats32) > max_failure_rate)
+      dieDramatically("ERROR: the float32 key adds too much noise");
+
+    delete_gate_bootstrapping_secret_keyset(keyset);
+    delete_gate_bootstrapping_parameters(params);
+  }
+  cout << "OK" << endl;
+  return 0;
+}
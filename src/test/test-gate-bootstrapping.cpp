@@ -3,12 +3,14 @@
 #include "lwesamples.h"
 #include "polynomials.h"
 #include "tfhe.h"
+#include "tfhe_io.h"
 #include "tgsw.h"
 #include "tlwe.h"
 #include <cmath>
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <stdio.h>
 #include <sys/time.h>
 
@@ -53,14 +55,47 @@ int32_t main(int32_t argc, char **argv) {
   TFheGateBootstrappingSecretKeySet *keyset =
       new_random_sparse_bootstrapping_secret_keyset(params);
 
+  // the parallel evaluation uses the cloud key through the mapped format
+  char mapped_name[] = "/tmp/tfhe_mapped_keyXXXXXX";
+  FILE *mapped_file = fdopen(mkstemp(mapped_name), "wb");
+  export_tfheGateBootstrappingCloudKeySet_mapped_toFile(mapped_file,
+                                                        &keyset->cloud);
+  fclose(mapped_file);
+  timeval map_begin, map_end;
+  gettimeofday(&map_begin, 0);
+  TFheGateBootstrappingCloudKeySet *mapped_cloud =
+      new_tfheGateBootstrappingCloudKeySet_mapFile(mapped_name);
+  gettimeofday(&map_end, 0);
+  remove(mapped_name);
+  cout << "time to map the cloud key (microsecs)... "
+       << (map_end.tv_sec - map_begin.tv_sec) * 1e6 +
+              (map_end.tv_usec - map_begin.tv_usec)
+       << endl;
+
+  // worker pool for the parallel evaluation (one thread per core)
+  TFheGateExecutor *executor = new_gate_executor(0);
+
   for (int32_t trial = 0; trial < nb_trials; ++trial) {
 
     // generate samples
     LweSample *test_in = new_LweSample_array(2 * nb_samples, in_out_params);
-    // generate inputs (64-->127)
-    for (int32_t i = nb_samples; i < 2 * nb_samples; ++i) {
-      bootsSymEncrypt(test_in + i, rand() % 2, keyset);
-    }
+    // generate inputs (64-->127), uploaded in seed-compressed form
+    int32_t messages[nb_samples];
+    for (int32_t i = 0; i < nb_samples; ++i)
+      messages[i] = rand() % 2;
+    TFheGateBootstrappingSeededCiphertextArray *upload =
+        new_gate_bootstrapping_seeded_ciphertext_array(nb_samples, params);
+    bootsSymEncryptSeeded(upload, messages, keyset);
+    ostringstream upload_out;
+    export_gate_bootstrapping_ciphertext_array_compressed_toStream(
+        upload_out, upload, params);
+    istringstream upload_in(upload_out.str());
+    import_gate_bootstrapping_ciphertext_array_compressed_fromStream(
+        upload_in, test_in + nb_samples, nb_samples, params);
+    for (int32_t i = 0; i < nb_samples; ++i)
+      if (bootsSymDecrypt(test_in + nb_samples + i, keyset) != messages[i])
+        dieDramatically("compressed upload differs");
+    delete_gate_bootstrapping_seeded_ciphertext_array(upload);
     // fake encrypt
     bootsSymEncrypt(test_in + 0, rand() % 2, keyset);
 
@@ -76,6 +111,33 @@ int32_t main(int32_t argc, char **argv) {
     cout << "time per bootNAND gate (microsecs)... "
          << (end - begin) / double(nb_samples - 1) << endl;
 
+    // evaluate the same NAND tree on the gate executor
+    LweSample *test_in_par = new_LweSample_array(2 * nb_samples, in_out_params);
+    for (int32_t i = nb_samples; i < 2 * nb_samples; ++i)
+      lweCopy(test_in_par + i, test_in + i, in_out_params);
+    for (int32_t i = nb_samples - 1; i > 0; --i) {
+      tfhe_gateExecutorAddBinary(executor, bootsSparseNAND, test_in_par + i,
+                                 test_in_par + (2 * i),
+                                 test_in_par + (2 * i + 1), mapped_cloud);
+    }
+    cout << "starting parallel NAND tree on "
+         << tfhe_gateExecutorNbThreads(executor) << " threads" << endl;
+    timeval wall_begin, wall_end;
+    gettimeofday(&wall_begin, 0);
+    tfhe_gateExecutorRun(executor);
+    gettimeofday(&wall_end, 0);
+    cout << "wall time per bootNAND gate (microsecs)... "
+         << ((wall_end.tv_sec - wall_begin.tv_sec) * 1e6 +
+             (wall_end.tv_usec - wall_begin.tv_usec)) /
+                double(nb_samples - 1)
+         << endl;
+    for (int32_t i = nb_samples - 1; i > 0; --i) {
+      if (bootsSymDecrypt(test_in_par + i, keyset) !=
+          bootsSymDecrypt(test_in + i, keyset))
+        dieDramatically("parallel NAND tree differs");
+    }
+    delete_LweSample_array(2 * nb_samples, test_in_par);
+
     // verification
     for (int32_t i = nb_samples - 1; i > 0; --i) {
       bool mess1 = bootsSymDecrypt(test_in + (2 * i), keyset);
@@ -94,6 +156,47 @@ int32_t main(int32_t argc, char **argv) {
     delete_LweSample_array(2 * nb_samples, test_in);
   }
 
+  // ripple carry additions of 8-bit numbers: two bootstrappings per full
+  // adder (bootsXOR3 for the sum, bootsMAJ3 for the carry)
+  const int32_t nb_bits = 8;
+  const int32_t nb_additions = 16;
+  LweSample *a = new_LweSample_array(nb_bits, in_out_params);
+  LweSample *b = new_LweSample_array(nb_bits, in_out_params);
+  LweSample *sum = new_LweSample_array(nb_bits + 1, in_out_params);
+  LweSample *carry = new_LweSample(in_out_params);
+  cout << "starting " << nb_additions << " " << nb_bits
+       << "-bit ripple carry additions" << endl;
+  clock_t adder_time = 0;
+  for (int32_t i = 0; i < nb_additions; ++i) {
+    const int32_t va = rand() % (1 << nb_bits);
+    const int32_t vb = rand() % (1 << nb_bits);
+    for (int32_t j = 0; j < nb_bits; ++j) {
+      bootsSymEncrypt(a + j, (va >> j) & 1, keyset);
+      bootsSymEncrypt(b + j, (vb >> j) & 1, keyset);
+    }
+    clock_t begin = clock();
+    bootsCONSTANT(sum + nb_bits, 0, &keyset->cloud);
+    for (int32_t j = 0; j < nb_bits; ++j) {
+      bootsXOR3(sum + j, a + j, b + j, sum + nb_bits, &keyset->cloud);
+      bootsMAJ3(carry, a + j, b + j, sum + nb_bits, &keyset->cloud);
+      lweCopy(sum + nb_bits, carry, in_out_params);
+    }
+    adder_time += clock() - begin;
+    int32_t vsum = 0;
+    for (int32_t j = 0; j <= nb_bits; ++j)
+      vsum |= bootsSymDecrypt(sum + j, keyset) << j;
+    if (vsum != va + vb)
+      cout << "ERROR!!! " << va << "+" << vb << " gives " << vsum << endl;
+  }
+  cout << "time per full adder (microsecs)... "
+       << adder_time / double(nb_additions * nb_bits) << endl;
+  delete_LweSample(carry);
+  delete_LweSample_array(nb_bits + 1, sum);
+  delete_LweSample_array(nb_bits, b);
+  delete_LweSample_array(nb_bits, a);
+
+  delete_gate_executor(executor);
+  delete_mapped_gate_bootstrapping_cloud_keyset(mapped_cloud);
   delete_gate_bootstrapping_secret_keyset(keyset);
   delete_gate_bootstrapping_parameters(params);
 
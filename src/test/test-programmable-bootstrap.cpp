@@ -0,0 +1,240 @@
+#include "lwekey.h"
+#include "lweparams.h"
+#include "lwesamples.h"
+#include "polynomials.h"
+#include "tfhe.h"
+#include "tgsw.h"
+#include "tlwe.h"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/time.h>
+
+using namespace std;
+
+// **********************************************************************************
+// ********************************* MAIN
+// *******************************************
+// **********************************************************************************
+
+void dieDramatically(string message) {
+  cerr << message << endl;
+  abort();
+}
+
+double get_time_in_microsecs() {
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+// applies the lookup table twice to random messages: the second lookup
+// takes the output of the first one, so the outputs must keep the encoding
+// (and the noise) of fresh inputs
+void test_lut(const string &name, const int32_t *table, const int32_t msize,
+              const int32_t nb_samples,
+              const TFheGateBootstrappingSecretKeySet *keyset) {
+  const LweParams *in_out_params = keyset->params->in_out_params;
+  const LweBootstrappingKeyFFT *bk = keyset->cloud.bkFFT;
+  const int32_t hw = keyset->params->hw;
+  LweSample *x = new_LweSample(in_out_params);
+  LweSample *y = new_LweSample(in_out_params);
+  LweSample *z = new_LweSample(in_out_params);
+
+  int32_t nb_failures = 0;
+  double max_error = 0;
+  const double begin = get_time_in_microsecs();
+  for (int32_t i = 0; i < nb_samples; i++) {
+    const int32_t m = rand() % msize;
+    lweSymEncrypt(x, modSwitchToTorus32(m, 2 * msize),
+                  in_out_params->alpha_min, keyset->lwe_key);
+    tfhe_sparseLutBootstrap_FFT(y, hw, bk, table, msize, x);
+    tfhe_sparseLutBootstrap_FFT(z, hw, bk, table, msize, y);
+
+    const int32_t expected[2] = {table[m], table[table[m]]};
+    const LweSample *outputs[2] = {y, z};
+    for (int32_t j = 0; j < 2; j++) {
+      const Torus32 phase = lwePhase(outputs[j], keyset->lwe_key);
+      if (modSwitchFromTorus32(phase, 2 * msize) != expected[j])
+        nb_failures++;
+      const double error =
+          fabs(t32tod(phase - modSwitchToTorus32(expected[j], 2 * msize)));
+      if (error > max_error)
+        max_error = error;
+    }
+  }
+  const double time_per_bootstrap =
+      (get_time_in_microsecs() - begin) / (2 * nb_samples);
+  cout << "  " << name << " (" << msize << " messages): " << nb_failures
+       << " wrong decryptions, max output error " << max_error
+       << " (the messages are " << 1. / (2 * msize) << " apart), "
+       << time_per_bootstrap << " microsecs per bootstrapping" << endl;
+  if (nb_failures != 0)
+    dieDramatically("ERROR: wrong lookup table outputs");
+
+  delete_LweSample(z);
+  delete_LweSample(y);
+  delete_LweSample(x);
+}
+
+// several tables of the same inputs with one blind rotation: the outputs
+// must match the tables, as with one bootstrapping per table
+void test_multi_lut(const string &name, const int32_t *tables,
+                    const int32_t nbTables, const int32_t msize,
+                    const int32_t nb_samples,
+                    const TFheGateBootstrappingSecretKeySet *keyset) {
+  const LweParams *in_out_params = keyset->params->in_out_params;
+  const LweBootstrappingKeyFFT *bk = keyset->cloud.bkFFT;
+  const int32_t hw = keyset->params->hw;
+  LweSample *x = new_LweSample(in_out_params);
+  LweSample *y = new_LweSample_array(nbTables, in_out_params);
+
+  int32_t nb_failures = 0;
+  double max_error = 0;
+  const double begin = get_time_in_microsecs();
+  for (int32_t i = 0; i < nb_samples; i++) {
+    const int32_t m = rand() % msize;
+    lweSymEncrypt(x, modSwitchToTorus32(m, 2 * msize),
+                  in_out_params->alpha_min, keyset->lwe_key);
+    tfhe_sparseMultiLutBootstrap_FFT(y, hw, bk, tables, nbTables, msize, x);
+    for (int32_t j = 0; j < nbTables; j++) {
+      const int32_t expected = tables[j * msize + m];
+      const Torus32 phase = lwePhase(y + j, keyset->lwe_key);
+      if (modSwitchFromTorus32(phase, 2 * msize) != expected)
+        nb_failures++;
+      const double error =
+          fabs(t32tod(phase - modSwitchToTorus32(expected, 2 * msize)));
+      if (error > max_error)
+        max_error = error;
+    }
+  }
+  cout << "  " << name << " (" << nbTables << " tables of " << msize
+       << " messages): " << nb_failures << " wrong decryptions, max output error "
+       << max_error << ", " << (get_time_in_microsecs() - begin) / nb_samples
+       << " microsecs per bootstrapping" << endl;
+  if (nb_failures != 0)
+    dieDramatically("ERROR: wrong multi-value lookup table outputs");
+
+  delete_LweSample_array(nbTables, y);
+  delete_LweSample(x);
+}
+
+// ripple carry additions of 8-bit numbers, with one multi-value
+// bootstrapping per full adder: the sum and the carry of a+b+c, the carry
+// going to the next full adder
+void test_ripple_carry_adder(const int32_t nb_samples,
+                             const TFheGateBootstrappingSecretKeySet *keyset) {
+  static const int32_t FULL_ADDER[2 * 4] = {0, 1, 0, 1,  // sum
+                                            0, 0, 1, 1}; // carry
+  static const int32_t nb_bits = 8;
+  const LweParams *in_out_params = keyset->params->in_out_params;
+  const LweBootstrappingKeyFFT *bk = keyset->cloud.bkFFT;
+  const int32_t hw = keyset->params->hw;
+  LweSample *a = new_LweSample_array(nb_bits, in_out_params);
+  LweSample *b = new_LweSample_array(nb_bits, in_out_params);
+  LweSample *carry = new_LweSample(in_out_params);
+  LweSample *x = new_LweSample(in_out_params);
+  LweSample *sum_carry = new_LweSample_array(2, in_out_params);
+
+  int32_t nb_failures = 0;
+  const double begin = get_time_in_microsecs();
+  for (int32_t i = 0; i < nb_samples; i++) {
+    const int32_t va = rand() % (1 << nb_bits);
+    const int32_t vb = rand() % (1 << nb_bits);
+    for (int32_t j = 0; j < nb_bits; j++) {
+      lweSymEncrypt(a + j, modSwitchToTorus32((va >> j) & 1, 8),
+                    in_out_params->alpha_min, keyset->lwe_key);
+      lweSymEncrypt(b + j, modSwitchToTorus32((vb >> j) & 1, 8),
+                    in_out_params->alpha_min, keyset->lwe_key);
+    }
+    lweNoiselessTrivial(carry, 0, in_out_params);
+    int32_t result = 0;
+    for (int32_t j = 0; j < nb_bits; j++) {
+      lweCopy(x, carry, in_out_params);
+      lweAddTo(x, a + j, in_out_params);
+      lweAddTo(x, b + j, in_out_params);
+      tfhe_sparseMultiLutBootstrap_FFT(sum_carry, hw, bk, FULL_ADDER, 2, 4, x);
+      result |= modSwitchFromTorus32(lwePhase(sum_carry, keyset->lwe_key), 8)
+                << j;
+      lweCopy(carry, sum_carry + 1, in_out_params);
+    }
+    result |= modSwitchFromTorus32(lwePhase(carry, keyset->lwe_key), 8)
+              << nb_bits;
+    if (result != va + vb)
+      nb_failures++;
+  }
+  cout << "  " << nb_bits << "-bit ripple carry adder: " << nb_failures
+       << " wrong sums, "
+       << (get_time_in_microsecs() - begin) / (nb_samples * nb_bits)
+       << " microsecs per full adder" << endl;
+  if (nb_failures != 0)
+    dieDramatically("ERROR: wrong ripple carry additions");
+
+  delete_LweSample_array(2, sum_carry);
+  delete_LweSample(x);
+  delete_LweSample(carry);
+  delete_LweSample_array(nb_bits, b);
+  delete_LweSample_array(nb_bits, a);
+}
+
+int32_t main(int32_t argc, char **argv) {
+#ifndef NDEBUG
+  cout << "DEBUG MODE!" << endl;
+#endif
+  const int32_t nb_samples = 200;
+
+  TFheGateBootstrappingParameterSet *params =
+      new_sparse_gate_bootstrapping_parameters();
+  TFheGateBootstrappingSecretKeySet *keyset =
+      new_random_sparse_bootstrapping_secret_keyset(params);
+  cout << "sparse gate parameters, " << nb_samples
+       << " chained pairs of lookups per table" << endl;
+
+  const int32_t identity[4] = {0, 1, 2, 3};
+  test_lut("identity", identity, 4, nb_samples, keyset);
+  const int32_t square[4] = {0, 1, 0, 1}; // m^2 mod 4
+  test_lut("square mod 4", square, 4, nb_samples, keyset);
+  const int32_t successor[4] = {1, 2, 3, 0};
+  test_lut("successor mod 4", successor, 4, nb_samples, keyset);
+  int32_t random_table[4];
+  for (int32_t m = 0; m < 4; m++)
+    random_table[m] = rand() % 4;
+  test_lut("random", random_table, 4, nb_samples, keyset);
+  // 3 bits: half the noise margin of 2 bits
+  const int32_t popcount[8] = {0, 1, 1, 2, 1, 2, 2, 3};
+  test_lut("popcount of 3 bits", popcount, 8, nb_samples, keyset);
+
+  const int32_t three_tables[3 * 4] = {0, 1, 2, 3,  // identity
+                                       0, 1, 0, 1,  // square mod 4
+                                       1, 2, 3, 0}; // successor mod 4
+  test_multi_lut("identity, square, successor", three_tables, 3, 4,
+                 nb_samples, keyset);
+  test_ripple_carry_adder(nb_samples / 8, keyset);
+
+  // the general form: a test vector built by the caller (here the sign
+  // function of tfhe_sparseBootstrap_FFT, on inputs +/-1/8)
+  const LweParams *in_out_params = params->in_out_params;
+  const Torus32 MU = modSwitchToTorus32(1, 8);
+  TorusPolynomial *testvect = new_TorusPolynomial(params->tgsw_params->tlwe_params->N);
+  for (int32_t j = 0; j < testvect->N; j++)
+    testvect->coefsT[j] = MU;
+  LweSample *x = new_LweSample(in_out_params);
+  LweSample *y = new_LweSample(in_out_params);
+  for (int32_t i = 0; i < nb_samples; i++) {
+    const int32_t bit = rand() % 2;
+    bootsSymEncrypt(x, bit, keyset);
+    tfhe_sparseProgrammableBootstrap_FFT(y, params->hw, keyset->cloud.bkFFT,
+                                         testvect, x);
+    if (bootsSymDecrypt(y, keyset) != bit)
+      dieDramatically("ERROR: wrong sign with a caller test vector");
+  }
+  delete_LweSample(y);
+  delete_LweSample(x);
+  delete_TorusPolynomial(testvect);
+
+  delete_gate_bootstrapping_secret_keyset(keyset);
+  delete_gate_bootstrapping_parameters(params);
+  cout << "OK" << endl;
+  return 0;
+}
@@ -68,6 +68,8 @@ namespace {
 
         USE_FAKE_IntPolynomial_ifft;
 
+        USE_FAKE_IntPolynomial_ifft_batch;
+
         USE_FAKE_tLweFFTAddMulRTo;
 
         //this function generates a totally random fake integer decomposition, using just the address
@@ -285,7 +287,7 @@ namespace {
             delete_TLweSample(accum);
         }
     }
-    //EXPORT void tGswFFTMulByXaiMinusOne(TGswSampleFFT* result, const int32_t ai, const TGswSampleFFT* bki, const TGswParams* params);
+    //EXPORT void tGswFFTMulByXaiMinusOne(TGswSampleFFT* result, const int32_t ai, const TGswSampleFFT* bki, const TGswParams* params, LagrangeHalfCPolynomial* xaim1);
     TEST_F(TGswFFTTest, tGswFFTMulByXaiMinusOne) {
         //TODO: A supprimer
     }